@@ -0,0 +1,70 @@
+%define SYSCALL_DISPATCH _ZN6kernel17SyscallDispatcher8dispatchEPNS_13RegisterStateE
+extern SYSCALL_DISPATCH
+
+%include "Common.inc"
+
+; GDT::userland_{data,code}_selector() | 3
+%define USERLAND_DATA_SELECTOR 0x1B
+%define USERLAND_CODE_SELECTOR 0x23
+
+; See Multitasking/TSS.h
+%define TSS_KERNEL_STACK_POINTER 4
+%define TSS_SYSCALL_SCRATCH      20
+
+; See Core/Registers.h
+%define REGISTER_STATE_R11    32
+%define REGISTER_STATE_RCX    96
+%define REGISTER_STATE_RIP    136
+%define REGISTER_STATE_RFLAGS 152
+
+section .text
+
+; SYSCALL leaves the return address in RCX and RFLAGS in R11,
+; interrupts are masked via IA32_FMASK until we're off the userland stack with GS swapped back.
+global syscall_entry
+syscall_entry:
+    swapgs
+    mov [gs:TSS_SYSCALL_SCRATCH], rsp
+    mov rsp, [gs:TSS_KERNEL_STACK_POINTER]
+
+    ; build the same frame int 0x80 would
+    push qword USERLAND_DATA_SELECTOR   ; ss
+    push qword [gs:TSS_SYSCALL_SCRATCH] ; rsp
+    swapgs
+    push r11                            ; rflags
+    push qword USERLAND_CODE_SELECTOR   ; cs
+    push rcx                            ; rip
+    push qword 0                        ; error_code
+    push qword 0x80                     ; interrupt_number
+    pushaq
+
+    ; RCX is taken by SYSCALL, the second argument comes in R10
+    mov [rsp + REGISTER_STATE_RCX], r10
+
+    ; int 0x80 is a trap gate, the syscall must stay preemptible here as well
+    sti
+
+    mov rdi, rsp
+    cld
+    call SYSCALL_DISPATCH
+
+    cli
+
+    ; SYSRET faults in ring 0 if RIP is non-canonical, let iretq take care of that
+    mov rcx, [rsp + REGISTER_STATE_RIP]
+    mov r11, rcx
+    sar r11, 47
+    jnz .return_via_iret
+
+    mov [rsp + REGISTER_STATE_RCX], rcx
+    mov r11, [rsp + REGISTER_STATE_RFLAGS]
+    mov [rsp + REGISTER_STATE_R11], r11
+
+    popaq
+    mov rsp, [rsp + 0x28] ; skip interrupt_number, error_code, rip, cs, rflags
+    o64 sysret
+
+.return_via_iret:
+    popaq
+    add rsp, 0x10
+    iretq
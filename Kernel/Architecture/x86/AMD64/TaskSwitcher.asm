@@ -5,6 +5,9 @@
 %define schedule    _ZN6kernel9Scheduler8scheduleEPKNS_13RegisterStateE
 extern  schedule
 
+%define finish_switch _ZN6kernel9Scheduler13finish_switchEv
+extern  finish_switch
+
 %include "Common.inc"
 
 section .text
@@ -14,6 +17,12 @@ switch_task:
     ; load the new task rsp
     mov rsp, [rdi]
 
+    ; the previous task is off its stack now, rbx is restored by popaq below
+    mov rbx, rsp
+    and rsp, ~0xF
+    call finish_switch
+    mov rsp, rbx
+
     popaq
     add rsp, 0x10
     iretq
@@ -0,0 +1,100 @@
+%define SYSCALL_DISPATCH _ZN6kernel17SyscallDispatcher8dispatchEPNS_13RegisterStateE
+extern SYSCALL_DISPATCH
+
+; GDT::userland_{code,data}_selector() | 3
+%define USERLAND_CODE_SELECTOR 0x1B
+%define USERLAND_DATA_SELECTOR 0x23
+
+%define KERNEL_DATA_SELECTOR 0x10
+
+; See Multitasking/TSS.h
+%define TSS_KERNEL_STACK_POINTER 4
+
+; See Core/Registers.h
+%define REGISTER_STATE_EDI           20
+%define REGISTER_STATE_ESI           24
+%define REGISTER_STATE_EDX           40
+%define REGISTER_STATE_ECX           44
+%define REGISTER_STATE_EIP           60
+%define REGISTER_STATE_USERSPACE_ESP 72
+
+%define EFLAGS_TRAP       0x100
+%define EFLAGS_INTERRUPTS 0x200
+
+section .text
+
+; IA32_SYSENTER_ESP points at the trampoline stack of this processor, the address of its TSS sits right above it.
+; Userland passes its stack pointer in ECX and the return address in EDX.
+global sysenter_entry
+sysenter_entry:
+    ; SYSENTER only clears IF, a userland TF, NT or AC would follow us into the kernel otherwise
+    pushfd
+    push dword 0x2
+    popfd
+
+; A single step trap can hit anywhere up to here, see SyscallDispatcher::is_sysenter_single_step
+global sysenter_entry_flags_cleared
+sysenter_entry_flags_cleared:
+    ; trampoline: [ebx] = userland ebx, [ebx + 4] = userland eflags, [ebx + 8] = TSS
+    push ebx
+    mov ebx, esp
+    mov esp, [ebx + 8]
+    mov esp, [esp + TSS_KERNEL_STACK_POINTER]
+
+    ; build the same frame int 0x80 would
+    push dword USERLAND_DATA_SELECTOR ; userspace_ss
+    push ecx                          ; userspace_esp
+    push dword [ebx + 4]              ; eflags
+    or dword [esp], EFLAGS_INTERRUPTS ; masked by SYSENTER, but always set in userland
+    push dword USERLAND_CODE_SELECTOR ; cs
+    push edx                          ; eip
+    push dword 0                      ; error_code
+    push dword 0x80                   ; interrupt_number
+    mov ebx, [ebx]
+    pusha
+    push ds
+    push es
+    push fs
+    push gs
+    push ss
+    mov ax, KERNEL_DATA_SELECTOR
+    mov ds, ax
+    mov es, ax
+
+    ; ECX and EDX are taken by SYSENTER, the second and third arguments come in ESI and EDI
+    mov eax, [esp + REGISTER_STATE_ESI]
+    mov [esp + REGISTER_STATE_ECX], eax
+    mov eax, [esp + REGISTER_STATE_EDI]
+    mov [esp + REGISTER_STATE_EDX], eax
+
+    ; int 0x80 is a trap gate, the syscall must stay preemptible here as well
+    sti
+
+    push esp
+    cld
+    call SYSCALL_DISPATCH
+    pop eax
+
+    cli
+
+    ; SYSEXIT takes the return address from EDX and the stack pointer from ECX
+    mov ecx, [eax + REGISTER_STATE_EIP]
+    mov [eax + REGISTER_STATE_EDX], ecx
+    mov ecx, [eax + REGISTER_STATE_USERSPACE_ESP]
+    mov [eax + REGISTER_STATE_ECX], ecx
+
+    add esp, 0x4 ; ss
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popa
+    add esp, 0x8 ; interrupt_number, error_code
+
+    ; Restore the userland flags but keep interrupts off until SYSEXIT has completed,
+    ; STI only takes effect after the next instruction.
+    and dword [esp + 0x8], ~(EFLAGS_INTERRUPTS | EFLAGS_TRAP)
+    push dword [esp + 0x8]
+    popfd
+    sti
+    sysexit
@@ -5,6 +5,9 @@
 %define schedule    _ZN6kernel9Scheduler8scheduleEPKNS_13RegisterStateE
 extern  schedule
 
+%define finish_switch _ZN6kernel9Scheduler13finish_switchEv
+extern  finish_switch
+
 section .text
 ; void Scheduler::switch_task(Thread::ControlBlock* new_task)
 global switch_task
@@ -13,6 +16,12 @@ switch_task:
     mov esi, [esp + 4]
     mov esp, [esi]
 
+    ; the previous task is off its stack now, ebx is restored by popa below
+    mov ebx, esp
+    and esp, ~0xF
+    call finish_switch
+    mov esp, ebx
+
     add esp, 4 ; skip ss
     pop gs
     pop fs
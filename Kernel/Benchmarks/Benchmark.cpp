@@ -0,0 +1,38 @@
+#include "Common/Logger.h"
+
+#include "Benchmark.h"
+#include "MemoryBenchmark.h"
+#include "SchedulerBenchmark.h"
+
+namespace kernel {
+
+static const Benchmark::Entry s_benchmarks[] = {
+    { "sched-yield"_sv, "yield throughput & context switches per core"_sv, &SchedulerBenchmark::yield },
+    { "sched-latency"_sv, "wake-up latency of a sleeping thread under CPU load"_sv, &SchedulerBenchmark::wakeup_latency },
+    { "sched-switch"_sv, "context switch cost with lazy FPU switching"_sv, &SchedulerBenchmark::context_switch },
+    { "sched-spawn"_sv, "thread creation & exit round trip with kernel stack/FPU state caching"_sv, &SchedulerBenchmark::spawn },
+    { "mm-fault"_sv, "demand paging fault throughput with a thread per core"_sv, &MemoryBenchmark::page_faults },
+};
+
+Span<const Benchmark::Entry> Benchmark::all()
+{
+    return s_benchmarks;
+}
+
+bool Benchmark::run(StringView name, String& report)
+{
+    for (auto& benchmark : all()) {
+        if (benchmark.name != name)
+            continue;
+
+        log("Benchmark") << "running \"" << name << "\"...";
+        benchmark.run(report);
+        log("Benchmark") << "\"" << name << "\" results:\n"
+                         << report.to_view();
+
+        return true;
+    }
+
+    return false;
+}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Common/Macros.h"
+#include "Common/String.h"
+#include "Common/Span.h"
+
+namespace kernel {
+
+// In-kernel micro benchmarks, runnable via the "bench" command of the demo terminal.
+class Benchmark {
+    MAKE_STATIC(Benchmark);
+
+public:
+    using Runner = void (*)(String& report);
+
+    struct Entry {
+        StringView name;
+        StringView description;
+        Runner run;
+    };
+
+    static Span<const Entry> all();
+
+    // Returns false if there's no benchmark with this name
+    static bool run(StringView name, String& report);
+};
+}
@@ -0,0 +1,100 @@
+#include "Core/CPU.h"
+
+#include "Memory/MemoryManager.h"
+#include "Memory/PhysicalPageCache.h"
+
+#include "Multitasking/Process.h"
+#include "Multitasking/Scheduler.h"
+#include "Multitasking/Sleep.h"
+
+#include "MemoryBenchmark.h"
+
+namespace kernel {
+
+Atomic<size_t> MemoryBenchmark::s_ready_threads;
+Atomic<bool> MemoryBenchmark::s_go;
+Atomic<size_t> MemoryBenchmark::s_finished_threads;
+Atomic<u64> MemoryBenchmark::s_total_fault_time;
+
+void MemoryBenchmark::fault_worker()
+{
+    s_ready_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    while (!s_go.load(MemoryOrder::ACQUIRE))
+        Scheduler::the().yield();
+
+    u64 fault_time = 0;
+
+    for (size_t round = 0; round < rounds; ++round) {
+        auto region = MemoryManager::the().allocate_kernel_private_anywhere("mm-fault bench"_sv, region_size);
+        auto* bytes = region->virtual_range().begin().as_pointer<volatile u8>();
+
+        auto start = Timer::nanoseconds_since_boot();
+
+        for (size_t offset = 0; offset < region_size; offset += Page::size)
+            bytes[offset] = 1;
+
+        fault_time += Timer::nanoseconds_since_boot() - start;
+
+        MemoryManager::the().free_virtual_region(*region);
+    }
+
+    s_total_fault_time.fetch_add(fault_time, MemoryOrder::ACQ_REL);
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void MemoryBenchmark::collect_page_cache_stats(size_t& refills, size_t& drains)
+{
+    refills = 0;
+    drains = 0;
+
+    for (auto& processor : CPU::processors()) {
+        refills += processor.physical_page_cache().refills();
+        drains += processor.physical_page_cache().drains();
+    }
+}
+
+void MemoryBenchmark::page_faults(String& report)
+{
+    size_t refills_before, drains_before;
+    collect_page_cache_stats(refills_before, drains_before);
+
+    auto thread_count = CPU::alive_processor_count();
+
+    s_ready_threads.store(0, MemoryOrder::RELEASE);
+    s_go.store(false, MemoryOrder::RELEASE);
+    s_finished_threads.store(0, MemoryOrder::RELEASE);
+    s_total_fault_time.store(0, MemoryOrder::RELEASE);
+
+    auto process = Process::create_supervisor(&MemoryBenchmark::fault_worker, "mm-fault bench"_sv);
+    for (size_t i = 1; i < thread_count; ++i) {
+        if (process->create_thread(&MemoryBenchmark::fault_worker).is_error())
+            thread_count = i;
+    }
+
+    while (s_ready_threads.load(MemoryOrder::ACQUIRE) != thread_count)
+        sleep::for_milliseconds(1);
+
+    auto start = Timer::nanoseconds_since_boot();
+    s_go.store(true, MemoryOrder::RELEASE);
+
+    while (s_finished_threads.load(MemoryOrder::ACQUIRE) != thread_count)
+        sleep::for_milliseconds(1);
+
+    auto elapsed = Timer::nanoseconds_since_boot() - start;
+
+    size_t refills_after, drains_after;
+    collect_page_cache_stats(refills_after, drains_after);
+
+    u64 faults = thread_count * rounds * (region_size / Page::size);
+    auto total_fault_time = s_total_fault_time.load(MemoryOrder::ACQUIRE);
+
+    report << "threads: " << thread_count << ", " << faults << " faults in " << elapsed / Time::nanoseconds_in_millisecond << " ms\n"
+           << "throughput: " << (elapsed ? faults * Time::nanoseconds_in_second / elapsed : 0) << " faults/s, "
+           << (faults ? total_fault_time / faults : 0) << " ns per fault\n"
+           << "page caches: " << refills_after - refills_before << " refills, "
+           << drains_after - drains_before << " drains\n";
+}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Macros.h"
+#include "Common/String.h"
+
+namespace kernel {
+
+class MemoryBenchmark {
+    MAKE_STATIC(MemoryBenchmark);
+
+public:
+    // Has a thread per core touch every page of its own demand paged kernel region, all at the same time.
+    // Reports the combined page fault throughput along with how often the per-processor page caches
+    // had to go to the physical regions.
+    static void page_faults(String& report);
+
+private:
+    [[noreturn]] static void fault_worker();
+
+    static void collect_page_cache_stats(size_t& refills, size_t& drains);
+
+    static constexpr size_t rounds = 4;
+    static constexpr size_t region_size = 4 * MB;
+
+    static Atomic<size_t> s_ready_threads;
+    static Atomic<bool> s_go;
+    static Atomic<size_t> s_finished_threads;
+    static Atomic<u64> s_total_fault_time;
+};
+}
@@ -0,0 +1,297 @@
+#include "Core/CPU.h"
+#include "Core/FPU.h"
+
+#include "Multitasking/Process.h"
+#include "Multitasking/Scheduler.h"
+#include "Multitasking/Sleep.h"
+#include "Multitasking/ThreadResourceCache.h"
+
+#include "SchedulerBenchmark.h"
+
+namespace kernel {
+
+Atomic<u64> SchedulerBenchmark::s_deadline;
+Atomic<size_t> SchedulerBenchmark::s_yields;
+Atomic<size_t> SchedulerBenchmark::s_finished_threads;
+
+Atomic<bool> SchedulerBenchmark::s_stop_hogs;
+Atomic<u64> SchedulerBenchmark::s_total_latency;
+Atomic<u64> SchedulerBenchmark::s_max_latency;
+
+Atomic<bool> SchedulerBenchmark::s_touch_fpu;
+
+Atomic<size_t> SchedulerBenchmark::s_spawned_exits;
+Atomic<size_t> SchedulerBenchmark::s_spawn_rounds;
+Atomic<u64> SchedulerBenchmark::s_total_spawn_time;
+
+void SchedulerBenchmark::yield_worker()
+{
+    size_t yields = 0;
+
+    while (Timer::nanoseconds_since_boot() < s_deadline.load(MemoryOrder::ACQUIRE)) {
+        Scheduler::the().yield();
+        ++yields;
+    }
+
+    s_yields.fetch_add(yields, MemoryOrder::ACQ_REL);
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::hog_worker()
+{
+    while (!s_stop_hogs.load(MemoryOrder::ACQUIRE))
+        pause();
+
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::latency_probe()
+{
+    u64 total_latency = 0;
+    u64 max_latency = 0;
+
+    for (size_t i = 0; i < latency_samples; ++i) {
+        auto wake_time = Timer::nanoseconds_since_boot() + latency_probe_period_in_milliseconds * Time::nanoseconds_in_millisecond;
+        sleep::until(wake_time);
+
+        auto latency = Timer::nanoseconds_since_boot() - wake_time;
+        total_latency += latency;
+        max_latency = max(max_latency, latency);
+    }
+
+    s_total_latency.store(total_latency, MemoryOrder::RELEASE);
+    s_max_latency.store(max_latency, MemoryOrder::RELEASE);
+    s_stop_hogs.store(true, MemoryOrder::RELEASE);
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::switch_worker()
+{
+    Thread::current()->allocate_fpu_state();
+
+    bool touch_fpu = s_touch_fpu.load(MemoryOrder::ACQUIRE);
+    size_t yields = 0;
+
+    while (Timer::nanoseconds_since_boot() < s_deadline.load(MemoryOrder::ACQUIRE)) {
+        // The kernel is built without SSE, so dirty the x87 state by hand
+        if (touch_fpu)
+            asm volatile("fldz\n"
+                         "fstp %%st(0)" ::
+                             : "memory");
+
+        Scheduler::the().yield();
+        ++yields;
+    }
+
+    s_yields.fetch_add(yields, MemoryOrder::ACQ_REL);
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::spawn_worker()
+{
+    Thread::current()->allocate_fpu_state();
+    s_spawned_exits.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::spawner()
+{
+    auto& process = Thread::current()->owner();
+    u64 total_time = 0;
+    size_t rounds = 0;
+
+    for (; rounds < spawn_rounds; ++rounds) {
+        auto start = Timer::nanoseconds_since_boot();
+
+        if (process.create_thread(&SchedulerBenchmark::spawn_worker).is_error())
+            break;
+
+        while (s_spawned_exits.load(MemoryOrder::ACQUIRE) != rounds + 1)
+            Scheduler::the().yield();
+
+        total_time += Timer::nanoseconds_since_boot() - start;
+    }
+
+    s_total_spawn_time.store(total_time, MemoryOrder::RELEASE);
+    s_spawn_rounds.store(rounds, MemoryOrder::RELEASE);
+    s_finished_threads.fetch_add(1, MemoryOrder::ACQ_REL);
+
+    Scheduler::the().exit_thread(0);
+}
+
+void SchedulerBenchmark::collect_thread_resource_cache_stats(size_t& hits, size_t& misses)
+{
+    hits = 0;
+    misses = 0;
+
+    for (auto& processor : CPU::processors()) {
+        hits += processor.thread_resource_cache().hits();
+        misses += processor.thread_resource_cache().misses();
+    }
+}
+
+void SchedulerBenchmark::wait_for_threads(size_t count)
+{
+    while (s_finished_threads.load(MemoryOrder::ACQUIRE) != count)
+        sleep::for_milliseconds(10);
+}
+
+void SchedulerBenchmark::run_latency_pass(PriorityClass probe_class, String& report)
+{
+    s_finished_threads.store(0, MemoryOrder::RELEASE);
+    s_stop_hogs.store(false, MemoryOrder::RELEASE);
+
+    auto hog_count = CPU::alive_processor_count() * threads_per_processor;
+
+    auto hogs = Process::create_supervisor(&SchedulerBenchmark::hog_worker, "sched-latency hogs"_sv);
+    for (size_t i = 1; i < hog_count; ++i) {
+        if (hogs->create_thread(&SchedulerBenchmark::hog_worker).is_error())
+            hog_count = i;
+    }
+
+    auto probe = Process::create_supervisor(&SchedulerBenchmark::latency_probe, "sched-latency probe"_sv);
+    probe->set_priority_class(probe_class);
+
+    wait_for_threads(hog_count + 1);
+
+    auto average_latency = s_total_latency.load(MemoryOrder::ACQUIRE) / latency_samples;
+    auto max_latency = s_max_latency.load(MemoryOrder::ACQUIRE);
+
+    report << (probe_class == PriorityClass::INTERACTIVE ? "interactive" : "normal") << " probe vs "
+           << hog_count << " hogs: avg " << average_latency / Time::nanoseconds_in_microsecond << " us, max "
+           << max_latency / Time::nanoseconds_in_microsecond << " us\n";
+}
+
+void SchedulerBenchmark::wakeup_latency(String& report)
+{
+    report << "wake-up latency over " << latency_samples << " sleeps of "
+           << latency_probe_period_in_milliseconds << " ms\n";
+
+    run_latency_pass(PriorityClass::NORMAL, report);
+    run_latency_pass(PriorityClass::INTERACTIVE, report);
+}
+
+void SchedulerBenchmark::run_switch_pass(bool touch_fpu, String& report)
+{
+    auto before = Scheduler::the().stats().run_queues;
+    auto lazy_restores_before = FPU::lazy_restores();
+
+    auto thread_count = CPU::alive_processor_count() * threads_per_processor;
+
+    s_yields.store(0, MemoryOrder::RELEASE);
+    s_finished_threads.store(0, MemoryOrder::RELEASE);
+    s_touch_fpu.store(touch_fpu, MemoryOrder::RELEASE);
+    s_deadline.store(Timer::nanoseconds_since_boot() + duration_in_milliseconds * Time::nanoseconds_in_millisecond, MemoryOrder::RELEASE);
+
+    auto start = Timer::nanoseconds_since_boot();
+
+    auto process = Process::create_supervisor(&SchedulerBenchmark::switch_worker, "sched-switch bench"_sv);
+    for (size_t i = 1; i < thread_count; ++i) {
+        if (process->create_thread(&SchedulerBenchmark::switch_worker).is_error())
+            thread_count = i;
+    }
+
+    wait_for_threads(thread_count);
+
+    auto elapsed = Timer::nanoseconds_since_boot() - start;
+    auto after = Scheduler::the().stats().run_queues;
+
+    ASSERT(before.size() == after.size());
+
+    u64 switches = 0;
+    for (size_t i = 0; i < after.size(); ++i)
+        switches += after[i].context_switches - before[i].context_switches;
+
+    // Every core was busy switching for the entire duration
+    auto busy_time = elapsed * CPU::alive_processor_count();
+
+    report << (touch_fpu ? "fpu used" : "fpu unused") << ": " << switches << " switches, "
+           << (switches ? busy_time / switches : 0) << " ns per switch, "
+           << FPU::lazy_restores() - lazy_restores_before << " lazy fpu restores\n";
+}
+
+void SchedulerBenchmark::context_switch(String& report)
+{
+    report << "threads: " << CPU::alive_processor_count() * threads_per_processor << " on "
+           << CPU::alive_processor_count() << " cores, " << duration_in_milliseconds << " ms per pass\n";
+
+    run_switch_pass(false, report);
+    run_switch_pass(true, report);
+}
+
+void SchedulerBenchmark::yield(String& report)
+{
+    auto before = Scheduler::the().stats().run_queues;
+
+    auto thread_count = CPU::alive_processor_count() * threads_per_processor;
+
+    s_yields.store(0, MemoryOrder::RELEASE);
+    s_finished_threads.store(0, MemoryOrder::RELEASE);
+    s_deadline.store(Timer::nanoseconds_since_boot() + duration_in_milliseconds * Time::nanoseconds_in_millisecond, MemoryOrder::RELEASE);
+
+    auto start = Timer::nanoseconds_since_boot();
+
+    auto process = Process::create_supervisor(&SchedulerBenchmark::yield_worker, "sched-yield bench"_sv);
+    for (size_t i = 1; i < thread_count; ++i) {
+        if (process->create_thread(&SchedulerBenchmark::yield_worker).is_error())
+            thread_count = i;
+    }
+
+    wait_for_threads(thread_count);
+
+    auto elapsed = Timer::nanoseconds_since_boot() - start;
+    auto after = Scheduler::the().stats().run_queues;
+
+    auto per_second = [elapsed](size_t count) -> u64 {
+        return (static_cast<u64>(count) * Time::nanoseconds_in_second) / elapsed;
+    };
+
+    auto yields = s_yields.load(MemoryOrder::ACQUIRE);
+
+    report << "threads: " << thread_count << " on " << CPU::alive_processor_count() << " cores\n";
+    report << "elapsed: " << elapsed / Time::nanoseconds_in_millisecond << " ms\n";
+    report << "yields: " << yields << " (" << per_second(yields) << "/s)\n";
+
+    ASSERT(before.size() == after.size());
+
+    for (size_t i = 0; i < after.size(); ++i) {
+        auto switches = after[i].context_switches - before[i].context_switches;
+        auto stolen = after[i].stolen_threads - before[i].stolen_threads;
+
+        report << "cpu " << after[i].processor_id << ": " << per_second(switches) << " switches/s, "
+               << stolen << " stolen\n";
+    }
+}
+
+void SchedulerBenchmark::spawn(String& report)
+{
+    size_t hits_before, misses_before;
+    collect_thread_resource_cache_stats(hits_before, misses_before);
+
+    s_finished_threads.store(0, MemoryOrder::RELEASE);
+    s_spawned_exits.store(0, MemoryOrder::RELEASE);
+
+    Process::create_supervisor(&SchedulerBenchmark::spawner, "sched-spawn bench"_sv);
+    wait_for_threads(1);
+
+    size_t hits_after, misses_after;
+    collect_thread_resource_cache_stats(hits_after, misses_after);
+
+    auto rounds = s_spawn_rounds.load(MemoryOrder::ACQUIRE);
+    auto total_time = s_total_spawn_time.load(MemoryOrder::ACQUIRE);
+
+    report << rounds << " threads spawned & joined one at a time: "
+           << (rounds ? total_time / rounds / Time::nanoseconds_in_microsecond : 0) << " us per thread\n"
+           << "thread resource cache: " << hits_after - hits_before << " hits, "
+           << misses_after - misses_before << " misses\n";
+}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Macros.h"
+#include "Common/String.h"
+
+#include "Multitasking/Thread.h"
+
+namespace kernel {
+
+class SchedulerBenchmark {
+    MAKE_STATIC(SchedulerBenchmark);
+
+public:
+    // Spawns a few threads per core that do nothing but yield for a fixed amount of time.
+    static void yield(String& report);
+
+    // Measures how late a periodically sleeping thread gets to run while every core is kept busy
+    // by CPU hogs, once with the probe being in the same priority class as the hogs and once as interactive.
+    static void wakeup_latency(String& report);
+
+    // Measures the average cost of a context switch between threads that own an FPU state,
+    // once with the threads never touching the FPU and once with them using it every time slice.
+    static void context_switch(String& report);
+
+    // Measures the round trip of creating a thread and waiting for it to exit, one thread at a time,
+    // along with how often its kernel stack and FPU state came from the per-processor cache.
+    static void spawn(String& report);
+
+private:
+    [[noreturn]] static void yield_worker();
+    [[noreturn]] static void hog_worker();
+    [[noreturn]] static void latency_probe();
+    [[noreturn]] static void switch_worker();
+    [[noreturn]] static void spawn_worker();
+    [[noreturn]] static void spawner();
+
+    static void run_latency_pass(PriorityClass probe_class, String& report);
+    static void run_switch_pass(bool touch_fpu, String& report);
+    static void wait_for_threads(size_t count);
+    static void collect_thread_resource_cache_stats(size_t& hits, size_t& misses);
+
+    static constexpr size_t threads_per_processor = 2;
+    static constexpr u64 duration_in_milliseconds = 2000;
+
+    static constexpr size_t latency_samples = 100;
+    static constexpr u64 latency_probe_period_in_milliseconds = 5;
+
+    static constexpr size_t spawn_rounds = 1000;
+
+    static Atomic<u64> s_deadline;
+    static Atomic<size_t> s_yields;
+    static Atomic<size_t> s_finished_threads;
+
+    static Atomic<bool> s_stop_hogs;
+    static Atomic<u64> s_total_latency;
+    static Atomic<u64> s_max_latency;
+
+    static Atomic<bool> s_touch_fpu;
+
+    static Atomic<size_t> s_spawned_exits;
+    static Atomic<size_t> s_spawn_rounds;
+    static Atomic<u64> s_total_spawn_time;
+};
+}
@@ -37,6 +37,11 @@ public:
         return __atomic_load_n(&m_value, static_cast<order_t>(order));
     }
 
+    T exchange(T value, MemoryOrder order) volatile ALWAYS_INLINE
+    {
+        return __atomic_exchange_n(&m_value, value, static_cast<order_t>(order));
+    }
+
     bool compare_and_exchange(T* expected, T value) volatile ALWAYS_INLINE
     {
         return __atomic_compare_exchange_n(
@@ -58,6 +63,16 @@ public:
         return __atomic_fetch_sub(&m_value, value, static_cast<order_t>(order));
     }
 
+    T fetch_or(T value, MemoryOrder order) volatile ALWAYS_INLINE
+    {
+        return __atomic_fetch_or(&m_value, value, static_cast<order_t>(order));
+    }
+
+    T fetch_and(T value, MemoryOrder order) volatile ALWAYS_INLINE
+    {
+        return __atomic_fetch_and(&m_value, value, static_cast<order_t>(order));
+    }
+
 private:
     T m_value { 0 };
 };
@@ -3,6 +3,7 @@
 #include "Common/Traits.h"
 #include "Common/Utilities.h"
 #include "Core/Runtime.h"
+#include "Memory/SlabAllocated.h"
 
 namespace kernel {
 
@@ -42,6 +43,8 @@ public:
 
     class Node final : public NodeBase {
     public:
+        MAKE_SLAB_ALLOCATED(Node)
+
         template <typename U>
         Node(U&& value, NodeBase* previous = nullptr, NodeBase* next = nullptr)
             : NodeBase(previous, next)
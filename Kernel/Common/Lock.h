@@ -1,8 +1,16 @@
 #pragma once
 
 #include "Atomic.h"
+#include "Core/LockProfiler.h"
 #include "Interrupts/Utilities.h"
 
+// How much every spin lock acquisition remembers for the deadlock report:
+// 0 - only the owner CPU, 1 - also the acquisition site, 2 - also a backtrace of the acquirer.
+// Level 2 walks the stack on every acquisition, so it should only be used to track down deadlocks.
+#ifndef ULTRA_LOCK_DEBUG_LEVEL
+#define ULTRA_LOCK_DEBUG_LEVEL 0
+#endif
+
 namespace kernel {
 
 class DeadlockWatcher {
@@ -15,17 +23,43 @@ public:
     }
 
 protected:
-    void did_acquire_lock(StringView file, size_t line, size_t core_id) ALWAYS_INLINE
+    // spins is the number of failed attempts before this one, wait_start the TSC value of the first of them.
+    void did_acquire_lock(const char* file, size_t line, size_t core_id, size_t spins = 0, u64 wait_start = 0) ALWAYS_INLINE
     {
         m_acquire_attempts = 0;
+        m_core = core_id;
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 1
         m_file = file;
         m_line = line;
-        m_core = core_id;
+#endif
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 2
         m_backtrace_frames = runtime::dump_backtrace(m_backtrace, max_watcher_depth);
+#endif
+
+        if (LockProfiler::is_enabled()) {
+            m_acquired_at = CPU::read_tsc();
+            m_site = LockProfiler::did_acquire(file, line, spins, wait_start, m_acquired_at);
+        }
     }
 
-    void did_fail_to_acquire() ALWAYS_INLINE
+    void will_release_lock() ALWAYS_INLINE
     {
+        auto* site = m_site;
+
+        if (!site)
+            return;
+
+        m_site = nullptr;
+        LockProfiler::did_release(*site, m_acquired_at);
+    }
+
+    void did_fail_to_acquire(size_t& spins, u64& wait_start) ALWAYS_INLINE
+    {
+        if (spins++ == 0 && LockProfiler::is_enabled())
+            wait_start = CPU::read_tsc();
+
         ++m_acquire_attempts;
 
         if (m_acquire_attempts >= max_acquire_attempts)
@@ -39,17 +73,26 @@ private:
         if (HeapAllocator::is_deadlocked()) {
             StackString error_string;
             error_string << "HeapAllocator deadlock on cpu " << CPU::current_id()
-                         << "! Last acquired on cpu " << m_core
-                         << " at " << m_file << ":" << m_line;
+                         << "! Last acquired on cpu " << m_core;
+#if ULTRA_LOCK_DEBUG_LEVEL >= 1
+            error_string << " at " << m_file << ":" << m_line;
+#endif
             runtime::panic(error_string.data());
         }
 
         String deadlock_message;
 
         deadlock_message << "Deadlock on cpu " << CPU::current_id()
-                         << "! Last acquired by cpu " << m_core
-                         << " at " << m_file << ":" << m_line
-                         << "\nLast acquirer backtrace:\n";
+                         << "! Last acquired by cpu " << m_core;
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 1
+        deadlock_message << " at " << m_file << ":" << m_line;
+#else
+        deadlock_message << " (build with ULTRA_LOCK_DEBUG_LEVEL >= 1 to see where)";
+#endif
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 2
+        deadlock_message << "\nLast acquirer backtrace:\n";
 
         if (m_backtrace_frames == 0)
             deadlock_message << "No backtrace information (possible stack corruption)";
@@ -60,19 +103,29 @@ private:
 
             deadlock_message << "Frame " << i << ": " << Address(m_backtrace[i]) << " in " << name << "\n";
         }
+#endif
 
         runtime::panic(deadlock_message.c_string());
     }
 
 private:
     size_t m_acquire_attempts { 0 };
+    size_t m_core { 0 };
 
-    static constexpr size_t max_watcher_depth = 4;
+    // Only set if the lock was acquired while the lock profiler was enabled
+    LockSite* m_site { nullptr };
+    u64 m_acquired_at { 0 };
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 1
     StringView m_file;
     size_t m_line { 0 };
-    size_t m_core { 0 };
+#endif
+
+#if ULTRA_LOCK_DEBUG_LEVEL >= 2
+    static constexpr size_t max_watcher_depth = 4;
     size_t m_backtrace_frames { 0 };
     ptr_t m_backtrace[max_watcher_depth];
+#endif
 };
 
 class SharedSpinLock : public DeadlockWatcher {
@@ -93,6 +146,8 @@ public:
 
     void exclusive_unlock() ALWAYS_INLINE
     {
+        will_release_lock();
+
         auto expected = exclusive;
         bool result = m_lock.compare_and_exchange(&expected, unlocked);
 
@@ -117,9 +172,11 @@ protected:
             file = "<unspecified>";
 
         lock_t expected = unlocked;
+        size_t spins = 0;
+        u64 wait_start = 0;
 
         while (!m_lock.compare_and_exchange(&expected, exclusive)) {
-            did_fail_to_acquire();
+            did_fail_to_acquire(spins, wait_start);
 
             // Service IPIs/IRQs/whatever while waiting
             if (service_interrupts) {
@@ -131,16 +188,18 @@ protected:
             pause();
         }
 
-        did_acquire_lock(file, line, core_id);
+        did_acquire_lock(file, line, core_id, spins, wait_start);
     }
 
     void do_shared_lock(bool service_interrupts) ALWAYS_INLINE
     {
         lock_t expected = unlocked;
+        size_t spins = 0;
+        u64 wait_start = 0;
 
         while (!m_lock.compare_and_exchange(&expected, expected + 1))
         {
-            did_fail_to_acquire();
+            did_fail_to_acquire(spins, wait_start);
 
             // Service IPIs/IRQs/whatever while waiting
             if (service_interrupts) {
@@ -211,7 +270,11 @@ public:
         do_lock(file, line, core_id, false);
     }
 
-    void unlock() ALWAYS_INLINE { m_lock.store(unlocked, MemoryOrder::RELEASE); }
+    void unlock() ALWAYS_INLINE
+    {
+        will_release_lock();
+        m_lock.store(unlocked, MemoryOrder::RELEASE);
+    }
 
     bool try_lock(const char* file = nullptr, size_t line = 0, size_t core_id = 0) ALWAYS_INLINE
     {
@@ -236,9 +299,11 @@ protected:
             file = "<unspecified>";
 
         lock_t expected = unlocked;
+        size_t spins = 0;
+        u64 wait_start = 0;
 
         while (!m_lock.compare_and_exchange(&expected, locked)) {
-            did_fail_to_acquire();
+            did_fail_to_acquire(spins, wait_start);
 
             // Service IPIs/IRQs/whatever while waiting
             if (service_interrupts) {
@@ -250,7 +315,7 @@ protected:
             pause();
         }
 
-        did_acquire_lock(file, line, core_id);
+        did_acquire_lock(file, line, core_id, spins, wait_start);
     }
 
 private:
@@ -308,8 +373,10 @@ public:
     {
         ASSERT(m_depth > 0);
 
-        if (--m_depth == 0)
+        if (--m_depth == 0) {
+            will_release_lock();
             m_lock.store(unlocked, MemoryOrder::RELEASE);
+        }
     }
 
     size_t depth() const { return m_depth; }
@@ -323,6 +390,8 @@ protected:
         u32 this_cpu = CPU::current_id();
 
         lock_t expected = unlocked;
+        size_t spins = 0;
+        u64 wait_start = 0;
 
         while (!m_lock.compare_and_exchange(&expected, this_cpu)) {
             if (expected == this_cpu) {
@@ -330,7 +399,7 @@ protected:
                 return; // we already own the lock
             }
 
-            did_fail_to_acquire();
+            did_fail_to_acquire(spins, wait_start);
 
             // Service IPIs/IRQs/whatever while waiting
             if (service_interrupts) {
@@ -342,7 +411,7 @@ protected:
             asm("pause");
         }
 
-        did_acquire_lock(file, line, this_cpu);
+        did_acquire_lock(file, line, this_cpu, spins, wait_start);
 
         ++m_depth;
     }
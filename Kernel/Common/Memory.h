@@ -4,13 +4,140 @@
 
 namespace kernel {
 
+// Capabilities of the string instructions, filled in from CPUID at boot by CPU::detect_string_features().
+// Until then everything goes through the paths that are fast enough on any x86 processor.
+struct MemoryFeatures {
+    // Enhanced REP MOVSB/STOSB, byte granular string instructions are at least as fast as the wide ones
+    bool erms;
+
+    // Fast short REP MOVSB, string instructions don't have a startup cost even for short copies
+    bool fsrm;
+};
+
+inline MemoryFeatures g_memory_features {};
+
+namespace memory {
+
+// Anything shorter is moved a word at a time, the setup of a string instruction costs more than that
+inline size_t string_instruction_threshold()
+{
+    return g_memory_features.fsrm ? 32 : 256;
+}
+
+// Unaligned word sized accesses, compile down to a single mov
+inline ptr_t load_word(const u8* ptr)
+{
+    ptr_t word;
+    __builtin_memcpy(&word, ptr, sizeof(word));
+    return word;
+}
+
+inline void store_word(u8* ptr, ptr_t word)
+{
+    __builtin_memcpy(ptr, &word, sizeof(word));
+}
+
+inline void copy_forward_by_words(const u8* source, u8* destination, size_t size)
+{
+    for (; size >= sizeof(ptr_t); size -= sizeof(ptr_t)) {
+        store_word(destination, load_word(source));
+        source += sizeof(ptr_t);
+        destination += sizeof(ptr_t);
+    }
+
+    while (size--)
+        *destination++ = *source++;
+}
+
+inline void copy_backward_by_words(const u8* source, u8* destination, size_t size)
+{
+    source += size;
+    destination += size;
+
+    for (; size >= sizeof(ptr_t); size -= sizeof(ptr_t)) {
+        source -= sizeof(ptr_t);
+        destination -= sizeof(ptr_t);
+        store_word(destination, load_word(source));
+    }
+
+    while (size--)
+        *--destination = *--source;
+}
+
+inline void rep_movsb(const u8* source, u8* destination, size_t size)
+{
+    asm volatile("rep movsb"
+                 : "+S"(source), "+D"(destination), "+c"(size)::"memory");
+}
+
+inline void rep_stosb(u8* destination, u8 value, size_t size)
+{
+    asm volatile("rep stosb"
+                 : "+D"(destination), "+c"(size)
+                 : "a"(value)
+                 : "memory");
+}
+
+// Moves as many whole words as fit, then the remaining bytes
+inline void rep_movs_words(const u8* source, u8* destination, size_t size)
+{
+    auto words = size / sizeof(ptr_t);
+    auto bytes = size % sizeof(ptr_t);
+
+#ifdef ULTRA_64
+    asm volatile("rep movsq"
+#elif defined(ULTRA_32)
+    asm volatile("rep movsl"
+#endif
+                 : "+S"(source), "+D"(destination), "+c"(words)::"memory");
+
+    while (bytes--)
+        *destination++ = *source++;
+}
+
+inline void rep_stos_words(u8* destination, ptr_t pattern, size_t size)
+{
+    auto words = size / sizeof(ptr_t);
+    auto bytes = size % sizeof(ptr_t);
+
+#ifdef ULTRA_64
+    asm volatile("rep stosq"
+#elif defined(ULTRA_32)
+    asm volatile("rep stosl"
+#endif
+                 : "+D"(destination), "+c"(words)
+                 : "a"(pattern)
+                 : "memory");
+
+    while (bytes--)
+        *destination++ = static_cast<u8>(pattern);
+}
+
+}
+
 inline void set_memory(void* ptr, size_t size, u8 value)
 {
     auto* byte_ptr = reinterpret_cast<u8*>(ptr);
 
-    for (size_t i = 0; i < size; ++i) {
-        byte_ptr[i] = value;
+    // value repeated in every byte of a word
+    auto pattern = value * (~static_cast<ptr_t>(0) / 0xFF);
+
+    if (size >= memory::string_instruction_threshold()) {
+        if (g_memory_features.erms)
+            memory::rep_stosb(byte_ptr, value, size);
+        else
+            memory::rep_stos_words(byte_ptr, pattern, size);
+
+        return;
     }
+
+    for (; size >= sizeof(ptr_t); size -= sizeof(ptr_t)) {
+        memory::store_word(byte_ptr, pattern);
+        byte_ptr += sizeof(ptr_t);
+    }
+
+    while (size--)
+        *byte_ptr++ = value;
 }
 
 inline void zero_memory(void* ptr, size_t size)
@@ -23,8 +150,12 @@ inline void copy_memory(const void* source, void* destination, size_t size)
     const u8* byte_src = reinterpret_cast<const u8*>(source);
     u8* byte_dst = reinterpret_cast<u8*>(destination);
 
-    while (size--)
-        *byte_dst++ = *byte_src++;
+    if (size < memory::string_instruction_threshold())
+        memory::copy_forward_by_words(byte_src, byte_dst, size);
+    else if (g_memory_features.erms)
+        memory::rep_movsb(byte_src, byte_dst, size);
+    else
+        memory::rep_movs_words(byte_src, byte_dst, size);
 }
 
 inline void move_memory(const void* source, void* destination, size_t size)
@@ -32,13 +163,11 @@ inline void move_memory(const void* source, void* destination, size_t size)
     const u8* byte_src = reinterpret_cast<const u8*>(source);
     u8* byte_dst = reinterpret_cast<u8*>(destination);
 
-    if (source < destination) {
-        byte_src += size;
-        byte_dst += size;
-
-        while (size--)
-            *--byte_dst = *--byte_src;
-    } else
+    // A forward copy never overwrites source bytes it hasn't read yet unless destination overlaps them from above.
+    // Backward string instructions are slow on pretty much every processor, so that case goes word by word.
+    if (byte_dst > byte_src && byte_dst < byte_src + size)
+        memory::copy_backward_by_words(byte_src, byte_dst, size);
+    else
         copy_memory(source, destination, size);
 }
 
@@ -47,6 +176,15 @@ inline bool compare_memory(const void* lhs, const void* rhs, size_t size)
     const u8* byte_lhs = reinterpret_cast<const u8*>(lhs);
     const u8* byte_rhs = reinterpret_cast<const u8*>(rhs);
 
+    // REPE CMPSB is microcoded a byte per iteration even with ERMS, words are a lot faster
+    for (; size >= sizeof(ptr_t); size -= sizeof(ptr_t)) {
+        if (memory::load_word(byte_lhs) != memory::load_word(byte_rhs))
+            return false;
+
+        byte_lhs += sizeof(ptr_t);
+        byte_rhs += sizeof(ptr_t);
+    }
+
     while (size--) {
         if (*byte_lhs++ != *byte_rhs++)
             return false;
@@ -5,6 +5,7 @@
 #include "Common/Types.h"
 #include "Common/Utilities.h"
 #include "Core/Runtime.h"
+#include "Memory/SlabAllocated.h"
 
 namespace kernel::detail {
 
@@ -343,6 +344,8 @@ public:
     };
 
     struct ValueNode final : public Node<ValueNode> {
+        MAKE_SLAB_ALLOCATED(ValueNode)
+
         template <typename... Args>
         ValueNode(Args&&... args)
             : value(forward<Args>(args)...)
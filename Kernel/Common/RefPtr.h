@@ -4,6 +4,7 @@
 #include "Common/Macros.h"
 #include "Common/Utilities.h"
 #include "Core/Runtime.h"
+#include "Memory/SlabAllocated.h"
 
 namespace kernel {
 
@@ -39,6 +40,8 @@ private:
 template <typename T>
 class OwningRefCounter : public RefCounterBase<T> {
 public:
+    MAKE_SLAB_ALLOCATED(OwningRefCounter)
+
     template <typename... Args>
     explicit OwningRefCounter(Args&&... args)
     {
@@ -63,6 +66,8 @@ private:
 template <typename T>
 class NonOwningRefCounter : public RefCounterBase<T> {
 public:
+    MAKE_SLAB_ALLOCATED(NonOwningRefCounter)
+
     explicit NonOwningRefCounter(T* ptr)
         : m_ptr(ptr)
     {
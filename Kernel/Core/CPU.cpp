@@ -5,12 +5,21 @@
 #include "Interrupts/IDT.h"
 #include "Interrupts/InterruptController.h"
 #include "Interrupts/LAPIC.h"
+#include "Interrupts/SyscallDispatcher.h"
 
 #include "Memory/MemoryManager.h"
+#include "Memory/ObjectCache.h"
 #include "Memory/PAT.h"
+#include "Memory/PCID.h"
+#include "Memory/PhysicalPageCache.h"
 
 #include "Multitasking/Process.h"
+#include "Multitasking/RunQueue.h"
+#include "Multitasking/Scheduler.h"
 #include "Multitasking/TSS.h"
+#include "Multitasking/ThreadResourceCache.h"
+
+#include "Time/TimerWheel.h"
 
 #include "CPU.h"
 #include "FPU.h"
@@ -21,11 +30,20 @@ Atomic<size_t> CPU::s_alive_counter;
 List<CPU::LocalData> CPU::s_processors;
 CPU::LocalData* CPU::s_id_to_processor[CPU::max_lapic_id + 1] {};
 
-CPU::LocalData::LocalData(u32 id)
+CPU::LocalData::LocalData(u32 id, u32 index)
     : m_id(id)
+    , m_index(index)
 {
     m_is_online = new Atomic<bool>(false);
     m_request_lock = new InterruptSafeSpinLock;
+    m_run_queue = new RunQueue;
+    m_timer_wheel = new TimerWheel;
+    m_thread_resource_cache = new ThreadResourceCache;
+    m_physical_page_cache = new PhysicalPageCache;
+    m_object_magazines = new ObjectMagazines;
+#ifdef ULTRA_64
+    m_pcid_cache = new PCID::Cache;
+#endif
 }
 
 IPICommunicator::Request* CPU::LocalData::pop_request()
@@ -60,11 +78,11 @@ Thread& CPU::LocalData::idle_task()
     return **m_idle_process->threads().begin();
 }
 
-CPU::ID::ID(u32 function)
+CPU::ID::ID(u32 function, u32 subfunction)
 {
     asm volatile("cpuid"
                  : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
-                 : "a"(function), "c"(0));
+                 : "a"(function), "c"(subfunction));
 }
 
 CPU::MSR CPU::MSR::read(u32 index)
@@ -99,6 +117,20 @@ void CPU::XCR::write(u32 index)
     asm volatile("xsetbv" ::"d"(upper), "a"(lower), "c"(index));
 }
 
+void CPU::write_cr0(size_t value)
+{
+    asm volatile("mov %0, %%cr0" ::"r"(value));
+}
+
+size_t CPU::read_cr0()
+{
+    size_t value;
+    asm volatile("mov %%cr0, %0"
+                 : "=r"(value));
+
+    return value;
+}
+
 void CPU::write_cr4(size_t value)
 {
     asm volatile("mov %0, %%cr4" ::"r"(value));
@@ -113,6 +145,17 @@ size_t CPU::read_cr4()
     return value;
 }
 
+u64 CPU::read_tsc()
+{
+    u32 upper;
+    u32 lower;
+
+    asm volatile("rdtsc"
+                 : "=d"(upper), "=a"(lower));
+
+    return (static_cast<u64>(upper) << 32) | lower;
+}
+
 void CPU::initialize()
 {
     u32 bsp_id = 0;
@@ -120,7 +163,7 @@ void CPU::initialize()
     if (supports_smp())
         bsp_id = LAPIC::my_id();
 
-    auto cpu = s_id_to_processor[bsp_id] = new LocalData(bsp_id);
+    auto cpu = s_id_to_processor[bsp_id] = new LocalData(bsp_id, 0);
     s_processors.insert_back(*cpu);
     cpu->bring_online();
 
@@ -142,6 +185,33 @@ bool CPU::supports_smp()
     return !InterruptController::is_legacy_mode();
 }
 
+const CPU::ID& CPU::feature_flags()
+{
+    static constexpr u32 feature_flags_function = 1;
+
+    static ID flags(feature_flags_function);
+    return flags;
+}
+
+void CPU::detect_string_features()
+{
+    static constexpr u32 extended_features_function = 7;
+
+    // Asking for a leaf above the maximum returns whatever the highest one has
+    if (CPU::ID(0).a < extended_features_function) {
+        log() << "CPU: no extended feature flags, using generic string operations";
+        return;
+    }
+
+    auto id7 = CPU::ID(extended_features_function);
+
+    g_memory_features.erms = IS_BIT_SET(id7.b, 9);
+    g_memory_features.fsrm = IS_BIT_SET(id7.d, 4);
+
+    log() << "CPU: ERMS " << (g_memory_features.erms ? "yes" : "no")
+          << ", FSRM " << (g_memory_features.fsrm ? "yes" : "no");
+}
+
 void CPU::start_all_processors()
 {
     if (InterruptController::is_legacy_mode())
@@ -157,7 +227,7 @@ void CPU::start_all_processors()
         if (lapic.id == bsp_id)
             continue;
 
-        auto cpu = s_id_to_processor[lapic.id] = new LocalData(lapic.id);
+        auto cpu = s_id_to_processor[lapic.id] = new LocalData(lapic.id, s_processors.size());
         s_processors.insert_back(*cpu);
     }
 
@@ -175,8 +245,11 @@ void CPU::start_all_processors()
     }
 
     // now LAPIC is the primary timer
-    Timer::get_specific(LAPIC::Timer::type).make_primary();
-    Timer::primary().enable(); // enable for the BSP
+    auto& lapic_timer = Timer::get_specific(LAPIC::Timer::type);
+    lapic_timer.make_primary();
+    lapic_timer.enable(); // enable for the BSP
+
+    Scheduler::enable_tickless_mode(lapic_timer);
 }
 
 CPU::LocalData& CPU::at_id(u32 id)
@@ -227,6 +300,7 @@ void CPU::ap_entrypoint()
     GDT::the().install();
     IDT::the().install();
     PAT::the().synchronize();
+    PCID::initialize_for_this_cpu();
     FPU::initialize_for_this_cpu();
 
     LAPIC::initialize_for_this_processor();
@@ -238,6 +312,7 @@ void CPU::ap_entrypoint()
 
     auto& current_cpu = CPU::current();
     current_cpu.set_tss(*new TSS);
+    SyscallDispatcher::initialize_fast_entry_for_this_cpu();
 
     current_cpu.bring_online();
     s_alive_counter.fetch_add(1, MemoryOrder::ACQ_REL);
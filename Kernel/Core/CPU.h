@@ -7,6 +7,7 @@
 #include "Common/RefPtr.h"
 #include "Common/String.h"
 #include "Interrupts/IPICommunicator.h"
+#include "Memory/PCID.h"
 
 namespace kernel {
 
@@ -14,6 +15,14 @@ class Thread;
 class TSS;
 class Process;
 class InterruptSafeSpinLock;
+class RunQueue;
+class TimerWheel;
+class ThreadResourceCache;
+class ObjectMagazines;
+class PhysicalPageCache;
+class TraceBuffer;
+class ProfileTable;
+class AddressSpace;
 
 class CPU {
     MAKE_STATIC(CPU)
@@ -24,16 +33,19 @@ public:
         ADJUST = SET_BIT(4),
         ZERO = SET_BIT(6),
         SIGN = SET_BIT(7),
+        TRAP = SET_BIT(8),
         INTERRUPTS = SET_BIT(9),
         DIRECTION = SET_BIT(10),
         OVERFLOW = SET_BIT(11),
+        NESTED_TASK = SET_BIT(14),
+        ALIGNMENT_CHECK = SET_BIT(18),
         CPUID = SET_BIT(21),
     };
 
     friend FLAGS operator&(FLAGS l, FLAGS r) { return static_cast<FLAGS>(static_cast<size_t>(l) & static_cast<size_t>(r)); }
 
     struct ID {
-        explicit ID(u32 function);
+        explicit ID(u32 function, u32 subfunction = 0);
 
         u32 a { 0x00000000 };
         u32 b { 0x00000000 };
@@ -57,15 +69,27 @@ public:
         u32 lower { 0x00000000 };
     };
 
+    static void write_cr0(size_t value);
+    static size_t read_cr0();
+
     static void write_cr4(size_t value);
     static size_t read_cr4();
 
+    static u64 read_tsc();
+
     static void initialize();
 
     static FLAGS flags();
 
     static bool supports_smp();
 
+    // CPUID leaf 1 as reported by the BSP. Processors are assumed to be identical,
+    // so per-processor setup checks feature bits here instead of querying every time.
+    static const ID& feature_flags();
+
+    // Picks the copy_memory/set_memory strategy, see Common/Memory.h
+    static void detect_string_features();
+
     static void start_all_processors();
 
     static bool is_initialized() { return !s_processors.empty(); }
@@ -75,14 +99,18 @@ public:
 
     class LocalData : public StandaloneListNode<LocalData> {
     public:
-        explicit LocalData(u32 id);
+        LocalData(u32 id, u32 index);
 
         [[nodiscard]] u32 id() const { return m_id; }
 
+        // Position in processors(), unlike LAPIC ids these are contiguous. Used as the bit number in affinity masks.
+        [[nodiscard]] u32 index() const { return m_index; }
+
         [[nodiscard]] Process& current_process() const;
 
-        [[nodiscard]] Thread* current_thread() const { return m_current_thread; }
-        void set_current_thread(Thread* thread) { m_current_thread = thread; }
+        // Also read by other processors spinning on a mutex owner
+        [[nodiscard]] Thread* current_thread() const { return __atomic_load_n(&m_current_thread, __ATOMIC_RELAXED); }
+        void set_current_thread(Thread* thread) { __atomic_store_n(&m_current_thread, thread, __ATOMIC_RELAXED); }
 
         TSS& tss()
         {
@@ -104,8 +132,36 @@ public:
         IPICommunicator::Request* pop_request();
         void push_request(IPICommunicator::Request&);
 
+        RunQueue& run_queue() { return *m_run_queue; }
+
+        // Thread that last loaded its state into the FPU of this processor
+        Thread* fpu_owner() const { return m_fpu_owner; }
+        void set_fpu_owner(Thread* thread) { m_fpu_owner = thread; }
+        TimerWheel& timer_wheel() { return *m_timer_wheel; }
+        ThreadResourceCache& thread_resource_cache() { return *m_thread_resource_cache; }
+        PhysicalPageCache& physical_page_cache() { return *m_physical_page_cache; }
+
+        // Null while this processor is being set up, its objects come straight from the slabs then
+        ObjectMagazines* object_magazines() const { return m_object_magazines; }
+
+        // Allocated once tracing is enabled for the first time
+        TraceBuffer* trace_buffer() const { return __atomic_load_n(&m_trace_buffer, __ATOMIC_ACQUIRE); }
+        void set_trace_buffer(TraceBuffer* buffer) { __atomic_store_n(&m_trace_buffer, buffer, __ATOMIC_RELEASE); }
+
+        // Allocated once the profiler is started for the first time
+        ProfileTable* profile_table() const { return __atomic_load_n(&m_profile_table, __ATOMIC_ACQUIRE); }
+        void set_profile_table(ProfileTable* table) { __atomic_store_n(&m_profile_table, table, __ATOMIC_RELEASE); }
+#ifdef ULTRA_64
+        PCID::Cache& pcid_cache() { return *m_pcid_cache; }
+#endif
+
+        // Address space whose page tables are currently loaded, nullptr means the kernel one we boot with
+        AddressSpace* active_address_space() const { return m_active_address_space; }
+        void set_active_address_space(AddressSpace* address_space) { m_active_address_space = address_space; }
+
     private:
         u32 m_id { 0 };
+        u32 m_index { 0 };
         RefPtr<Process> m_idle_process;
         Thread* m_current_thread { nullptr };
         TSS* m_tss { nullptr };
@@ -114,6 +170,20 @@ public:
         static constexpr size_t max_ipi_requests = 32;
         InterruptSafeSpinLock* m_request_lock { nullptr };
         CircularBuffer<IPICommunicator::Request*, max_ipi_requests> m_requests;
+
+        RunQueue* m_run_queue { nullptr };
+        TimerWheel* m_timer_wheel { nullptr };
+        ThreadResourceCache* m_thread_resource_cache { nullptr };
+        PhysicalPageCache* m_physical_page_cache { nullptr };
+        ObjectMagazines* m_object_magazines { nullptr };
+        TraceBuffer* m_trace_buffer { nullptr };
+        ProfileTable* m_profile_table { nullptr };
+#ifdef ULTRA_64
+        PCID::Cache* m_pcid_cache { nullptr };
+#endif
+        AddressSpace* m_active_address_space { nullptr };
+
+        Thread* m_fpu_owner { nullptr };
     };
 
     static List<LocalData>& processors() { return s_processors; }
@@ -123,6 +193,8 @@ public:
 
     static u32 current_id();
 
+    static constexpr u32 max_lapic_id = 255;
+
 private:
     [[noreturn]] static void ap_entrypoint() USED;
 
@@ -130,7 +202,6 @@ private:
     static Atomic<size_t> s_alive_counter;
     static List<LocalData> s_processors;
 
-    static constexpr u32 max_lapic_id = 255;
     static LocalData* s_id_to_processor[max_lapic_id + 1];
 };
 }
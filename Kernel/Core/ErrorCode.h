@@ -64,6 +64,10 @@ struct ErrorCode {
             return "Operation Would Block Forever";
         case MEMORY_ACCESS_VIOLATION:
             return "Memory Access Violation";
+        case TRY_AGAIN:
+            return "Try Again";
+        case TIMED_OUT:
+            return "Timed Out";
         default:
             return "<Unknown code>"_sv;
         }
@@ -5,6 +5,7 @@
 namespace kernel {
 
 FPU::Features FPU::s_features;
+Atomic<size_t> FPU::s_lazy_restores;
 
 void FPU::detect_features()
 {
@@ -45,6 +46,13 @@ void FPU::detect_features()
         s_features.save_area_bytes = idd.c;
         s_features.xcr0_supported_bits = idd.a;
         log() << "XSAVE area bytes: " << s_features.save_area_bytes;
+
+        // XSAVEOPT skips components that are in their initial state or weren't modified since the last XRSTOR
+        static constexpr u32 xsaveopt_bit = SET_BIT(0);
+        s_features.xsaveopt = CPU::ID(0xD, 1).a & xsaveopt_bit;
+
+        if (s_features.xsaveopt)
+            log() << "FPU: using XSAVEOPT";
     } else if (s_features.fxsave) {
         s_features.save_area_bytes = 512;
     } else {
@@ -57,6 +65,12 @@ void FPU::detect_features()
 
 void FPU::initialize_for_this_cpu()
 {
+    // Makes WAIT/FWAIT respect CR0.TS as well, needed for lazy switching
+    static constexpr size_t monitor_coprocessor_bit = SET_BIT(1);
+    static constexpr size_t emulation_bit = SET_BIT(2);
+
+    CPU::write_cr0((CPU::read_cr0() | monitor_coprocessor_bit) & ~emulation_bit);
+
     auto cr4 = CPU::read_cr4();
 
     if (s_features.sse1) {
@@ -120,6 +134,13 @@ void* FPU::allocate_state()
 {
     ASSERT(s_features.save_area_bytes != 0);
     void* ptr = HeapAllocator::allocate(s_features.save_area_bytes, s_features.xsave ? 64 : 16);
+    reset_state(ptr);
+
+    return ptr;
+}
+
+void FPU::reset_state(void* ptr)
+{
     zero_memory(ptr, s_features.save_area_bytes);
 
     // From intel manual:
@@ -152,8 +173,6 @@ void* FPU::allocate_state()
         *Address(byte_ptr + fcw_offset).as_pointer<u16>() = default_fcw_value;
         *Address(byte_ptr + tag_offset).as_pointer<u16>() = default_tag_value;
     }
-
-    return ptr;
 }
 
 void FPU::free_state(void* ptr)
@@ -165,7 +184,15 @@ void FPU::save_state(void* ptr)
 {
     u8* byte_ptr = reinterpret_cast<u8*>(ptr);
 
-    if (s_features.xsave) {
+    if (s_features.xsaveopt) {
+        u32 low = 0xFFFFFFFF;
+        u32 high = 0xFFFFFFFF;
+
+        asm volatile("xsaveopt %0"
+                     : "=m"(*byte_ptr)
+                     : "a"(low), "d"(high)
+                     : "memory");
+    } else if (s_features.xsave) {
         u32 low = 0xFFFFFFFF;
         u32 high = 0xFFFFFFFF;
 
@@ -198,4 +225,20 @@ void FPU::restore_state(void* ptr)
     }
 }
 
+void FPU::set_access_trapped(bool trapped)
+{
+    static constexpr size_t task_switched_bit = SET_BIT(3);
+
+    // Writing CR0 is serializing, so only touch it if the state actually changes
+    auto cr0 = CPU::read_cr0();
+
+    if (static_cast<bool>(cr0 & task_switched_bit) == trapped)
+        return;
+
+    if (trapped)
+        CPU::write_cr0(cr0 | task_switched_bit);
+    else
+        asm volatile("clts");
+}
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Common/Atomic.h"
 #include "Common/Macros.h"
 #include "Common/Types.h"
 
@@ -23,6 +24,7 @@ public:
         bool avx512;
         bool fxsave;
         bool xsave;
+        bool xsaveopt;
         u32 xcr0_supported_bits;
         u32 mxcsr_mask;
         size_t save_area_bytes;
@@ -32,11 +34,22 @@ public:
     static void* allocate_state();
     static void free_state(void*);
 
+    // Puts a previously used save area back into the state a freshly allocated one starts with
+    static void reset_state(void*);
+
     static void save_state(void*);
     static void restore_state(void*);
 
+    // FPU state is switched lazily, while access is trapped the next
+    // FPU/SIMD instruction raises #NM and the state gets loaded from there.
+    static void set_access_trapped(bool);
+
+    static void count_lazy_restore() { s_lazy_restores.fetch_add(1, MemoryOrder::RELAXED); }
+    static size_t lazy_restores() { return s_lazy_restores.load(MemoryOrder::RELAXED); }
+
 private:
     static Features s_features;
+    static Atomic<size_t> s_lazy_restores;
 };
 
 }
@@ -41,27 +41,33 @@ void GDT::create_basic_descriptors()
     // kernel data
     create_descriptor(0x00000000, 0xFFFFFFFF, PRESENT | CODE_OR_DATA | WRITABLE, GRANULARITY_4KB | MODE_32_BIT);
 
-// userspace code
+// userspace code & data
 #ifdef ULTRA_32
     create_descriptor(
         0x00000000,
         0xFFFFFFFF,
         PRESENT | CODE_OR_DATA | EXECUTABLE | RING_3 | READABLE,
         GRANULARITY_4KB | MODE_32_BIT);
-#elif defined(ULTRA_64)
+
     create_descriptor(
         0x00000000,
         0xFFFFFFFF,
-        PRESENT | CODE_OR_DATA | EXECUTABLE | READABLE | RING_3,
-        GRANULARITY_4KB | MODE_64_BIT);
-#endif
-
-    // userspace data
+        PRESENT | CODE_OR_DATA | WRITABLE | RING_3,
+        GRANULARITY_4KB | MODE_32_BIT);
+#elif defined(ULTRA_64)
+    // data goes first here, see userland_data_selector()
     create_descriptor(
         0x00000000,
         0xFFFFFFFF,
         PRESENT | CODE_OR_DATA | WRITABLE | RING_3,
         GRANULARITY_4KB | MODE_32_BIT);
+
+    create_descriptor(
+        0x00000000,
+        0xFFFFFFFF,
+        PRESENT | CODE_OR_DATA | EXECUTABLE | READABLE | RING_3,
+        GRANULARITY_4KB | MODE_64_BIT);
+#endif
 }
 
 void GDT::create_tss_descriptor(TSS& tss)
@@ -62,8 +62,14 @@ public:
     static constexpr u16 kernel_code_selector() { return 0x8; }
     static constexpr u16 kernel_data_selector() { return 0x10; }
 
+#ifdef ULTRA_32
     static constexpr u16 userland_code_selector() { return 0x18; }
     static constexpr u16 userland_data_selector() { return 0x20; }
+#elif defined(ULTRA_64)
+    // SYSRET expects the userland data selector to come right before the code one
+    static constexpr u16 userland_data_selector() { return 0x18; }
+    static constexpr u16 userland_code_selector() { return 0x20; }
+#endif
 
     static GDT& the();
 
@@ -0,0 +1,143 @@
+#include "Common/Utilities.h"
+
+#include "Interrupts/Utilities.h"
+
+#include "Time/TSC.h"
+
+#include "CPU.h"
+#include "LockProfiler.h"
+
+namespace kernel {
+
+bool LockProfiler::s_is_enabled;
+LockSite LockProfiler::s_sites[max_sites];
+Atomic<u64> LockProfiler::s_dropped_sites;
+
+static constexpr u32 site_free = 0;
+static constexpr u32 site_registering = 1;
+static constexpr u32 site_ready = 2;
+
+static void update_max(Atomic<u64>& max_value, u64 value)
+{
+    auto current = max_value.load(MemoryOrder::RELAXED);
+
+    while (current < value && !max_value.compare_and_exchange(&current, value)) { }
+}
+
+void LockProfiler::enable()
+{
+    for (auto& site : s_sites) {
+        site.acquisitions.store(0, MemoryOrder::RELAXED);
+        site.contentions.store(0, MemoryOrder::RELAXED);
+        site.spins.store(0, MemoryOrder::RELAXED);
+        site.wait_cycles.store(0, MemoryOrder::RELAXED);
+        site.max_wait_cycles.store(0, MemoryOrder::RELAXED);
+        site.hold_cycles.store(0, MemoryOrder::RELAXED);
+        site.max_hold_cycles.store(0, MemoryOrder::RELAXED);
+    }
+
+    s_dropped_sites.store(0, MemoryOrder::RELAXED);
+    __atomic_store_n(&s_is_enabled, true, __ATOMIC_RELEASE);
+}
+
+void LockProfiler::disable()
+{
+    __atomic_store_n(&s_is_enabled, false, __ATOMIC_RELEASE);
+}
+
+LockSite* LockProfiler::find_or_register(const char* file, u32 line)
+{
+    auto hash = (reinterpret_cast<ptr_t>(file) ^ (static_cast<ptr_t>(line) * 0x9E3779B9)) * 0x9E3779B9;
+    auto index = static_cast<size_t>(hash >> 8);
+
+    for (size_t i = 0; i < max_sites; ++i) {
+        auto& site = s_sites[(index + i) & (max_sites - 1)];
+        auto state = site.state.load(MemoryOrder::ACQUIRE);
+
+        if (state == site_free) {
+            // Registration must not be interrupted, as an interrupt handler might end up spinning on it below
+            Interrupts::ScopedDisabler d;
+
+            if (site.state.compare_and_exchange(&state, site_registering)) {
+                site.file = file;
+                site.line = line;
+                site.state.store(site_ready, MemoryOrder::RELEASE);
+                return &site;
+            }
+        }
+
+        // Someone else is registering this slot right now, it might be our site
+        while (state == site_registering) {
+            pause();
+            state = site.state.load(MemoryOrder::ACQUIRE);
+        }
+
+        if (site.file == file && site.line == line)
+            return &site;
+    }
+
+    return nullptr;
+}
+
+LockSite* LockProfiler::did_acquire(const char* file, size_t line, size_t spins, u64 wait_start, u64 now)
+{
+    auto* site = find_or_register(file, line);
+
+    if (!site) {
+        s_dropped_sites.fetch_add(1, MemoryOrder::RELAXED);
+        return nullptr;
+    }
+
+    site->acquisitions.fetch_add(1, MemoryOrder::RELAXED);
+
+    if (!spins)
+        return site;
+
+    auto wait = now - wait_start;
+
+    site->contentions.fetch_add(1, MemoryOrder::RELAXED);
+    site->spins.fetch_add(spins, MemoryOrder::RELAXED);
+    site->wait_cycles.fetch_add(wait, MemoryOrder::RELAXED);
+    update_max(site->max_wait_cycles, wait);
+
+    return site;
+}
+
+void LockProfiler::did_release(LockSite& site, u64 acquired_at)
+{
+    auto hold = CPU::read_tsc() - acquired_at;
+
+    site.hold_cycles.fetch_add(hold, MemoryOrder::RELAXED);
+    update_max(site.max_hold_cycles, hold);
+}
+
+DynamicArray<LockProfiler::SiteStats> LockProfiler::stats()
+{
+    DynamicArray<SiteStats> stats;
+
+    for (auto& site : s_sites) {
+        if (site.state.load(MemoryOrder::ACQUIRE) != site_ready)
+            continue;
+
+        auto acquisitions = site.acquisitions.load(MemoryOrder::RELAXED);
+
+        if (!acquisitions)
+            continue;
+
+        stats.append({ site.file,
+            site.line,
+            acquisitions,
+            site.contentions.load(MemoryOrder::RELAXED),
+            site.spins.load(MemoryOrder::RELAXED),
+            TSC::cycles_to_nanoseconds(site.wait_cycles.load(MemoryOrder::RELAXED)),
+            TSC::cycles_to_nanoseconds(site.max_wait_cycles.load(MemoryOrder::RELAXED)),
+            TSC::cycles_to_nanoseconds(site.hold_cycles.load(MemoryOrder::RELAXED)),
+            TSC::cycles_to_nanoseconds(site.max_hold_cycles.load(MemoryOrder::RELAXED)) });
+    }
+
+    quick_sort(stats.begin(), stats.end(),
+        [](const SiteStats& l, const SiteStats& r) { return l.wait_ns > r.wait_ns; });
+
+    return stats;
+}
+}
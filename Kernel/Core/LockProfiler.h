@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/DynamicArray.h"
+#include "Common/Macros.h"
+#include "Common/Types.h"
+
+namespace kernel {
+
+// Contention counters of every place in the code that acquires a spin lock, keyed by file and line.
+// Sites are registered lock-free on their first acquisition, this is called with spin locks held
+// so it can't take any itself.
+struct LockSite {
+    Atomic<u32> state { 0 };
+    const char* file { nullptr };
+    u32 line { 0 };
+
+    Atomic<u64> acquisitions { 0 };
+    Atomic<u64> contentions { 0 };
+    Atomic<u64> spins { 0 };
+    Atomic<u64> wait_cycles { 0 };
+    Atomic<u64> max_wait_cycles { 0 };
+    Atomic<u64> hold_cycles { 0 };
+    Atomic<u64> max_hold_cycles { 0 };
+};
+
+class LockProfiler {
+    MAKE_STATIC(LockProfiler);
+
+public:
+    static bool is_enabled() { return __atomic_load_n(&s_is_enabled, __ATOMIC_RELAXED); }
+
+    // Resets all counters, sites are kept
+    static void enable();
+    static void disable();
+
+    // wait_start is the TSC value of the first failed attempt, 0 if the lock was free.
+    // Returns the site to pass back on release, nullptr if the site table is full.
+    NOINLINE static LockSite* did_acquire(const char* file, size_t line, size_t spins, u64 wait_start, u64 now);
+    NOINLINE static void did_release(LockSite&, u64 acquired_at);
+
+    struct SiteStats {
+        const char* file;
+        u32 line;
+        u64 acquisitions;
+        u64 contentions;
+        u64 spins;
+        u64 wait_ns;
+        u64 max_wait_ns;
+        u64 hold_ns;
+        u64 max_hold_ns;
+    };
+
+    // Sites that were acquired at least once since the profiler was last enabled, most waited on first
+    static DynamicArray<SiteStats> stats();
+
+    // Sites that couldn't be registered because the table was full
+    static u64 dropped_sites() { return s_dropped_sites.load(MemoryOrder::RELAXED); }
+
+private:
+    static constexpr size_t max_sites = 512;
+    static_assert((max_sites & (max_sites - 1)) == 0, "max_sites must be a power of two");
+
+    static LockSite* find_or_register(const char* file, u32 line);
+
+    static bool s_is_enabled;
+    static LockSite s_sites[max_sites];
+    static Atomic<u64> s_dropped_sites;
+};
+}
@@ -0,0 +1,293 @@
+#include "Common/DynamicArray.h"
+#include "Common/Lock.h"
+#include "Common/Map.h"
+#include "Common/Memory.h"
+#include "Common/Utilities.h"
+
+#include "Interrupts/Timer.h"
+
+#include "Multitasking/Mutex.h"
+#include "Multitasking/Process.h"
+
+#include "CPU.h"
+#include "Profiler.h"
+#include "Runtime.h"
+
+namespace kernel {
+
+bool Profiler::s_is_running;
+u32 Profiler::s_session;
+u32 Profiler::s_ticks_per_sample = 1;
+
+// Tables are allocated with this held, so it can't be a spin lock
+static Mutex s_tables_lock;
+
+void ProfileTable::begin_session(u32 session)
+{
+    if (m_session == session)
+        return;
+
+    zero_memory(m_entries, sizeof(m_entries));
+    m_ticks_until_sample = 0;
+    m_kernel_samples = 0;
+    m_user_samples = 0;
+    m_dropped_samples = 0;
+    m_session = session;
+}
+
+bool ProfileTable::consume_tick(u32 ticks_per_sample)
+{
+    if (m_ticks_until_sample) {
+        --m_ticks_until_sample;
+        return false;
+    }
+
+    m_ticks_until_sample = ticks_per_sample - 1;
+    return true;
+}
+
+ProfileTable::Entry* ProfileTable::find_or_insert(ptr_t address, u32 process_id, bool is_user)
+{
+    u64 hash = static_cast<u64>(address) ^ (static_cast<u64>(process_id) << 40) ^ is_user;
+    hash *= 0x9E3779B97F4A7C15;
+
+    auto index = static_cast<size_t>(hash >> 32);
+
+    for (size_t i = 0; i < max_probes; ++i) {
+        auto& entry = m_entries[(index + i) & (capacity - 1)];
+
+        if (entry.total_samples == 0) {
+            entry.address = address;
+            entry.process_id = process_id;
+            entry.is_user = is_user;
+            return &entry;
+        }
+
+        if (entry.address == address && entry.process_id == process_id && entry.is_user == is_user)
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+// Same as runtime::dump_backtrace, except that it never reads outside of [stack_begin, stack_end).
+// The kernel is built without frame pointers, so the interrupted base pointer might hold anything at all.
+static size_t walk_stack(ptr_t* into, size_t max_depth, ptr_t base_pointer, ptr_t stack_begin, ptr_t stack_end)
+{
+    size_t depth = 0;
+
+    while (depth < max_depth) {
+        if (base_pointer < stack_begin || base_pointer + 2 * sizeof(ptr_t) > stack_end || base_pointer % sizeof(ptr_t))
+            break;
+
+        auto* frame = reinterpret_cast<ptr_t*>(base_pointer);
+        into[depth++] = frame[1];
+
+        // Callers always live further up the stack
+        if (frame[0] <= base_pointer)
+            break;
+
+        base_pointer = frame[0];
+    }
+
+    return depth;
+}
+
+void ProfileTable::record(const RegisterState& registers, u32 process_id, bool is_user, const Range& stack)
+{
+    if (is_user)
+        ++m_user_samples;
+    else
+        ++m_kernel_samples;
+
+    auto* entry = find_or_insert(registers.instruction_pointer(), process_id, is_user);
+
+    if (!entry) {
+        ++m_dropped_samples;
+        return;
+    }
+
+    ++entry->self_samples;
+    ++entry->total_samples;
+
+    // We can't safely walk user stacks from here, only the interrupted function itself is known for those
+    if (is_user || !stack.contains(Address(&registers)))
+        return;
+
+    // Kernel stacks are preallocated, so everything from the interrupt frame up is mapped
+    ptr_t callers[max_stack_depth];
+    auto depth = walk_stack(callers, max_stack_depth, registers.base_pointer(),
+                            reinterpret_cast<ptr_t>(&registers), stack.end().raw());
+
+    for (size_t i = 0; i < depth; ++i) {
+        auto* caller = find_or_insert(callers[i], 0, false);
+
+        // Not counted as dropped, the sample itself made it
+        if (!caller)
+            continue;
+
+        ++caller->total_samples;
+    }
+}
+
+void Profiler::start(u32 samples_per_second)
+{
+    {
+        LOCK_GUARD(s_tables_lock);
+
+        for (auto& cpu : CPU::processors()) {
+            if (!cpu.profile_table())
+                cpu.set_profile_table(new ProfileTable);
+        }
+    }
+
+    if (samples_per_second == 0 || samples_per_second > Timer::default_ticks_per_second)
+        samples_per_second = Timer::default_ticks_per_second;
+
+    // Every processor wipes its own table on the next sample, so we never race with one being written
+    __atomic_store_n(&s_ticks_per_sample, Timer::default_ticks_per_second / samples_per_second, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s_session, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_is_running, true, __ATOMIC_RELEASE);
+}
+
+void Profiler::stop()
+{
+    __atomic_store_n(&s_is_running, false, __ATOMIC_RELEASE);
+}
+
+void Profiler::sample(const RegisterState& registers)
+{
+    auto* table = CPU::current().profile_table();
+
+    if (!table)
+        return;
+
+    table->begin_session(__atomic_load_n(&s_session, __ATOMIC_RELAXED));
+
+    if (!table->consume_tick(__atomic_load_n(&s_ticks_per_sample, __ATOMIC_RELAXED)))
+        return;
+
+    bool is_user = (registers.cs & 0b11) == 0b11;
+    auto* thread = Thread::current();
+    auto process_id = is_user ? thread->owner().id() : 0;
+
+    // Interrupts taken in the kernel don't switch stacks, the registers are on the interrupted one
+    Range stack {};
+    if (!is_user && thread)
+        stack = thread->kernel_stack().virtual_range();
+
+    table->record(registers, process_id, is_user, stack);
+}
+
+struct FunctionSamples {
+    const runtime::KernelSymbolTable::Symbol* symbol { nullptr };
+    u64 self_samples { 0 };
+    u64 total_samples { 0 };
+};
+
+static void append_percentage(String& string, u64 samples, u64 total)
+{
+    auto tenths = total ? (samples * 1000) / total : 0;
+    string << tenths / 10 << "." << tenths % 10 << "%";
+}
+
+void Profiler::report(String& string, size_t top_n)
+{
+    auto session = __atomic_load_n(&s_session, __ATOMIC_RELAXED);
+
+    Map<ptr_t, FunctionSamples> functions;
+    DynamicArray<ProfileTable::Entry> user_entries;
+    u64 kernel_samples = 0;
+    u64 user_samples = 0;
+    u64 dropped_samples = 0;
+
+    for (auto& cpu : CPU::processors()) {
+        auto* table = cpu.profile_table();
+
+        if (!table || table->session() != session)
+            continue;
+
+        kernel_samples += table->kernel_samples();
+        user_samples += table->user_samples();
+        dropped_samples += table->dropped_samples();
+
+        for (auto& entry : *table) {
+            if (entry.total_samples == 0)
+                continue;
+
+            if (entry.is_user) {
+                user_entries.append(entry);
+                continue;
+            }
+
+            // Addresses without a symbol are all accounted under 0
+            auto* symbol = runtime::KernelSymbolTable::find_symbol(entry.address);
+            auto& function = functions[symbol ? symbol->address() : 0];
+
+            function.symbol = symbol;
+            function.self_samples += entry.self_samples;
+            function.total_samples += entry.total_samples;
+        }
+    }
+
+    string << "Samples: " << kernel_samples << " kernel, " << user_samples << " user, "
+           << dropped_samples << " dropped";
+
+    if (is_running())
+        string << " (still running)";
+
+    DynamicArray<FunctionSamples> hot_functions;
+    for (auto& function : functions)
+        hot_functions.append(function.second);
+
+    quick_sort(hot_functions.begin(), hot_functions.end(),
+        [](const FunctionSamples& l, const FunctionSamples& r) { return l.self_samples > r.self_samples; });
+
+    string << "\n\nKernel (self / total):";
+    for (size_t i = 0; i < min(top_n, hot_functions.size()); ++i) {
+        auto& function = hot_functions[i];
+
+        string << "\n";
+        append_percentage(string, function.self_samples, kernel_samples);
+        string << " / ";
+        append_percentage(string, function.total_samples, kernel_samples);
+        string << " " << (function.symbol ? function.symbol->name() : "??");
+    }
+
+    // Same address of the same process might show up in the tables of several processors
+    quick_sort(user_entries.begin(), user_entries.end(),
+        [](const ProfileTable::Entry& l, const ProfileTable::Entry& r) {
+            return l.process_id < r.process_id || (l.process_id == r.process_id && l.address < r.address);
+        });
+
+    size_t unique_entries = 0;
+    for (size_t i = 0; i < user_entries.size(); ++i) {
+        auto& entry = user_entries[i];
+
+        if (unique_entries) {
+            auto& last = user_entries[unique_entries - 1];
+
+            if (last.process_id == entry.process_id && last.address == entry.address) {
+                last.self_samples += entry.self_samples;
+                continue;
+            }
+        }
+
+        user_entries[unique_entries++] = entry;
+    }
+
+    quick_sort(user_entries.begin(), user_entries.begin() + unique_entries,
+        [](const ProfileTable::Entry& l, const ProfileTable::Entry& r) { return l.self_samples > r.self_samples; });
+
+    string << "\n\nUser (self):";
+    for (size_t i = 0; i < min(top_n, unique_entries); ++i) {
+        auto& entry = user_entries[i];
+
+        string << "\n";
+        append_percentage(string, entry.self_samples, user_samples);
+        string << " pid " << entry.process_id << " @ " << format::as_hex << entry.address << format::as_dec;
+    }
+
+    string << "\n";
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Common/Macros.h"
+#include "Common/String.h"
+#include "Common/Types.h"
+
+#include "Memory/Range.h"
+
+#include "Registers.h"
+
+namespace kernel {
+
+// Sample counts of one processor keyed by instruction address, open addressing with linear probing.
+// Only ever touched by its own processor from the timer interrupt, so sampling never takes a lock.
+// Readers look at it while it's being written, so the report might be off by a sample or two.
+class ProfileTable {
+    MAKE_NONCOPYABLE(ProfileTable);
+    MAKE_NONMOVABLE(ProfileTable);
+
+public:
+    ProfileTable() = default;
+
+    static constexpr size_t capacity = 1024;
+    static constexpr size_t max_probes = 16;
+
+    // Kernel samples also walk this many frames of the stack to count the callers
+    static constexpr size_t max_stack_depth = 4;
+
+    struct Entry {
+        ptr_t address;
+        u32 process_id; // only meaningful for user addresses
+        bool is_user;
+        u32 self_samples;
+        u32 total_samples;
+    };
+
+    // Kernel samples only follow frames that lie on the stack the interrupted code was running on,
+    // the walk is skipped if the registers aren't on it or the range is empty.
+    void record(const RegisterState&, u32 process_id, bool is_user, const Range& stack);
+
+    // Throws away everything recorded before if this table belongs to an older session
+    void begin_session(u32 session);
+    [[nodiscard]] u32 session() const { return m_session; }
+
+    // Counts down the ticks left until the next sample, returns true if this tick is sampled
+    bool consume_tick(u32 ticks_per_sample);
+
+    [[nodiscard]] const Entry* begin() const { return m_entries; }
+    [[nodiscard]] const Entry* end() const { return m_entries + capacity; }
+
+    [[nodiscard]] u64 kernel_samples() const { return m_kernel_samples; }
+    [[nodiscard]] u64 user_samples() const { return m_user_samples; }
+    [[nodiscard]] u64 dropped_samples() const { return m_dropped_samples; }
+
+private:
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    Entry* find_or_insert(ptr_t address, u32 process_id, bool is_user);
+
+    Entry m_entries[capacity] {};
+    u32 m_session { 0 };
+    u32 m_ticks_until_sample { 0 };
+    u64 m_kernel_samples { 0 };
+    u64 m_user_samples { 0 };
+    u64 m_dropped_samples { 0 };
+};
+
+// Statistical profiler sampling the interrupted instruction on every processor from the scheduler tick.
+// Kernel addresses are resolved through the kernel symbol table once a report is requested,
+// user addresses are reported as is along with the process they belong to.
+class Profiler {
+    MAKE_STATIC(Profiler);
+
+public:
+    static bool is_running() { return __atomic_load_n(&s_is_running, __ATOMIC_RELAXED); }
+
+    // The rate is rounded to a whole number of scheduler ticks, so it can't go above the tick rate.
+    // Allocates the tables of every processor on first use and discards samples of the previous run.
+    static void start(u32 samples_per_second);
+    static void stop();
+
+    // Must be called from the scheduler tick with interrupts disabled
+    static void on_tick(const RegisterState& registers)
+    {
+        if (is_running())
+            sample(registers);
+    }
+
+    static constexpr size_t default_report_length = 15;
+    static void report(String&, size_t top_n = default_report_length);
+
+private:
+    NOINLINE static void sample(const RegisterState&);
+
+    static bool s_is_running;
+    static u32 s_session;
+    static u32 s_ticks_per_sample;
+};
+}
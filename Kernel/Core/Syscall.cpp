@@ -3,6 +3,7 @@
 
 #include "Interrupts/Utilities.h"
 
+#include "Multitasking/Futex.h"
 #include "Multitasking/Scheduler.h"
 #include "Multitasking/Sleep.h"
 
@@ -11,6 +12,8 @@
 
 #include "Memory/SafeOperations.h"
 
+#include "Core/Tracer.h"
+
 #include "WindowManager/WindowManager.h"
 
 #include "Syscall.h"
@@ -44,12 +47,18 @@ void Syscall::invoke(RegisterState& registers)
         return;
     }
 
-    auto res = s_table[FUNCTION](registers);
+    // Same register as the return value
+    auto function = FUNCTION;
+    TRACE(SYSCALL_ENTER, function, ARG0);
+
+    auto res = s_table[function](registers);
 
     if (res.is_error())
         RETVAL = -res.error().value;
     else
         RETVAL = res.value();
+
+    TRACE(SYSCALL_EXIT, function, RETVAL);
 }
 
 SYSCALL_IMPLEMENTATION(EXIT_THREAD)
@@ -64,7 +73,7 @@ SYSCALL_IMPLEMENTATION(EXIT_PROCESS)
     Scheduler::the().exit_process(static_cast<i32>(ARG0));
 }
 
-static ErrorOr<StringView> copy_user_path(void* user_pointer, Span<char> kernel_buffer)
+ErrorOr<StringView> Syscall::copy_user_path(void* user_pointer, Span<char> kernel_buffer)
 {
     if (!MemoryManager::is_potentially_valid_userspace_pointer(user_pointer))
         return ErrorCode::MEMORY_ACCESS_VIOLATION;
@@ -365,6 +374,215 @@ SYSCALL_IMPLEMENTATION(DEBUG_LOG)
     return ErrorCode::NO_ERROR;
 }
 
+SYSCALL_IMPLEMENTATION(SET_PRIORITY)
+{
+    if (ARG0 > static_cast<size_t>(PriorityClass::BACKGROUND))
+        return ErrorCode::INVALID_ARGUMENT;
+
+    auto priority_class = static_cast<PriorityClass>(ARG0);
+
+    // A userland hog at this class would starve everything else for up to a starvation period
+    if (priority_class == PriorityClass::REALTIME)
+        return ErrorCode::ACCESS_DENIED;
+
+    Process::current().set_priority_class(priority_class);
+
+    return ErrorCode::NO_ERROR;
+}
+
+// Affinity and CPU time syscalls can only target the calling process or one of its threads,
+// id 0 meaning the caller itself
+static ErrorCode check_process_target(u32 id)
+{
+    if (id && id != Process::current().id())
+        return ErrorCode::ACCESS_DENIED;
+
+    return ErrorCode::NO_ERROR;
+}
+
+static ErrorOr<RefPtr<Thread>> find_thread_target(u32 id)
+{
+    auto& process = Process::current();
+    LOCK_GUARD(process.lock());
+
+    if (!id)
+        id = Thread::current()->id();
+
+    auto thread = process.threads().find(id);
+    if (thread == process.threads().end())
+        return ErrorCode::INVALID_ARGUMENT;
+
+    return *thread;
+}
+
+static ErrorOr<Thread::AffinityMask> affinity_of(AffinityScope scope, u32 id)
+{
+    if (scope == AffinityScope::PROCESS) {
+        auto code = check_process_target(id);
+        if (code.is_error())
+            return code;
+
+        return Process::current().affinity();
+    }
+
+    auto thread = find_thread_target(id);
+    if (thread.is_error())
+        return thread.error();
+
+    return thread.value()->affinity();
+}
+
+static ErrorCode set_affinity_of(AffinityScope scope, u32 id, Thread::AffinityMask affinity)
+{
+    if (scope == AffinityScope::PROCESS) {
+        auto code = check_process_target(id);
+        if (code.is_error())
+            return code;
+
+        Process::current().set_affinity(affinity);
+        return ErrorCode::NO_ERROR;
+    }
+
+    auto thread = find_thread_target(id);
+    if (thread.is_error())
+        return thread.error();
+
+    thread.value()->set_affinity(affinity);
+    return ErrorCode::NO_ERROR;
+}
+
+// The mask is passed by pointer so that it's 64 bits wide on 32-bit as well
+SYSCALL_IMPLEMENTATION(GET_AFFINITY)
+{
+    if (ARG0 > static_cast<size_t>(AffinityScope::PROCESS))
+        return ErrorCode::INVALID_ARGUMENT;
+    if (!MemoryManager::is_potentially_valid_userspace_pointer(ARG2))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    auto affinity_or_error = affinity_of(static_cast<AffinityScope>(ARG0), ARG1);
+    if (affinity_or_error.is_error())
+        return affinity_or_error.error();
+
+    auto affinity = affinity_or_error.value();
+    if (!safe_copy_memory(&affinity, Address(ARG2).as_pointer<void>(), sizeof(affinity)))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    return ErrorCode::NO_ERROR;
+}
+
+SYSCALL_IMPLEMENTATION(SET_AFFINITY)
+{
+    if (ARG0 > static_cast<size_t>(AffinityScope::PROCESS))
+        return ErrorCode::INVALID_ARGUMENT;
+    if (!MemoryManager::is_potentially_valid_userspace_pointer(ARG2))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    Thread::AffinityMask affinity;
+    if (!safe_copy_memory(Address(ARG2).as_pointer<void>(), &affinity, sizeof(affinity)))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    if (!Scheduler::is_valid_affinity(affinity))
+        return ErrorCode::INVALID_ARGUMENT;
+
+    auto code = set_affinity_of(static_cast<AffinityScope>(ARG0), ARG1, affinity);
+    if (code.is_error())
+        return code;
+
+    // Other threads move lazily, but there's no reason to make the caller wait for its next tick
+    if (!Thread::current()->can_run_on(CPU::current()))
+        Scheduler::the().yield();
+
+    return ErrorCode::NO_ERROR;
+}
+
+SYSCALL_IMPLEMENTATION(GET_CPU_TIMES)
+{
+    if (ARG0 > static_cast<size_t>(AffinityScope::PROCESS))
+        return ErrorCode::INVALID_ARGUMENT;
+    if (!MemoryManager::is_potentially_valid_userspace_pointer(ARG2))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    CPUTimes times;
+
+    if (static_cast<AffinityScope>(ARG0) == AffinityScope::PROCESS) {
+        auto code = check_process_target(ARG1);
+        if (code.is_error())
+            return code;
+
+        times = Process::current().cpu_times();
+    } else {
+        auto thread = find_thread_target(ARG1);
+        if (thread.is_error())
+            return thread.error();
+
+        times = thread.value()->cpu_times();
+    }
+
+    if (!safe_copy_memory(&times, Address(ARG2).as_pointer<void>(), sizeof(times)))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    return ErrorCode::NO_ERROR;
+}
+
+SYSCALL_IMPLEMENTATION(TRACE_CONTROL)
+{
+    switch (static_cast<TraceCommand>(ARG0)) {
+    case TraceCommand::ENABLE:
+        Tracer::enable();
+        return ErrorCode::NO_ERROR;
+    case TraceCommand::DISABLE:
+        Tracer::disable();
+        return ErrorCode::NO_ERROR;
+    case TraceCommand::READ: {
+        // The copy goes through safe_copy_memory, so the entire range must be checked, not just the start
+        if (ARG2 > (~static_cast<ptr_t>(0) - ARG1) / sizeof(TraceEvent))
+            return ErrorCode::INVALID_ARGUMENT;
+        if (!MemoryManager::is_potentially_valid_userspace_pointer(ARG1))
+            return ErrorCode::MEMORY_ACCESS_VIOLATION;
+        if (!MemoryManager::is_potentially_valid_userspace_pointer(ARG1 + ARG2 * sizeof(TraceEvent)))
+            return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+        auto count = Tracer::read_to_user(Address(ARG1).as_pointer<TraceEvent>(), ARG2);
+        if (count.is_error())
+            return count.error();
+
+        return count.value();
+    }
+    default:
+        return ErrorCode::INVALID_ARGUMENT;
+    }
+}
+
+SYSCALL_IMPLEMENTATION(IO_RING_SETUP)
+{
+    auto address = IORing::setup_for_current_process(ARG0);
+
+    if (address.is_error())
+        return address.error();
+
+    return address.value().raw();
+}
+
+SYSCALL_IMPLEMENTATION(IO_RING_ENTER)
+{
+    auto* ring = Process::current().io_ring();
+
+    if (!ring)
+        return ErrorCode::INVALID_ARGUMENT;
+
+    return ring->enter(ARG0, ARG1);
+}
+
+SYSCALL_IMPLEMENTATION(FUTEX_WAIT)
+{
+    return Futex::wait(ARG0, ARG1, ARG2);
+}
+
+SYSCALL_IMPLEMENTATION(FUTEX_WAKE)
+{
+    return Futex::wake(ARG0, ARG1);
+}
+
 SYSCALL_IMPLEMENTATION(MAX)
 {
     runtime::panic("Invoked MAX syscall");
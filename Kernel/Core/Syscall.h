@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common/Macros.h"
+#include "Common/Span.h"
 #include "Common/Types.h"
 #include "Core/ErrorCode.h"
 #include "Shared/Syscalls.h"
@@ -39,6 +40,9 @@ public:
 
     static void invoke(RegisterState&);
 
+    // Copies a path from userland into kernel_buffer, relative paths are resolved against the working directory
+    static ErrorOr<StringView> copy_user_path(void* user_pointer, Span<char> kernel_buffer);
+
 private:
     static ErrorOr<ptr_t> (*s_table[static_cast<size_t>(NumberOf::MAX) + 1])(RegisterState&);
 };
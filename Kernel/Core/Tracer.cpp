@@ -0,0 +1,142 @@
+#include "Common/Lock.h"
+
+#include "Interrupts/Utilities.h"
+
+#include "Memory/SafeOperations.h"
+
+#include "Multitasking/Mutex.h"
+#include "Multitasking/Process.h"
+
+#include "Time/TSC.h"
+
+#include "CPU.h"
+#include "Tracer.h"
+
+namespace kernel {
+
+bool Tracer::s_is_enabled;
+
+// Buffers are allocated with this held, so it can't be a spin lock
+static Mutex s_buffers_lock;
+static Mutex s_read_lock;
+
+void TraceBuffer::record(const TraceEvent& event)
+{
+    auto head = m_head.load(MemoryOrder::RELAXED);
+
+    m_events[head & (capacity - 1)] = event;
+    m_head.store(head + 1, MemoryOrder::RELEASE);
+}
+
+size_t TraceBuffer::read(TraceEvent* events, size_t max_count)
+{
+    auto head = m_head.load(MemoryOrder::ACQUIRE);
+    auto oldest = head > capacity ? head - capacity : 0;
+    auto begin = max(m_read_position, oldest);
+    auto count = min<u64>(head - begin, max_count);
+
+    for (size_t i = 0; i < count; ++i)
+        events[i] = m_events[(begin + i) & (capacity - 1)];
+
+    m_read_position = begin + count;
+
+    // Make sure the copies are done before we look at how far the writer got since
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    auto new_head = m_head.load(MemoryOrder::RELAXED);
+
+    // The writer might be in the middle of overwriting the slot after new_head as well
+    auto overwritten_until = new_head + 1 > capacity ? new_head + 1 - capacity : 0;
+
+    if (overwritten_until <= begin)
+        return count;
+
+    auto overwritten = min<u64>(overwritten_until - begin, count);
+
+    for (size_t i = overwritten; i < count; ++i)
+        events[i - overwritten] = events[i];
+
+    return count - overwritten;
+}
+
+void Tracer::enable()
+{
+    {
+        LOCK_GUARD(s_buffers_lock);
+
+        for (auto& cpu : CPU::processors()) {
+            if (!cpu.trace_buffer())
+                cpu.set_trace_buffer(new TraceBuffer);
+        }
+    }
+
+    __atomic_store_n(&s_is_enabled, true, __ATOMIC_RELEASE);
+}
+
+void Tracer::disable()
+{
+    __atomic_store_n(&s_is_enabled, false, __ATOMIC_RELEASE);
+}
+
+u64 Tracer::key_of(Thread& thread)
+{
+    return (static_cast<u64>(thread.owner().id()) << 32) | thread.id();
+}
+
+void Tracer::record(TraceEventType type, u64 arg0, u64 arg1)
+{
+    Interrupts::ScopedDisabler d;
+
+    auto& cpu = CPU::current();
+    auto* buffer = cpu.trace_buffer();
+
+    // Tracing got enabled but we haven't seen the buffer yet
+    if (!buffer)
+        return;
+
+    auto* thread = cpu.current_thread();
+
+    TraceEvent event {};
+    event.timestamp_ns = CPU::read_tsc();
+    event.thread = thread ? key_of(*thread) : 0;
+    event.arg0 = arg0;
+    event.arg1 = arg1;
+    event.type = static_cast<u16>(type);
+    event.processor = cpu.index();
+
+    buffer->record(event);
+}
+
+ErrorOr<size_t> Tracer::read_to_user(TraceEvent* user_events, size_t max_count)
+{
+    static constexpr size_t events_per_copy = 16;
+    TraceEvent events[events_per_copy];
+
+    LOCK_GUARD(s_read_lock);
+
+    size_t total = 0;
+
+    for (auto& cpu : CPU::processors()) {
+        auto* buffer = cpu.trace_buffer();
+
+        if (!buffer)
+            continue;
+
+        while (total < max_count) {
+            auto count = buffer->read(events, min(events_per_copy, max_count - total));
+
+            if (!count)
+                break;
+
+            for (size_t i = 0; i < count; ++i)
+                events[i].timestamp_ns = TSC::cycles_to_nanoseconds(events[i].timestamp_ns);
+
+            if (!safe_copy_memory(events, user_events + total, count * sizeof(TraceEvent)))
+                return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+            total += count;
+        }
+    }
+
+    return total;
+}
+}
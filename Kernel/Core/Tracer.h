@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Macros.h"
+#include "Common/Types.h"
+#include "Core/ErrorCode.h"
+
+#include <Shared/Trace.h>
+
+namespace kernel {
+
+class Thread;
+
+enum class TraceEventType : u16 {
+#define TRACE_EVENT_TYPE(name) name,
+    ENUMERATE_TRACE_EVENT_TYPES
+#undef TRACE_EVENT_TYPE
+};
+
+enum class TraceCommand : u8 {
+#define TRACE_COMMAND(name) name,
+    ENUMERATE_TRACE_COMMANDS
+#undef TRACE_COMMAND
+};
+
+// Ring of the most recent events of one processor, older events get overwritten once it's full.
+// Only ever written by its own processor with interrupts disabled, so recording never takes a lock.
+// Readers copy without stopping the writer and throw away whatever got overwritten in the meantime.
+class TraceBuffer {
+    MAKE_NONCOPYABLE(TraceBuffer);
+    MAKE_NONMOVABLE(TraceBuffer);
+
+public:
+    TraceBuffer() = default;
+
+    static constexpr size_t capacity = 2048;
+
+    void record(const TraceEvent&);
+
+    // Copies up to max_count events that haven't been read yet, oldest first.
+    // Concurrent readers must be serialized by the caller.
+    size_t read(TraceEvent* events, size_t max_count);
+
+private:
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    TraceEvent m_events[capacity] {};
+    Atomic<u64> m_head { 0 }; // free running, number of events ever recorded
+    u64 m_read_position { 0 };
+};
+
+// Static tracepoints for the scheduler, interrupts, page faults and system calls, see Shared/Trace.h.
+// While disabled a tracepoint costs a load and a branch, its arguments aren't even evaluated.
+class Tracer {
+    MAKE_STATIC(Tracer);
+
+public:
+    static bool is_enabled() { return __atomic_load_n(&s_is_enabled, __ATOMIC_RELAXED); }
+
+    // Allocates the buffers of every processor on first use
+    static void enable();
+    static void disable();
+
+    NOINLINE static void record(TraceEventType, u64 arg0, u64 arg1);
+
+    static u64 key_of(Thread&);
+
+    // Returns the number of events copied
+    static ErrorOr<size_t> read_to_user(TraceEvent* user_events, size_t max_count);
+
+private:
+    static bool s_is_enabled;
+};
+
+#define TRACE(type, arg0, arg1)                                                             \
+    do {                                                                                    \
+        if (::kernel::Tracer::is_enabled())                                                 \
+            ::kernel::Tracer::record(::kernel::TraceEventType::type, (arg0), (arg1));       \
+    } while (0)
+}
@@ -156,8 +156,8 @@ void AHCI::initialize_port(size_t index)
     port.has_device_attached = true;
 
     // FIXME: phys memory leak here
-    auto command_list_page = allocate_safe_page();
-    auto base_fis_page = allocate_safe_page();
+    auto command_list_page = allocate_safe_pages();
+    auto base_fis_page = allocate_safe_pages();
 
     auto& this_port = m_hba->ports[index];
 
@@ -166,10 +166,12 @@ void AHCI::initialize_port(size_t index)
 
     port.command_list = TypedMapping<CommandList>::create("AHCI Command List"_sv, command_list_page);
 
+    auto command_tables = allocate_safe_pages(m_command_slots_per_port);
+
     for (size_t i = 0; i < m_command_slots_per_port; ++i) {
         auto& command = port.command_list->commands[i];
 
-        auto page = allocate_safe_page();
+        auto page = command_tables + i * Page::size;
         SET_DWORDS_TO_ADDRESS(command.command_table_base_address, command.command_table_base_address_upper, page);
     }
 
@@ -361,7 +363,7 @@ void AHCI::identify_sata_port(size_t index)
 
     auto& port = m_ports[index];
     auto& command_header_0 = port.command_list->commands[command_slot_for_identify];
-    Address identify_base = allocate_safe_page();
+    Address identify_base = allocate_safe_pages();
 
     Address command_table_0_phys = ADDRESS_FROM_TWO_DWORDS(command_header_0.command_table_base_address, command_header_0.command_table_base_address_upper);
     auto command_table_0 = TypedMapping<CommandTable>::create("AHCI command table"_sv, command_table_0_phys, sizeof(CommandTable) + sizeof(PRDTEntry));
@@ -804,8 +806,8 @@ void AHCI::hba_reset()
 
     enable_ahci();
     auto pi = m_hba->ports_implemented;
-    auto fis_receive_page = allocate_safe_page();
-    auto command_list_page = allocate_safe_page();
+    auto fis_receive_page = allocate_safe_pages();
+    auto command_list_page = allocate_safe_pages();
 
     auto fis_res = TypedMapping<u8>::create("HBA RESET"_sv, fis_receive_page, Page::size);
 
@@ -943,16 +945,15 @@ void AHCI::autodetect(const DynamicArray<PCI::DeviceInfo>& devices)
     }
 }
 
-Address AHCI::allocate_safe_page()
+Address AHCI::allocate_safe_pages(size_t count)
 {
-    auto page = MemoryManager::the().allocate_page();
+    auto ceiling = m_supports_64bit ? MemoryManager::max_memory_address.raw() : 0xFFFFFFFF;
+    auto pages = MemoryManager::the().allocate_contiguous_pages(count, Page::size, ceiling);
 
-#ifdef ULTRA_64
-    if (page.address() > 0xFFFFF000 && !m_supports_64bit)
-        runtime::panic("AHCI: Couldn't allocate a suitable page for controller");
-#endif
+    if (!pages)
+        runtime::panic("AHCI: Couldn't allocate suitable pages for controller");
 
-    return page.address();
+    return *pages;
 }
 
 Optional<size_t> AHCI::PortState::allocate_slot()
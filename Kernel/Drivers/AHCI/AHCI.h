@@ -97,6 +97,8 @@ public:
         void deallocate_slot(size_t);
 
         struct QueuedRequest : StandaloneListNode<QueuedRequest> {
+            MAKE_SLAB_ALLOCATED(QueuedRequest)
+
             StorageDevice::AsyncRequest* request;
             List<OP> queued_ops;
         };
@@ -164,7 +166,8 @@ private:
     template <typename T>
     void port_write(size_t index, T reg);
 
-    Address allocate_safe_page();
+    // Physically contiguous pages the controller can address
+    Address allocate_safe_pages(size_t count = 1);
 
 private:
     TypedMapping<volatile HBA> m_hba;
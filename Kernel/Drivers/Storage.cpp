@@ -11,27 +11,42 @@ StorageDevice::Request::Request(Address virtual_address, OP op, Type type)
 
 StorageDevice::AsyncRequest::AsyncRequest(Address virtual_address, LBARange lba_range, Request::OP op)
     : Request(virtual_address, op, Type::ASYNC)
-    , m_blocker(*Thread::current())
     , m_lba_range(lba_range)
 {
 }
 
 ErrorCode StorageDevice::AsyncRequest::wait()
 {
-    if (m_is_completed.load(MemoryOrder::ACQUIRE))
-        return result();
+    DiskIOBlocker blocker(*Thread::current());
+    WaitQueue::Entry entry(blocker);
+
+    {
+        LOCK_GUARD(m_lock);
+
+        if (m_is_completed)
+            return result();
+
+        m_waiters.add(entry);
+    }
+
+    blocker.block();
+
+    // complete() might still be holding the lock, the request must outlive that
+    LOCK_GUARD(m_lock);
+    ASSERT(m_is_completed);
 
-    m_blocker.block();
     return result();
 }
 
 void StorageDevice::AsyncRequest::complete(ErrorCode code)
 {
-    ASSERT(!m_is_completed.load(MemoryOrder::ACQUIRE));
+    LOCK_GUARD(m_lock);
+
+    ASSERT(!m_is_completed);
 
     set_result(code);
-    m_blocker.unblock();
-    m_is_completed.store(true, MemoryOrder::RELEASE);
+    m_is_completed = true;
+    m_waiters.wake_all();
 }
 
 StorageDevice::RamdiskRequest::RamdiskRequest(Address virtual_address, size_t byte_offset, size_t byte_count, OP op)
@@ -4,6 +4,7 @@
 #include "Memory/MemoryManager.h"
 #include "Multitasking/Blocker.h"
 #include "Multitasking/Scheduler.h"
+#include "Multitasking/WaitQueue.h"
 
 namespace kernel {
 
@@ -113,9 +114,12 @@ public:
         [[nodiscard]] LBARange lba_range() const { return m_lba_range; }
 
     private:
-        DiskIOBlocker m_blocker;
         LBARange m_lba_range;
-        Atomic<bool> m_is_completed { false };
+
+        // complete() is called from IRQ context, possibly before anyone starts waiting
+        InterruptSafeSpinLock m_lock;
+        WaitQueue m_waiters;
+        bool m_is_completed { false };
     };
 
     class RamdiskRequest : public Request {
@@ -45,6 +45,8 @@ private:
     u64 block_index_to_cached_index(u64 block_index);
 
     struct CachedBlock : public StandaloneListNode<CachedBlock> {
+        MAKE_SLAB_ALLOCATED(CachedBlock)
+
         Address virtual_address_and_dirty_bit { nullptr };
         u64 first_block { 0 };
 
@@ -0,0 +1,316 @@
+#include "Core/Syscall.h"
+
+#include "Memory/MemoryManager.h"
+#include "Memory/SharedVirtualRegion.h"
+
+#include "Multitasking/Process.h"
+#include "Multitasking/Sleep.h"
+
+#include "IORing.h"
+#include "VFS.h"
+
+namespace kernel {
+
+// The indices live in memory shared with userland, so they need proper ordering on both sides
+static u32 load_acquire(const u32& value)
+{
+    return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+}
+
+static void store_release(u32& value, u32 new_value)
+{
+    __atomic_store_n(&value, new_value, __ATOMIC_RELEASE);
+}
+
+ErrorOr<Address> IORing::setup_for_current_process(size_t submission_entries)
+{
+    if (submission_entries == 0 || submission_entries > max_submission_entries)
+        return ErrorCode::INVALID_ARGUMENT;
+
+    auto& process = Process::current();
+
+    if (process.io_ring())
+        return ErrorCode::INVALID_ARGUMENT;
+
+    // Indices wrap around freely, so the entry counts have to be powers of two
+    size_t rounded_entries = 1;
+    while (rounded_entries < submission_entries)
+        rounded_entries *= 2;
+    submission_entries = rounded_entries;
+
+    // Pending operations complete later, leave them some room
+    auto completion_entries = submission_entries * 2;
+
+    auto length = Page::round_up(
+        sizeof(IORingHeader)
+        + submission_entries * sizeof(IORingSubmission)
+        + completion_entries * sizeof(IORingCompletion));
+
+    auto kernel_region = MemoryManager::the().allocate_kernel_shared("io ring"_sv, length);
+    static_cast<SharedVirtualRegion*>(kernel_region.get())->preallocate_entire();
+
+    auto* ring = new IORing(kernel_region, submission_entries, completion_entries);
+
+    // Another thread might've been faster
+    if (!process.install_io_ring(*ring)) {
+        delete ring;
+        return ErrorCode::INVALID_ARGUMENT;
+    }
+
+    auto user_region = MemoryManager::the().allocate_user_shared(
+        static_cast<SharedVirtualRegion&>(*kernel_region),
+        AddressSpace::current());
+    process.store_region(user_region);
+
+    return user_region->virtual_range().begin();
+}
+
+IORing::IORing(const RefPtr<VirtualRegion>& region, size_t submission_entries, size_t completion_entries)
+    : m_region(region)
+    , m_submission_entries(submission_entries)
+    , m_completion_entries(completion_entries)
+{
+    auto base = m_region->virtual_range().begin();
+
+    m_header = base.as_pointer<IORingHeader>();
+    m_header->submission_entry_count = m_submission_entries;
+    m_header->completion_entry_count = m_completion_entries;
+    m_header->submission_offset = sizeof(IORingHeader);
+    m_header->completion_offset = sizeof(IORingHeader) + m_submission_entries * sizeof(IORingSubmission);
+
+    m_submissions = Address(base + m_header->submission_offset).as_pointer<IORingSubmission>();
+    m_completions = Address(base + m_header->completion_offset).as_pointer<IORingCompletion>();
+
+    m_pending.reserve(m_submission_entries);
+}
+
+IORing::~IORing()
+{
+    MemoryManager::the().free_virtual_region(*m_region);
+}
+
+ErrorOr<size_t> IORing::enter(size_t to_submit, size_t min_completions)
+{
+    LOCK_GUARD(m_lock);
+
+    // Earlier submissions go first
+    size_t completions = retry_pending();
+
+    auto head = m_header->submission_head;
+    auto available = load_acquire(m_header->submission_tail) - head;
+
+    if (available > m_submission_entries)
+        return ErrorCode::INVALID_ARGUMENT;
+
+    to_submit = min<size_t>(to_submit, available);
+    size_t submitted = 0;
+
+    // Every operation might complete right away, so don't take more than we have room for
+    for (; submitted < to_submit; ++submitted) {
+        if (m_pending.size() + m_waited_operations == m_submission_entries || completion_space() == 0)
+            break;
+
+        Operation operation {};
+
+        // Copied, userland is free to scribble over the entry at any point
+        copy_memory(&m_submissions[(head + submitted) & (m_submission_entries - 1)], &operation.submission, sizeof(IORingSubmission));
+
+        if (!prepare(operation)) {
+            ++completions;
+            continue;
+        }
+
+        auto result = try_complete(operation, false);
+
+        if (!result) {
+            m_pending.append(move(operation));
+            continue;
+        }
+
+        post_completion(operation.submission.user_data, result.value());
+        ++completions;
+    }
+
+    store_release(m_header->submission_head, head + submitted);
+
+    // Wait for the oldest operation, others might have become ready in the meantime.
+    // The lock is dropped while waiting, it might be another thread of this process that unblocks us.
+    while (completions < min_completions && !m_pending.empty() && completion_space()) {
+        if (Thread::current()->should_die())
+            break;
+
+        auto operation = move(m_pending.first());
+        m_pending.erase_at(0);
+        ++m_waited_operations;
+
+        m_lock.unlock();
+        auto result = try_complete(operation, true);
+        m_lock.lock();
+
+        --m_waited_operations;
+        post_completion(operation.submission.user_data, result.value());
+        ++completions;
+
+        completions += retry_pending();
+    }
+
+    return submitted;
+}
+
+size_t IORing::retry_pending()
+{
+    size_t completions = 0;
+
+    for (size_t i = 0; i < m_pending.size() && completion_space();) {
+        auto& operation = m_pending.at(i);
+        auto result = try_complete(operation, false);
+
+        if (!result) {
+            ++i;
+            continue;
+        }
+
+        post_completion(operation.submission.user_data, result.value());
+        m_pending.erase_at(i);
+        ++completions;
+    }
+
+    return completions;
+}
+
+bool IORing::prepare(Operation& operation)
+{
+    auto& submission = operation.submission;
+
+    switch (submission.operation) {
+    case IORingOperation::READ:
+    case IORingOperation::WRITE:
+        operation.stream = Process::current().io_stream(submission.handle);
+
+        if (!operation.stream) {
+            post_completion(submission.user_data, ErrorCode::INVALID_ARGUMENT);
+            return false;
+        }
+
+        if (!MemoryManager::is_potentially_valid_userspace_pointer(submission.buffer)) {
+            post_completion(submission.user_data, ErrorCode::MEMORY_ACCESS_VIOLATION);
+            return false;
+        }
+
+        return true;
+    case IORingOperation::SLEEP:
+        operation.deadline = Timer::nanoseconds_since_boot() + submission.length;
+        return true;
+    case IORingOperation::NOP:
+    case IORingOperation::OPEN:
+    case IORingOperation::CLOSE:
+        return true;
+    default:
+        post_completion(submission.user_data, ErrorCode::INVALID_ARGUMENT);
+        return false;
+    }
+}
+
+Optional<ErrorOr<size_t>> IORing::try_complete(Operation& operation, bool may_block)
+{
+    auto& submission = operation.submission;
+    auto buffer = Address(submission.buffer).as_pointer<void>();
+
+    switch (submission.operation) {
+    case IORingOperation::NOP:
+        return ErrorOr<size_t>(0);
+    case IORingOperation::READ:
+    case IORingOperation::WRITE: {
+        bool is_read = submission.operation == IORingOperation::READ;
+        auto& stream = *operation.stream;
+
+        // Would never see any progress below
+        if (submission.length == 0)
+            return ErrorOr<size_t>(0);
+
+        // Same semantics as the READ/WRITE syscalls
+        for (;;) {
+            bool can_proceed = is_read ? stream.can_read_without_blocking() : stream.can_write_without_blocking();
+
+            if (!can_proceed) {
+                if (!may_block)
+                    return {};
+
+                auto ret = is_read ? stream.block_until_readable() : stream.block_until_writable();
+
+                if (ret.is_error())
+                    return ErrorOr<size_t>(ret.error());
+                if (ret.value() == Blocker::Result::INTERRUPTED)
+                    return ErrorOr<size_t>(ErrorCode::INTERRUPTED);
+            }
+
+            auto ret = is_read ? stream.read(buffer, submission.length) : stream.write(buffer, submission.length);
+
+            if (ret.is_error() || ret.value() != 0)
+                return ret;
+
+            if (!may_block)
+                return {};
+        }
+    }
+    case IORingOperation::OPEN: {
+        char path_buffer[File::max_name_length + 1];
+        auto path = Syscall::copy_user_path(buffer, path_buffer);
+
+        if (path.is_error())
+            return ErrorOr<size_t>(path.error());
+
+        auto file = VFS::the().open(path.value(), static_cast<IOMode>(submission.length));
+
+        if (file.is_error())
+            return ErrorOr<size_t>(file.error());
+
+        auto id = Process::current().store_io_stream(file.value());
+
+        if (id.is_error()) {
+            file.value()->close();
+            return ErrorOr<size_t>(id.error());
+        }
+
+        return ErrorOr<size_t>(id.value());
+    }
+    case IORingOperation::CLOSE: {
+        auto stream = Process::current().pop_io_stream(submission.handle);
+        return stream ? stream->close() : ErrorOr<size_t>(ErrorCode::INVALID_ARGUMENT);
+    }
+    case IORingOperation::SLEEP:
+        if (Timer::nanoseconds_since_boot() < operation.deadline) {
+            if (!may_block)
+                return {};
+
+            sleep::until(operation.deadline);
+        }
+
+        return ErrorOr<size_t>(0);
+    default:
+        ASSERT_NEVER_REACHED();
+    }
+}
+
+size_t IORing::completion_space()
+{
+    auto used = m_header->completion_tail - load_acquire(m_header->completion_head);
+
+    // Userland messed up its head, don't overwrite anything until it's fixed
+    if (used + m_waited_operations > m_completion_entries)
+        return 0;
+
+    return m_completion_entries - used - m_waited_operations;
+}
+
+void IORing::post_completion(u64 user_data, ErrorOr<size_t> result)
+{
+    auto tail = m_header->completion_tail;
+    auto& completion = m_completions[tail & (m_completion_entries - 1)];
+
+    completion.user_data = user_data;
+    completion.result = result.is_error() ? -static_cast<i64>(result.error().value) : static_cast<i64>(result.value());
+
+    store_release(m_header->completion_tail, tail + 1);
+}
+}
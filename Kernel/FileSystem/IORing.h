@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Common/DynamicArray.h"
+#include "Common/Optional.h"
+#include "Common/RefPtr.h"
+#include "Core/ErrorCode.h"
+#include "Memory/VirtualRegion.h"
+#include "Multitasking/Mutex.h"
+
+#include "IOStream.h"
+
+#include <Shared/IORingOperations.h>
+
+namespace kernel {
+
+enum class IORingOperation : u32 {
+#define IO_RING_OPERATION(name) name,
+    ENUMERATE_IO_RING_OPERATIONS
+#undef IO_RING_OPERATION
+};
+
+}
+
+#define IO_RING_OPERATION_TYPE kernel::IORingOperation
+
+#include <Shared/IORing.h>
+
+namespace kernel {
+
+// A submission/completion ring pair shared with userland, lets a process queue up
+// many I/O operations and pick up their results without trapping for every single one.
+// Operations that can't finish without blocking are kept pending inside the ring
+// and retried on every enter(), or waited for if the caller asks for completions.
+class IORing {
+    MAKE_NONCOPYABLE(IORing);
+    MAKE_NONMOVABLE(IORing);
+
+public:
+    static constexpr size_t max_submission_entries = 256;
+
+    // Creates the ring of the current process and maps it, returns the userland address of the header
+    static ErrorOr<Address> setup_for_current_process(size_t submission_entries);
+
+    // Consumes up to to_submit submissions, then waits until at least min_completions
+    // operations have completed during this call or nothing is left to wait for.
+    // Returns the number of submissions consumed.
+    ErrorOr<size_t> enter(size_t to_submit, size_t min_completions);
+
+    ~IORing();
+
+private:
+    IORing(const RefPtr<VirtualRegion>& region, size_t submission_entries, size_t completion_entries);
+
+    struct Operation {
+        IORingSubmission submission;
+        RefPtr<IOStream> stream;
+        u64 deadline { 0 };
+    };
+
+    // Looks up everything the operation refers to, returns false if it failed right away
+    bool prepare(Operation&);
+
+    // Returns the result of the operation, or nothing if it can't make progress yet and may_block is false.
+    // Doesn't touch the ring, so the lock doesn't have to be held for blocking calls.
+    Optional<ErrorOr<size_t>> try_complete(Operation&, bool may_block);
+
+    size_t retry_pending();
+    size_t completion_space();
+    void post_completion(u64 user_data, ErrorOr<size_t> result);
+
+private:
+    Mutex m_lock;
+
+    RefPtr<VirtualRegion> m_region;
+    IORingHeader* m_header { nullptr };
+    IORingSubmission* m_submissions { nullptr };
+    IORingCompletion* m_completions { nullptr };
+
+    u32 m_submission_entries { 0 };
+    u32 m_completion_entries { 0 };
+
+    // Submitted operations that would've blocked, oldest first
+    DynamicArray<Operation> m_pending;
+
+    // Taken off m_pending and waited for without the lock, each one keeps a completion entry reserved
+    size_t m_waited_operations { 0 };
+};
+}
@@ -83,10 +83,11 @@ ErrorOr<size_t> Pipe::read(void* buffer, size_t bytes)
             m_state->read_offset = 0;
     }
 
-    while (!m_state->write_waiters.empty()) {
-        auto& waiter = m_state->write_waiters.pop_front();
-        waiter.unblock();
-    }
+    // Only one writer is woken up at a time, it passes the wake up on if there's space left after it
+    m_state->write_waiters.wake_one();
+
+    if (m_state->size != 0)
+        m_state->read_waiters.wake_one();
 
     return final_bytes_read;
 }
@@ -130,10 +131,11 @@ ErrorOr<size_t> Pipe::write(const void* buffer, size_t bytes)
             m_state->write_offset = 0;
     }
 
-    while (!m_state->read_waiters.empty()) {
-        auto& waiter = m_state->read_waiters.pop_front();
-        waiter.unblock();
-    }
+    // Same as above, one reader at a time
+    m_state->read_waiters.wake_one();
+
+    if (m_state->capacity != m_state->size)
+        m_state->write_waiters.wake_one();
 
     return final_write_size;
 }
@@ -150,20 +152,14 @@ ErrorCode Pipe::close()
 
         // since there are no more readers, write waiters will never wake up otherwise.
         if (new_count == 0) {
-            while (!m_state->write_waiters.empty()) {
-                auto& waiter = m_state->write_waiters.pop_front();
-                waiter.unblock();
-            }
+            m_state->write_waiters.wake_all();
         }
     } else {
         auto new_count = --m_state->writer_count;
 
         // since there are no more writers, read waiters will never wake up otherwise.
         if (new_count == 0) {
-            while (!m_state->read_waiters.empty()) {
-                auto& waiter = m_state->read_waiters.pop_front();
-                waiter.unblock();
-            }
+            m_state->read_waiters.wake_all();
         }
     }
 
@@ -178,6 +174,7 @@ ErrorOr<Blocker::Result> Pipe::block_until_readable()
 
     auto* current_thread = Thread::current();
     IOBlocker blocker(*current_thread);
+    WaitQueue::Entry entry(blocker);
 
     {
         LOCK_GUARD(m_state->lock);
@@ -189,15 +186,18 @@ ErrorOr<Blocker::Result> Pipe::block_until_readable()
         if (m_state->writer_count == 0)
             return ErrorCode::WOULD_BLOCK_FOREVER;
 
-        m_state->read_waiters.insert_back(blocker);
+        m_state->read_waiters.add(entry);
     }
 
     auto res = blocker.block();
 
     {
         LOCK_GUARD(m_state->lock);
-        if (blocker.is_on_a_list())
-            blocker.pop_off();
+        m_state->read_waiters.remove(entry);
+
+        // We might've been the one picked to make progress, pass it on
+        if (res != Blocker::Result::UNBLOCKED && m_state->size != 0)
+            m_state->read_waiters.wake_one();
     }
 
     return res;
@@ -210,6 +210,7 @@ ErrorOr<Blocker::Result> Pipe::block_until_writable()
 
     auto* current_thread = Thread::current();
     IOBlocker blocker(*current_thread);
+    WaitQueue::Entry entry(blocker);
 
     {
         LOCK_GUARD(m_state->lock);
@@ -221,15 +222,18 @@ ErrorOr<Blocker::Result> Pipe::block_until_writable()
         if (m_state->reader_count == 0)
             return ErrorCode::WOULD_BLOCK_FOREVER;
 
-        m_state->write_waiters.insert_back(blocker);
+        m_state->write_waiters.add(entry);
     }
 
     auto res = blocker.block();
 
     {
         LOCK_GUARD(m_state->lock);
-        if (blocker.is_on_a_list())
-            blocker.pop_off();
+        m_state->write_waiters.remove(entry);
+
+        // We might've been the one picked to make progress, pass it on
+        if (res != Blocker::Result::UNBLOCKED && m_state->capacity != m_state->size)
+            m_state->write_waiters.wake_one();
     }
 
     return res;
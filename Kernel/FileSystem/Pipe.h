@@ -2,6 +2,7 @@
 
 #include "IOStream.h"
 #include "Memory/MemoryManager.h"
+#include "Multitasking/WaitQueue.h"
 
 namespace kernel {
 
@@ -38,8 +39,8 @@ private:
         size_t size { 0 };
 
         InterruptSafeSpinLock lock;
-        List<IOBlocker> read_waiters;
-        List<IOBlocker> write_waiters;
+        WaitQueue read_waiters;
+        WaitQueue write_waiters;
         MemoryManager::VR buffer;
 
         ~State();
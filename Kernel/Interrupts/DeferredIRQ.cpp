@@ -23,9 +23,8 @@ void DeferredIRQHandler::deferred_invoke()
 
 void DeferredIRQManager::request_invocation()
 {
-    LOCK_GUARD(m_blocker_access_lock);
-    if (m_blocker)
-        m_blocker->unblock();
+    LOCK_GUARD(m_waiters_lock);
+    m_waiters.wake_one();
 }
 
 void DeferredIRQManager::register_handler(DeferredIRQHandler& handler)
@@ -53,16 +52,17 @@ void DeferredIRQManager::do_run_handlers()
 
     // The reason this loop is so weird is that we don't want to
     // ever go into a blocked state whenever there's a pending deferred IRQ.
-    // With this setup it's currently impossible since we set the blocker before
+    // With this setup it's currently impossible since we add ourselves to the wait queue before
     // actually running the handlers. If we get an invocation request before
     // calling block(), the block call itself will instantly return without
     // actually blocking the thread, and we will go to the next iteration.
     for (;;) {
         IRQBlocker irq_blocker(*current_thread);
+        WaitQueue::Entry entry(irq_blocker);
 
         {
-            LOCK_GUARD(instance.m_blocker_access_lock);
-            instance.m_blocker = &irq_blocker;
+            LOCK_GUARD(instance.m_waiters_lock);
+            instance.m_waiters.add(entry);
         }
 
         {
@@ -77,8 +77,8 @@ void DeferredIRQManager::do_run_handlers()
         ASSERT(res == Blocker::Result::UNBLOCKED);
 
         {
-            LOCK_GUARD(instance.m_blocker_access_lock);
-            instance.m_blocker = nullptr;
+            LOCK_GUARD(instance.m_waiters_lock);
+            instance.m_waiters.remove(entry);
         }
     }
 }
@@ -88,7 +88,8 @@ void DeferredIRQManager::initialize()
     ASSERT(s_instance == nullptr);
     s_instance = new DeferredIRQManager;
 
-    Process::create_supervisor(&do_run_handlers, "deferred_irq"_sv);
+    auto process = Process::create_supervisor(&do_run_handlers, "deferred_irq"_sv);
+    process->set_priority_class(PriorityClass::REALTIME);
 }
 
 DeferredIRQManager& DeferredIRQManager::the()
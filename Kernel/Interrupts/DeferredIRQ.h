@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Multitasking/Blocker.h"
+#include "Multitasking/WaitQueue.h"
 #include "Common/Lock.h"
 #include "Common/Set.h"
 
@@ -44,16 +44,14 @@ private:
     static void do_run_handlers();
 
 private:
-    InterruptSafeSpinLock m_blocker_access_lock;
+    InterruptSafeSpinLock m_waiters_lock;
 
     // NOTE: not interrupt safe
     SpinLock m_handlers_modification_lock;
 
-    // We cannot use atomic here because as soon as blocker goes
-    // out of scope it becomes invalid. And there's no guarantees
-    // that the blocker loaded from an atomic variable remains valid
-    // for the duration of the call.
-    Blocker* m_blocker { nullptr };
+    // Only ever contains the handler thread, guarded by m_waiters_lock
+    // as the entry becomes invalid as soon as it goes out of scope.
+    WaitQueue m_waiters;
 
     Set<DeferredIRQHandler*> m_handlers;
 
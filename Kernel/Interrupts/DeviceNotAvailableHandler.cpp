@@ -0,0 +1,24 @@
+#include "Core/FPU.h"
+#include "Core/Runtime.h"
+#include "Multitasking/Thread.h"
+
+#include "DeviceNotAvailableHandler.h"
+
+namespace kernel {
+
+DeviceNotAvailableHandler::DeviceNotAvailableHandler()
+    : ExceptionHandler(exception_number)
+{
+}
+
+void DeviceNotAvailableHandler::handle(RegisterState& state)
+{
+    auto* thread = Thread::current();
+
+    if (!thread->fpu_state())
+        runtime::panic("FPU used by a thread without FPU state", &state);
+
+    thread->claim_fpu();
+    FPU::count_lazy_restore();
+}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Core/Registers.h"
+#include "ExceptionHandler.h"
+
+namespace kernel {
+
+// Raised on the first FPU/SIMD instruction after a context switch while
+// CR0.TS is set, loads the FPU state of the current thread.
+class DeviceNotAvailableHandler : public ExceptionHandler {
+public:
+    static constexpr auto exception_number = 0x7;
+
+    DeviceNotAvailableHandler();
+
+    void handle(RegisterState& state) override;
+};
+}
@@ -2,11 +2,14 @@
 #include "Common/Macros.h"
 #include "Common/Types.h"
 
+#include "Core/CPU.h"
 #include "Core/Registers.h"
 
+#include "DeviceNotAvailableHandler.h"
 #include "ExceptionDispatcher.h"
 #include "ExceptionHandler.h"
 #include "PageFaultHandler.h"
+#include "SyscallDispatcher.h"
 
 #include "Multitasking/Scheduler.h"
 
@@ -24,6 +27,7 @@ void ExceptionDispatcher::initialize()
 
     // Custom handlers go here
     new PageFaultHandler;
+    new DeviceNotAvailableHandler;
 }
 
 ExceptionDispatcher::ExceptionDispatcher()
@@ -37,6 +41,14 @@ void ExceptionDispatcher::handle_interrupt(RegisterState& registers)
     if (exception_number > 20)
         exception_number = 21; // security exception is 21st in the array
 
+#ifdef ULTRA_32
+    // Let the entry stub carry on, it restores the userland flags on the way out
+    if (exception_number == debug_exception_number && SyscallDispatcher::is_sysenter_single_step(registers)) {
+        registers.eflags &= ~static_cast<u32>(CPU::FLAGS::TRAP);
+        return;
+    }
+#endif
+
     if (m_handlers[exception_number] == nullptr) {
         if ((registers.cs & 3) == 3) {
             log() << "Userspace caused an exception " << s_exception_messages[exception_number] << ", crashing the process";
@@ -17,6 +17,7 @@ class ExceptionDispatcher final : public RangedInterruptHandler {
 
 public:
     static constexpr size_t exception_count = 32;
+    static constexpr size_t debug_exception_number = 1;
 
     static void initialize();
 
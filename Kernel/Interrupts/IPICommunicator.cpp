@@ -74,6 +74,24 @@ void IPICommunicator::post_request(Request& request)
     }
 }
 
+void IPICommunicator::post_request(Request& request, u32 cpu_id)
+{
+    Interrupts::ScopedDisabler d;
+
+    auto& cpu = CPU::at_id(cpu_id);
+    ASSERT(cpu_id != CPU::current_id() && cpu.is_online());
+
+    request.increment_completion_countdown();
+
+    cpu.push_request(request);
+    send_ipi(cpu_id);
+}
+
+void IPICommunicator::wake_up(u32 cpu_id)
+{
+    send_ipi(cpu_id);
+}
+
 void IPICommunicator::process_pending()
 {
     ASSERT(!Interrupts::are_enabled());
@@ -86,7 +104,8 @@ void IPICommunicator::process_pending()
             hang();
         case Request::Type::INVALIDATE_RANGE: {
             auto* invalidation_request = static_cast<RangeInvalidationRequest*>(request);
-            AddressSpace::current().invalidate_range(invalidation_request->virtual_range());
+            invalidation_request->address_space().invalidate_local_tlb(
+                invalidation_request->virtual_ranges(), invalidation_request->tlb_generation());
             break;
         }
         default:
@@ -97,9 +116,11 @@ void IPICommunicator::process_pending()
     }
 }
 
-void IPICommunicator::handle_interrupt(RegisterState&)
+void IPICommunicator::handle_interrupt(RegisterState& registers)
 {
     process_pending();
     LAPIC::end_of_interrupt();
+
+    Scheduler::on_wake_up_request(registers);
 }
 }
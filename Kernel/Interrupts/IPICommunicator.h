@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common/Macros.h"
+#include "Common/Span.h"
 #include "Common/Types.h"
 
 #include "Core/Registers.h"
@@ -8,6 +9,8 @@
 
 namespace kernel {
 
+class AddressSpace;
+
 class IPICommunicator : public MonoInterruptHandler {
     MAKE_SINGLETON(IPICommunicator);
 
@@ -42,16 +45,23 @@ public:
 
     class RangeInvalidationRequest final : public Request {
     public:
-        RangeInvalidationRequest(Range virtual_range)
-            : m_virtual_range(virtual_range)
+        // An empty span of ranges means the entire TLB has to be flushed
+        RangeInvalidationRequest(AddressSpace& address_space, Span<const Range> virtual_ranges, u64 tlb_generation)
+            : m_address_space(address_space)
+            , m_virtual_ranges(virtual_ranges)
+            , m_tlb_generation(tlb_generation)
         {
         }
 
         Type type() const override { return Type::INVALIDATE_RANGE; }
-        Range virtual_range() const { return m_virtual_range; }
+        AddressSpace& address_space() const { return m_address_space; }
+        Span<const Range> virtual_ranges() const { return m_virtual_ranges; }
+        u64 tlb_generation() const { return m_tlb_generation; }
 
     private:
-        Range m_virtual_range;
+        AddressSpace& m_address_space;
+        Span<const Range> m_virtual_ranges;
+        u64 m_tlb_generation;
     };
 
     static IPICommunicator& the()
@@ -60,9 +70,15 @@ public:
         return *s_instance;
     }
 
+    // Posts the request to every other online processor
     void post_request(Request&);
+    void post_request(Request&, u32 cpu_id);
     void process_pending();
 
+    // Sends a request-less IPI, used to kick a processor into rescheduling (or out of hlt if idle).
+    // Sending it to the current processor is fine, it arrives once interrupts are enabled.
+    void wake_up(u32 cpu_id);
+
 private:
     void send_ipi(u8 dest);
     void handle_interrupt(RegisterState&) override;
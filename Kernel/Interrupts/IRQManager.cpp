@@ -1,3 +1,5 @@
+#include "Core/Tracer.h"
+
 #include "IRQManager.h"
 #include "InterruptController.h"
 #include "Utilities.h"
@@ -59,9 +61,13 @@ void IRQManager::handle_interrupt(RegisterState& registers)
     auto& handlers = m_vec_to_handlers[vec];
     ASSERT(!handlers.empty());
 
+    TRACE(IRQ_ENTER, vec, 0);
+
     for (auto& handler : handlers)
         handler.handle_irq(registers);
 
+    TRACE(IRQ_EXIT, vec, 0);
+
     // We pass the legacy number because only PIC requires the irq number
     // to send an EOI, and if we're using PIC we're definitely not using
     // anything like MSIs/LAPIC timers, so it's kind of an invariant, although
@@ -87,15 +87,58 @@ void LAPIC::Timer::calibrate_for_this_processor()
 
     write_register(Register::DIVIDE_CONFIGURATION, divider_16);
     write_register(Register::INITIAL_COUNT, initial_counter);
+    auto tsc_begin = CPU::read_tsc();
 
     primary_timer.mili_delay(sleep_delay);
 
     auto total_ticks = initial_counter - read_register(Register::CURRENT_COUNT);
+    auto total_tsc_ticks = CPU::read_tsc() - tsc_begin;
+
+    auto& state = m_processor_state[my_id()];
+    state.mode = Mode::PERIODIC;
+    state.ticks_per_period = total_ticks;
+
+    if (CPU::ID(1).c & tsc_deadline_cpuid_bit)
+        state.tsc_ticks_per_period = total_tsc_ticks;
 
     write_register(Register::LVT_TIMER, irq_number | periodic_mode | masked_bit);
     write_register(Register::INITIAL_COUNT, total_ticks);
 }
 
+void LAPIC::Timer::arm_one_shot(u64 delay_ns)
+{
+    static constexpr u64 period_ns = Time::nanoseconds_in_second / default_ticks_per_second;
+
+    auto& state = m_processor_state[my_id()];
+
+    if (state.tsc_ticks_per_period) {
+        if (state.mode != Mode::TSC_DEADLINE) {
+            write_register(Register::LVT_TIMER, irq_number | tsc_deadline_mode);
+
+            // Intel SDM 10.5.4.1: the LVT write must be serialized before the first deadline write
+            asm volatile("mfence" ::
+                             : "memory");
+            state.mode = Mode::TSC_DEADLINE;
+        }
+
+        auto deadline = CPU::read_tsc() + max<u64>((delay_ns * state.tsc_ticks_per_period) / period_ns, 1);
+
+        CPU::MSR msr;
+        msr.upper = deadline >> 32;
+        msr.lower = deadline & 0xFFFFFFFF;
+        msr.write(tsc_deadline_msr);
+        return;
+    }
+
+    if (state.mode != Mode::ONE_SHOT) {
+        write_register(Register::LVT_TIMER, irq_number);
+        state.mode = Mode::ONE_SHOT;
+    }
+
+    auto ticks = (delay_ns * state.ticks_per_period) / period_ns;
+    write_register(Register::INITIAL_COUNT, min<u64>(max<u64>(ticks, 1), UINT32_MAX));
+}
+
 void LAPIC::Timer::enable_irq()
 {
     auto current_value = read_register(Register::LVT_TIMER);
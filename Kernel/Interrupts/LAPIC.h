@@ -27,6 +27,10 @@ public:
         static constexpr u32 irq_number = 253;
         static constexpr u32 masked_bit = SET_BIT(16);
         static constexpr u32 periodic_mode = SET_BIT(17);
+        static constexpr u32 tsc_deadline_mode = SET_BIT(18);
+
+        static constexpr u32 tsc_deadline_msr = 0x6E0;
+        static constexpr u32 tsc_deadline_cpuid_bit = SET_BIT(24);
 
         Timer()
             : ::kernel::Timer(IRQHandler::Type::FIXED, irq_number)
@@ -63,10 +67,29 @@ public:
 
         bool is_per_cpu() const override { return true; }
 
+        bool supports_one_shot() const override { return true; }
+        void arm_one_shot(u64 delay_ns) override;
+
         static constexpr StringView type = "LAPIC Timer"_sv;
         StringView device_type() const override { return type; }
 
         StringView device_model() const override { return device_type(); }
+
+    private:
+        enum class Mode : u8 {
+            PERIODIC,
+            ONE_SHOT,
+            TSC_DEADLINE,
+        };
+
+        struct ProcessorState {
+            Mode mode { Mode::PERIODIC };
+            u32 ticks_per_period { 0 };
+            u64 tsc_ticks_per_period { 0 }; // 0 if TSC-deadline mode is not supported
+        };
+
+        static constexpr size_t max_processors = 256;
+        ProcessorState m_processor_state[max_processors];
     };
 
 public:
@@ -40,6 +40,14 @@ public:
     size_t maximum_delay_ns() const override { return max_divisor / ticks_in_10_microseconds * 10 * Time::nanoseconds_in_microsecond; }
     void nano_delay(u32 ns) override;
 
+    // nano_delay() waits in steps of 12 ticks, which is slightly more than 10us,
+    // returns the amount of time it actually waits for a given ns.
+    static constexpr u64 real_delay_ns(u32 ns)
+    {
+        u64 ticks = (ns / (Time::nanoseconds_in_microsecond * 10)) * ticks_in_10_microseconds;
+        return ticks * Time::nanoseconds_in_second / frequency;
+    }
+
     ~PIT() override { disable_irq(); }
 
 private:
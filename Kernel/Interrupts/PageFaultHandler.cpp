@@ -1,4 +1,5 @@
 #include "PageFaultHandler.h"
+#include "Core/Tracer.h"
 #include "Memory/MemoryManager.h"
 
 namespace kernel {
@@ -19,6 +20,8 @@ void PageFaultHandler::handle(RegisterState& state)
     asm("mov %%cr2, %0"
         : "=a"(address_of_fault));
 
+    TRACE(PAGE_FAULT, address_of_fault.raw(), state.error_code);
+
     PageFault pf(
         address_of_fault,
         state.instruction_pointer(),
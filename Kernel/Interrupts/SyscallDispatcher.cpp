@@ -1,13 +1,24 @@
 #include "Common/Logger.h"
 
+#include "Core/CPU.h"
+#include "Core/GDT.h"
 #include "Core/Syscall.h"
 
 #include "Multitasking/Scheduler.h"
+#include "Multitasking/TSS.h"
 #include "Multitasking/Thread.h"
 
 #include "IDT.h"
 #include "SyscallDispatcher.h"
 
+// defined in Architecture/X/SyscallEntry.asm
+#ifdef ULTRA_32
+extern "C" void sysenter_entry();
+extern "C" void sysenter_entry_flags_cleared();
+#elif defined(ULTRA_64)
+extern "C" void syscall_entry();
+#endif
+
 namespace kernel {
 
 SyscallDispatcher* SyscallDispatcher::s_instance;
@@ -23,7 +34,112 @@ SyscallDispatcher::SyscallDispatcher()
 {
 }
 
+void SyscallDispatcher::initialize_fast_entry_for_this_cpu()
+{
+#ifdef ULTRA_32
+    static constexpr u32 sep_support_bit = SET_BIT(11);
+
+    static constexpr u32 sysenter_cs_msr = 0x174;
+    static constexpr u32 sysenter_esp_msr = 0x175;
+    static constexpr u32 sysenter_eip_msr = 0x176;
+
+    bool is_supported = CPU::feature_flags().d & sep_support_bit;
+
+    if (CPU::current().is_bsp()) {
+        if (is_supported)
+            log() << "SyscallDispatcher: using SYSENTER/SYSEXIT for fast system calls";
+        else
+            warning() << "SyscallDispatcher: SYSENTER is not supported, falling back to int 0x80";
+    }
+
+    if (!is_supported)
+        return;
+
+    // SYSEXIT derives the userland selectors from this one, it expects the same layout as our GDT
+    static_assert(GDT::userland_code_selector() == GDT::kernel_code_selector() + 16);
+    static_assert(GDT::userland_data_selector() == GDT::kernel_code_selector() + 24);
+
+    CPU::MSR msr;
+    msr.lower = GDT::kernel_code_selector();
+    msr.write(sysenter_cs_msr);
+
+    // SYSENTER doesn't know about the current thread, so it lands on a small per-processor stack with
+    // the address of the TSS right above its top. The entry stub moves on to the kernel stack saved in there.
+    // Also catches the #DB of a userland trap flag, which fires before the stub gets to clear it.
+    auto* trampoline = new u8[sysenter_trampoline_stack_size];
+    auto* trampoline_top = reinterpret_cast<ptr_t*>(trampoline + sysenter_trampoline_stack_size) - 1;
+    *trampoline_top = reinterpret_cast<ptr_t>(&CPU::current().tss());
+
+    msr.lower = reinterpret_cast<ptr_t>(trampoline_top);
+    msr.write(sysenter_esp_msr);
+
+    msr.lower = reinterpret_cast<ptr_t>(&sysenter_entry);
+    msr.write(sysenter_eip_msr);
+#elif defined(ULTRA_64)
+    static constexpr u32 efer_msr = 0xC0000080;
+    static constexpr u32 star_msr = 0xC0000081;
+    static constexpr u32 lstar_msr = 0xC0000082;
+    static constexpr u32 fmask_msr = 0xC0000084;
+    static constexpr u32 kernel_gs_base_msr = 0xC0000102;
+
+    static constexpr u32 syscall_enable_bit = SET_BIT(0);
+    static constexpr u8 rpl_ring_3 = 3;
+
+    // Always available in long mode
+    if (CPU::current().is_bsp())
+        log() << "SyscallDispatcher: using SYSCALL/SYSRET for fast system calls";
+
+    // SYSRET loads SS from STAR[63:48] + 8 and CS from STAR[63:48] + 16
+    static_assert(GDT::userland_data_selector() == GDT::kernel_data_selector() + 8);
+    static_assert(GDT::userland_code_selector() == GDT::kernel_data_selector() + 16);
+
+    auto efer = CPU::MSR::read(efer_msr);
+    efer.lower |= syscall_enable_bit;
+    efer.write(efer_msr);
+
+    CPU::MSR star;
+    star.upper = (static_cast<u32>(GDT::kernel_data_selector() | rpl_ring_3) << 16) | GDT::kernel_code_selector();
+    star.write(star_msr);
+
+    auto entry = reinterpret_cast<u64>(&syscall_entry);
+    CPU::MSR lstar;
+    lstar.lower = entry & 0xFFFFFFFF;
+    lstar.upper = entry >> 32;
+    lstar.write(lstar_msr);
+
+    // Interrupts stay masked only until syscall_entry is on the kernel stack, it enables them
+    // like the int 0x80 trap gate does. Direction, trap, alignment check and nested task are cleared.
+    CPU::MSR fmask;
+    fmask.lower = static_cast<u32>(CPU::FLAGS::INTERRUPTS) | static_cast<u32>(CPU::FLAGS::DIRECTION)
+        | static_cast<u32>(CPU::FLAGS::TRAP) | static_cast<u32>(CPU::FLAGS::ALIGNMENT_CHECK)
+        | static_cast<u32>(CPU::FLAGS::NESTED_TASK);
+    fmask.write(fmask_msr);
+
+    // SWAPGS in the entry stub uses this to find the kernel stack of the current thread
+    auto tss = reinterpret_cast<u64>(&CPU::current().tss());
+    CPU::MSR kernel_gs_base;
+    kernel_gs_base.lower = tss & 0xFFFFFFFF;
+    kernel_gs_base.upper = tss >> 32;
+    kernel_gs_base.write(kernel_gs_base_msr);
+#endif
+}
+
+#ifdef ULTRA_32
+bool SyscallDispatcher::is_sysenter_single_step(const RegisterState& registers)
+{
+    auto entry_begin = reinterpret_cast<ptr_t>(&sysenter_entry);
+    auto entry_end = reinterpret_cast<ptr_t>(&sysenter_entry_flags_cleared);
+
+    return (registers.cs & 3) == 0 && registers.eip >= entry_begin && registers.eip <= entry_end;
+}
+#endif
+
 void SyscallDispatcher::handle_interrupt(RegisterState& registers)
+{
+    dispatch(&registers);
+}
+
+void SyscallDispatcher::dispatch(RegisterState* registers_ptr)
 {
     // Syscall conventions:
     // Interrupt number: 0x80
@@ -31,8 +147,15 @@ void SyscallDispatcher::handle_interrupt(RegisterState& registers)
     // R/EAX -> syscall number
     // R/EBX, R/ECX, R/EDX -> syscall arguments, left -> right
     // R/EAX -> return code, one of negated ErrorCode values
+    //
+    // SYSCALL (AMD64) clobbers RCX and R11, the second argument is passed in R10 instead.
+    // SYSENTER (i386) takes the userland stack in ECX and the return address in EDX,
+    // the second and third arguments are passed in ESI and EDI instead.
+    // The entry stubs move them to where the int 0x80 convention expects them.
 
+    auto& registers = *registers_ptr;
     auto& current_thread = *Thread::current();
+    current_thread.enter_kernel_mode();
 
     // We got killed by someone while running.
     // Yield so scheduler can deque & kill us.
@@ -47,5 +170,7 @@ void SyscallDispatcher::handle_interrupt(RegisterState& registers)
     // Got killed while executing the syscall.
     if (current_thread.should_die() || !current_thread.owner().is_alive())
         Scheduler::the().yield();
+
+    current_thread.enter_user_mode();
 }
 }
@@ -14,8 +14,23 @@ class SyscallDispatcher : public MonoInterruptHandler {
 public:
     static void initialize();
 
+    // Sets up SYSCALL/SYSRET on AMD64 or SYSENTER/SYSEXIT on i386,
+    // must be called after the TSS of this processor has been created.
+    static void initialize_fast_entry_for_this_cpu();
+
     static constexpr u16 vector_number = 0x80;
 
+#ifdef ULTRA_32
+    static constexpr size_t sysenter_trampoline_stack_size = 1024;
+
+    // SYSENTER keeps the userland trap flag, so single stepping into a system call
+    // raises #DB inside the entry stub before it gets to clear it
+    static bool is_sysenter_single_step(const RegisterState&);
+#endif
+
+    // Shared by the int 0x80 path and the fast entry stubs, registers are laid out like an interrupt frame
+    static void dispatch(RegisterState*) USED;
+
 private:
     void handle_interrupt(RegisterState&) override;
 
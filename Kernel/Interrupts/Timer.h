@@ -9,6 +9,7 @@
 #include "Drivers/DeviceManager.h"
 #include "Interrupts/IRQHandler.h"
 
+#include "Time/ClockSource.h"
 #include "Time/Time.h"
 
 namespace kernel {
@@ -35,6 +36,9 @@ public:
 
     static u64 nanoseconds_since_boot()
     {
+        if (auto* clock_source = ClockSource::primary())
+            return clock_source->nanoseconds_since_boot();
+
 #ifdef ULTRA_32
         u64 out_counter = 0;
         u32 captured_update = 0;
@@ -72,6 +76,11 @@ public:
 
     virtual bool is_per_cpu() const = 0;
 
+    // Per-cpu timers only, switches the timer of the calling processor into
+    // one-shot mode, where it fires exactly once after delay_ns and then stops.
+    virtual bool supports_one_shot() const { return false; }
+    virtual void arm_one_shot(u64) { ASSERT(!"arm_one_shot() is not implemented"); }
+
     virtual void enable() = 0;
     virtual void disable() = 0;
 
@@ -21,8 +21,10 @@
 #include "Memory/HeapAllocator.h"
 #include "Memory/MemoryManager.h"
 #include "Memory/MemoryMap.h"
+#include "Memory/PCID.h"
 #include "Multitasking/Scheduler.h"
 #include "Multitasking/Sleep.h"
+#include "Time/ClockSource.h"
 #include "Time/RTC.h"
 #include "WindowManager/DemoTTY.h"
 #include "WindowManager/Painter.h"
@@ -39,6 +41,7 @@ namespace kernel {
     Logger::initialize();
     runtime::ensure_loaded_correctly();
     runtime::KernelSymbolTable::parse_all();
+    CPU::detect_string_features();
 
     // Generates native memory map, initializes BootAllocator, initializes kernel heap
     MemoryManager::early_initialize(context);
@@ -58,9 +61,11 @@ namespace kernel {
 
     InterruptController::discover_and_setup();
     Timer::discover_and_setup();
+    ClockSource::discover_and_setup();
     CPU::initialize();
     FPU::detect_features();
     FPU::initialize_for_this_cpu();
+    PCID::initialize_for_this_cpu();
 
     VideoDevice::discover_and_setup(context);
 
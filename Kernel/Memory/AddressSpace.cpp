@@ -6,6 +6,7 @@
 
 #include "AddressSpace.h"
 #include "MemoryManager.h"
+#include "PCID.h"
 #include "VirtualAllocator.h"
 
 // #define ADDRESS_SPACE_DEBUG
@@ -15,11 +16,15 @@ namespace kernel {
 // defined in Architecture/X/Entrypoint.asm
 extern "C" ptr_t kernel_base_table[AddressSpace::Table::entry_count];
 
+Atomic<u64> AddressSpace::s_next_id { 1 };
 AddressSpace* AddressSpace::s_of_kernel;
 
 AddressSpace::AddressSpace()
     : m_allocator(MemoryManager::userspace_usable_base, MemoryManager::userspace_usable_ceiling)
+    , m_id(s_next_id.fetch_add(1, MemoryOrder::RELAXED))
 {
+    static_assert(CPU::max_lapic_id < max_processor_count);
+
     // if is_initialized() returns false that means we're creating the kernel address space
     // therefore we can/must skip the MM initialization step as well as page allocation
     if (AddressSpace::is_initialized()) {
@@ -378,28 +383,133 @@ void AddressSpace::map_huge_range(Range virtual_range, Range physical_range, IsS
 
 void AddressSpace::unmap_page(Address virtual_address)
 {
-    Interrupts::ScopedDisabler d;
+    unmap_range({ virtual_address, Page::size });
+}
 
-    local_unmap_page(virtual_address);
+void AddressSpace::unmap_range(const Range& range)
+{
+    UnmapBatch batch(*this);
+    batch.unmap_range(range);
+}
 
-    IPICommunicator::RangeInvalidationRequest req({ virtual_address, Page::size });
-    IPICommunicator::the().post_request(req);
-    req.wait_for_completion();
+void AddressSpace::UnmapBatch::unmap_range(const Range& range)
+{
+    ASSERT_PAGE_ALIGNED(range.begin());
+
+    size_t page_count = range.length() / Page::size;
+
+    for (size_t i = 0; i < page_count; ++i)
+        m_address_space.unmap_entry(range.begin() + i * Page::size);
+
+    m_page_count += page_count;
+
+    // Once we're over the threshold the individual ranges don't matter anymore
+    if (m_needs_full_flush || m_range_count == max_ranges || m_page_count > full_flush_threshold) {
+        m_needs_full_flush = true;
+        return;
+    }
+
+    m_ranges[m_range_count++] = range;
 }
 
-void AddressSpace::unmap_range(const Range& range)
+void AddressSpace::UnmapBatch::flush()
 {
-    Interrupts::ScopedDisabler d;
+    if (m_page_count == 0)
+        return;
+
+    Span<const Range> ranges;
+
+    if (!m_needs_full_flush)
+        ranges = { m_ranges, m_range_count };
 
-    local_unmap_range(range);
+    {
+        Interrupts::ScopedDisabler d;
+
+        auto tlb_generation = m_address_space.bump_tlb_generation();
+
+        if (m_address_space.is_of_kernel() || m_address_space.is_active()) {
+            if (ranges.empty())
+                flush_local_tlb();
+            else
+                for (auto& range : ranges)
+                    m_address_space.invalidate_range(range);
+        }
+
+        m_address_space.shoot_down(ranges, tlb_generation);
+    }
+
+    m_range_count = 0;
+    m_page_count = 0;
+    m_needs_full_flush = false;
+}
+
+void AddressSpace::shoot_down(Span<const Range> virtual_ranges, u64 tlb_generation)
+{
+    IPICommunicator::RangeInvalidationRequest req(*this, virtual_ranges, tlb_generation);
+
+    // Kernel mappings are shared by every address space, so anyone might have them cached
+    if (is_of_kernel()) {
+        IPICommunicator::the().post_request(req);
+        req.wait_for_completion();
+        return;
+    }
+
+    // Processors that load us after this point see the new generation and flush on their own
+    auto current_id = CPU::current_id();
+
+    for (u32 i = 0; i < max_processor_count / processors_per_mask; ++i) {
+        auto mask = m_active_processors[i].load(MemoryOrder::SEQ_CST);
+
+        while (mask) {
+            auto bit = __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            auto cpu_id = i * processors_per_mask + bit;
+
+            if (cpu_id != current_id)
+                IPICommunicator::the().post_request(req, cpu_id);
+        }
+    }
 
-    IPICommunicator::RangeInvalidationRequest req(range);
-    IPICommunicator::the().post_request(req);
     req.wait_for_completion();
 }
 
-#ifdef ULTRA_32
+u64 AddressSpace::bump_tlb_generation()
+{
+    auto tlb_generation = m_tlb_generation.fetch_add(1, MemoryOrder::SEQ_CST) + 1;
+
+    // The caller takes care of the entries of the active PCID right after
+    if (is_of_kernel() || is_active())
+        synchronize_local_pcids(tlb_generation);
+
+    return tlb_generation;
+}
+
+bool AddressSpace::is_active_on(u32 cpu_id) const
+{
+    auto mask = m_active_processors[cpu_id / processors_per_mask].load(MemoryOrder::ACQUIRE);
+    return mask & (1u << (cpu_id % processors_per_mask));
+}
+
+void AddressSpace::set_active_on(u32 cpu_id, bool is_active)
+{
+    auto& mask = m_active_processors[cpu_id / processors_per_mask];
+    u32 bit = 1u << (cpu_id % processors_per_mask);
+
+    if (is_active)
+        mask.fetch_or(bit, MemoryOrder::SEQ_CST);
+    else
+        mask.fetch_and(~bit, MemoryOrder::SEQ_CST);
+}
+
 void AddressSpace::local_unmap_page(Address virtual_address)
+{
+    unmap_entry(virtual_address);
+    invalidate_at(virtual_address);
+}
+
+#ifdef ULTRA_32
+void AddressSpace::unmap_entry(Address virtual_address)
 {
     ASSERT(is_active() || is_of_kernel());
     ASSERT_PAGE_ALIGNED(virtual_address);
@@ -415,10 +525,9 @@ void AddressSpace::local_unmap_page(Address virtual_address)
 #endif
 
     pt_at(page_table_index).entry_at(page_entry_index).set_present(false);
-    invalidate_at(virtual_address);
 }
 #elif defined(ULTRA_64)
-void AddressSpace::local_unmap_page(Address virtual_address)
+void AddressSpace::unmap_entry(Address virtual_address)
 {
     ASSERT_PAGE_ALIGNED(virtual_address);
 
@@ -435,8 +544,6 @@ void AddressSpace::local_unmap_page(Address virtual_address)
         .pt_at(indices.third)
         .entry_at(indices.fourth)
         .set_present(false);
-
-    invalidate_at(virtual_address);
 }
 #endif
 
@@ -448,8 +555,10 @@ void AddressSpace::local_unmap_range(const Range& range)
 
     for (size_t i = 0; i < page_count; ++i) {
         auto offset = i * Page::size;
-        local_unmap_page(range.begin() + offset);
+        unmap_entry(range.begin() + offset);
     }
+
+    invalidate_range(range);
 }
 
 Address AddressSpace::physical_address_of(Address virtual_address)
@@ -490,7 +599,25 @@ Address AddressSpace::active_directory_address()
     asm("mov %%cr3, %0"
         : "=a"(active_directory_ptr));
 
-    return active_directory_ptr;
+    // Lower bits are either flags or the PCID
+    return Page::round_down(active_directory_ptr);
+}
+
+void AddressSpace::write_cr3(ptr_t value)
+{
+    asm volatile("mov %0, %%cr3" ::"a"(value)
+                 : "memory");
+}
+
+void AddressSpace::flush_local_tlb()
+{
+    ptr_t cr3;
+
+    asm("mov %%cr3, %0"
+        : "=a"(cr3));
+
+    // Reloading CR3 without the no-flush bit drops everything tagged with the active PCID
+    write_cr3(cr3);
 }
 
 bool AddressSpace::is_active() const
@@ -510,17 +637,98 @@ void AddressSpace::make_active()
     if (is_active())
         return;
 
-    invalidate_all();
+    auto& cpu = CPU::current();
+    auto* previous = cpu.active_address_space();
+
+    // Has to be visible before we read the generation below, an unmap either sees
+    // this processor as active and sends it an IPI or bumps the generation we read.
+    set_active_on(cpu.id(), true);
+
+#ifdef ULTRA_64
+    if (PCID::is_enabled()) {
+        auto assignment = cpu.pcid_cache().assign(m_id, m_tlb_generation.load(MemoryOrder::SEQ_CST));
+        write_cr3(physical_address() | assignment.pcid | (assignment.needs_flush ? 0 : PCID::no_flush_bit));
+    } else
+#endif
+    {
+        invalidate_all();
+    }
+
+    // Whatever is left of the previous address space in the TLB is either gone
+    // or tagged with a PCID that gets flushed if it changes in the meantime.
+    if (previous)
+        previous->set_active_on(cpu.id(), false);
+
+    cpu.set_active_address_space(this);
 }
 
 void AddressSpace::invalidate_all()
 {
-    asm volatile("mov %0, %%cr3" ::"a"(physical_address())
-                 : "memory");
+#ifdef ULTRA_64
+    // Flushes the entries tagged with our PCID, which is only known if we're active
+    if (PCID::is_enabled()) {
+        ASSERT(is_active());
+        write_cr3(physical_address() | CPU::current().pcid_cache().active_pcid());
+        return;
+    }
+#endif
+
+    write_cr3(physical_address());
+}
+
+void AddressSpace::invalidate_local_tlb(Span<const Range> virtual_ranges, u64 tlb_generation)
+{
+    // Inactive address spaces are either flushed on switch or tagged with a PCID
+    // whose generation no longer matches, which has the same effect.
+    if (!is_of_kernel() && !is_active())
+        return;
+
+    if (!synchronize_local_pcids(tlb_generation))
+        return;
+
+    if (virtual_ranges.empty()) {
+        flush_local_tlb();
+        return;
+    }
+
+    for (auto& range : virtual_ranges)
+        invalidate_range(range);
+}
+
+bool AddressSpace::synchronize_local_pcids([[maybe_unused]] u64 tlb_generation)
+{
+#ifdef ULTRA_64
+    if (!PCID::is_enabled())
+        return true;
+
+    auto& cache = CPU::current().pcid_cache();
+
+    // Kernel mappings are shared by every address space
+    if (is_of_kernel()) {
+        cache.drop_inactive();
+        return true;
+    }
+
+    if (cache.advance_active_generation(tlb_generation))
+        return true;
+
+    // We missed an earlier invalidation that's still in flight, flush everything up to the latest one
+    cache.set_active_generation(m_tlb_generation.load(MemoryOrder::ACQUIRE));
+    invalidate_all();
+
+    return false;
+#elif defined(ULTRA_32)
+    return true;
+#endif
 }
 
 void AddressSpace::invalidate_range(Range virtual_range)
 {
+    if (virtual_range.length() / Page::size > full_flush_threshold) {
+        flush_local_tlb();
+        return;
+    }
+
     for (auto address = virtual_range.begin(); address < virtual_range.end(); address += Page::size)
         invalidate_at(address);
 }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "Common/Atomic.h"
 #include "Common/DynamicArray.h"
 #include "Common/Pair.h"
 #include "Common/RefPtr.h"
+#include "Common/Span.h"
 #include "GenericPagingEntry.h"
 #include "GenericPagingTable.h"
 #include "Page.h"
@@ -93,6 +95,36 @@ public:
     static Quad<size_t, size_t, size_t, size_t> virtual_address_as_paging_indices(Address virtual_address);
 #endif
 
+    // Invalidating more pages than this one by one is slower than flushing the entire TLB
+    static constexpr size_t full_flush_threshold = 32;
+
+    // Collects unmapped ranges so that all of them get shot down with a single round of IPIs.
+    // Entries are cleared right away, but stale TLB entries only go away once the batch is flushed.
+    class UnmapBatch {
+        MAKE_NONCOPYABLE(UnmapBatch);
+        MAKE_NONMOVABLE(UnmapBatch);
+
+    public:
+        explicit UnmapBatch(AddressSpace& address_space)
+            : m_address_space(address_space)
+        {
+        }
+
+        void unmap_range(const Range&);
+        void flush();
+
+        ~UnmapBatch() { flush(); }
+
+    private:
+        static constexpr size_t max_ranges = 16;
+
+        AddressSpace& m_address_space;
+        Range m_ranges[max_ranges];
+        size_t m_range_count { 0 };
+        size_t m_page_count { 0 };
+        bool m_needs_full_flush { false };
+    };
+
     void local_unmap_page(Address virtual_address);
     void local_unmap_range(const Range&);
     void unmap_page(Address virtual_address);
@@ -106,9 +138,31 @@ public:
     void invalidate_range(Range virtual_range);
     void invalidate_at(Address virtual_address);
 
+    // Called on every processor that might cache entries of virtual_ranges after their page tables
+    // were modified as part of tlb_generation. An empty span means the entire TLB is stale.
+    void invalidate_local_tlb(Span<const Range> virtual_ranges, u64 tlb_generation);
+
+    [[nodiscard]] bool is_active_on(u32 cpu_id) const;
+
     bool is_of_kernel() const;
 
 private:
+    u64 bump_tlb_generation();
+
+    // Sends the invalidation to every processor that might have stale entries cached and waits for it
+    void shoot_down(Span<const Range> virtual_ranges, u64 tlb_generation);
+
+    void unmap_entry(Address virtual_address);
+
+    void set_active_on(u32 cpu_id, bool is_active);
+    static void flush_local_tlb();
+
+    // Makes sure that entries of this address space cached under PCIDs other than the
+    // active one don't get used, returns false if the active PCID was flushed entirely.
+    bool synchronize_local_pcids(u64 tlb_generation);
+
+    static void write_cr3(ptr_t value);
+
     void map_page_directory_entry(size_t index, Address physical_address, IsSupervisor);
 
 #ifdef ULTRA_32
@@ -134,6 +188,18 @@ private:
 
     RecursiveInterruptSafeSpinLock m_lock;
 
+    // Never reused, so stale PCID cache entries can't match a new address space
+    u64 m_id { 0 };
+
+    // Incremented every time a range gets unmapped
+    Atomic<u64> m_tlb_generation { 0 };
+
+    // Processors that currently have this address space loaded, indexed by LAPIC id
+    static constexpr size_t max_processor_count = 256;
+    static constexpr size_t processors_per_mask = sizeof(u32) * 8;
+    Atomic<u32> m_active_processors[max_processor_count / processors_per_mask];
+
+    static Atomic<u64> s_next_id;
     static AddressSpace* s_of_kernel;
 };
 }
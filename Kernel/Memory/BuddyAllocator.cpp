@@ -0,0 +1,256 @@
+#include "BuddyAllocator.h"
+
+namespace kernel {
+
+BuddyAllocator::FreeMap::FreeMap(size_t bit_count)
+    : m_bit_count(bit_count)
+{
+    if (!bit_count)
+        return;
+
+    size_t total_words = 0;
+    size_t words = ceiling_divide(bit_count, bits_per_word);
+
+    for (;;) {
+        ASSERT(m_level_count < max_levels);
+
+        m_level_offsets[m_level_count++] = total_words;
+        total_words += words;
+
+        if (words == 1)
+            break;
+
+        words = ceiling_divide(words, bits_per_word);
+    }
+
+    m_words.expand_to(total_words);
+}
+
+void BuddyAllocator::FreeMap::set(size_t bit)
+{
+    ASSERT(bit < m_bit_count);
+
+    for (size_t level = 0; level < m_level_count; ++level) {
+        auto& this_word = word(level, bit / bits_per_word);
+        bool was_empty = this_word == 0;
+
+        this_word |= 1ull << (bit % bits_per_word);
+
+        // Levels above already know this word isn't empty
+        if (!was_empty)
+            return;
+
+        bit /= bits_per_word;
+    }
+}
+
+void BuddyAllocator::FreeMap::clear(size_t bit)
+{
+    ASSERT(bit < m_bit_count);
+
+    for (size_t level = 0; level < m_level_count; ++level) {
+        auto& this_word = word(level, bit / bits_per_word);
+        this_word &= ~(1ull << (bit % bits_per_word));
+
+        if (this_word != 0)
+            return;
+
+        bit /= bits_per_word;
+    }
+}
+
+bool BuddyAllocator::FreeMap::test(size_t bit) const
+{
+    ASSERT(bit < m_bit_count);
+
+    return word(0, bit / bits_per_word) & (1ull << (bit % bits_per_word));
+}
+
+Optional<size_t> BuddyAllocator::FreeMap::find_first() const
+{
+    if (!m_level_count || !word(m_level_count - 1, 0))
+        return {};
+
+    size_t index = 0;
+
+    for (size_t level = m_level_count; level-- > 0;)
+        index = index * bits_per_word + __builtin_ctzll(word(level, index));
+
+    return index;
+}
+
+BuddyAllocator::BuddyAllocator(Address base, size_t page_count)
+    : m_first_frame(base / Page::size)
+    , m_end_frame(m_first_frame + page_count)
+{
+    ASSERT_PAGE_ALIGNED(base);
+
+    if (!page_count)
+        return;
+
+    for (size_t order = 0; order <= max_order; ++order) {
+        auto block_count = ((m_end_frame - 1) >> order) - (m_first_frame >> order) + 1;
+        m_free_blocks[order] = FreeMap(block_count);
+    }
+
+    // Carve the range into the biggest naturally aligned blocks that fit
+    for (auto frame = m_first_frame; frame < m_end_frame;) {
+        auto order = max_order;
+
+        while (order && ((frame & ((1ull << order) - 1)) || !is_block_in_range(frame, order)))
+            --order;
+
+        m_free_blocks[order].set(block_index(frame, order));
+        m_free_pages += 1ull << order;
+        frame += 1ull << order;
+    }
+}
+
+size_t BuddyAllocator::order_for(size_t page_count)
+{
+    size_t order = 0;
+
+    while ((1ull << order) < page_count)
+        ++order;
+
+    return order;
+}
+
+u64 BuddyAllocator::end_frame_for(u64 ceiling)
+{
+    // Written this way so that a ceiling at the very top of the address space doesn't overflow
+    return ceiling / Page::size + (ceiling % Page::size == Page::size - 1 ? 1 : 0);
+}
+
+Optional<Address> BuddyAllocator::allocate(size_t order, u64 ceiling)
+{
+    ASSERT(order <= max_order);
+
+    return allocate_below(order, 1ull << order, end_frame_for(ceiling));
+}
+
+Optional<Address> BuddyAllocator::allocate_below(size_t order, size_t page_count, u64 end_frame_limit)
+{
+    for (auto this_order = order; this_order <= max_order; ++this_order) {
+        auto index = m_free_blocks[this_order].find_first();
+
+        if (!index)
+            continue;
+
+        auto frame = ((m_first_frame >> this_order) + *index) << this_order;
+
+        // This is the lowest block of this order, but a bigger one might still be low enough.
+        // The lower half of a split block is kept, so it starts at the same frame either way.
+        if (static_cast<u64>(frame) + page_count > end_frame_limit)
+            continue;
+
+        m_free_blocks[this_order].clear(*index);
+
+        // Keep the lower half, the upper one becomes a free block of the order below
+        while (this_order > order) {
+            --this_order;
+
+            auto buddy = frame + (1ull << this_order);
+            m_free_blocks[this_order].set(block_index(buddy, this_order));
+        }
+
+        m_free_pages -= 1ull << order;
+
+        return Address(frame * Page::size);
+    }
+
+    return {};
+}
+
+Optional<Address> BuddyAllocator::allocate_contiguous(size_t page_count, size_t alignment, u64 ceiling)
+{
+    ASSERT(page_count != 0);
+    ASSERT(alignment >= Page::size && (alignment & (alignment - 1)) == 0);
+
+    auto order = max(order_for(page_count), order_for(alignment / Page::size));
+
+    if (order > max_order)
+        return {};
+
+    // Only the pages we keep have to be below the ceiling, the tail goes back right away
+    auto block = allocate_below(order, page_count, end_frame_for(ceiling));
+
+    if (!block)
+        return {};
+
+    auto first_frame = *block / Page::size;
+    auto end_frame = first_frame + (1ull << order);
+
+    // Give back the pages we didn't ask for, this never coalesces as the head is still allocated
+    for (auto frame = first_frame + page_count; frame < end_frame;) {
+        auto tail_order = order;
+
+        while (tail_order && ((frame & ((1ull << tail_order) - 1)) || frame + (1ull << tail_order) > end_frame))
+            --tail_order;
+
+        m_free_pages += 1ull << tail_order;
+        free_frames(frame, tail_order);
+        frame += 1ull << tail_order;
+    }
+
+    return block;
+}
+
+void BuddyAllocator::free(Address address, size_t order)
+{
+    ASSERT_PAGE_ALIGNED(address);
+    ASSERT(order <= max_order);
+
+    auto frame = address / Page::size;
+
+    ASSERT(is_block_in_range(frame, order));
+    ASSERT((frame & ((1ull << order) - 1)) == 0);
+
+    // check for double free
+    ASSERT(!is_free(address));
+
+    m_free_pages += 1ull << order;
+    free_frames(frame, order);
+}
+
+void BuddyAllocator::free_frames(size_t frame, size_t order)
+{
+    for (; order < max_order; ++order) {
+        auto buddy = frame ^ (1ull << order);
+
+        if (!is_block_in_range(buddy, order))
+            break;
+
+        auto& free_blocks = m_free_blocks[order];
+        auto index = block_index(buddy, order);
+
+        if (!free_blocks.test(index))
+            break;
+
+        free_blocks.clear(index);
+        frame &= ~(1ull << order);
+    }
+
+    m_free_blocks[order].set(block_index(frame, order));
+}
+
+bool BuddyAllocator::is_free(Address address) const
+{
+    auto frame = address / Page::size;
+
+    if (frame < m_first_frame || frame >= m_end_frame)
+        return false;
+
+    for (size_t order = 0; order <= max_order; ++order) {
+        auto block_frame = frame & ~((1ull << order) - 1);
+
+        if (!is_block_in_range(block_frame, order))
+            continue;
+
+        if (m_free_blocks[order].test(block_index(block_frame, order)))
+            return true;
+    }
+
+    return false;
+}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common/DynamicArray.h"
+#include "Common/Macros.h"
+#include "Common/Math.h"
+#include "Common/Optional.h"
+#include "Common/Types.h"
+
+#include "Page.h"
+
+namespace kernel {
+
+// Binary buddy allocator over a range of physical pages. A block of order N is 2^N pages
+// aligned to its own size in physical memory, so a 2 MB block is always usable as a huge page.
+// Free blocks of every order are tracked in a bitmap with summary levels on top of it,
+// finding, taking and returning a block only ever touches one word per level.
+// Metadata is roughly 2 bits per page, so it fits in the early kernel heap even for large regions.
+// Not thread safe, PhysicalRegion does the locking.
+class BuddyAllocator {
+    MAKE_NONCOPYABLE(BuddyAllocator);
+
+public:
+    static constexpr size_t max_order = 10;
+
+    BuddyAllocator(Address base, size_t page_count);
+
+    static constexpr u64 no_ceiling = ~0ull;
+
+    // Lowest free block of the smallest order that has one, splitting a bigger block if needed.
+    // Only blocks that end at or below ceiling, the highest usable physical address, are considered.
+    Optional<Address> allocate(size_t order, u64 ceiling = no_ceiling);
+
+    // page_count pages starting at an address aligned to alignment bytes, the last one at or below ceiling.
+    // Pages past page_count in the block that had to be taken are given back right away.
+    Optional<Address> allocate_contiguous(size_t page_count, size_t alignment = Page::size, u64 ceiling = no_ceiling);
+
+    // Coalesces with the buddy as long as it's free
+    void free(Address, size_t order = 0);
+
+    [[nodiscard]] size_t free_page_count() const { return m_free_pages; }
+    [[nodiscard]] bool is_free(Address) const;
+
+    // Smallest order that fits this many pages
+    static size_t order_for(size_t page_count);
+
+private:
+    class FreeMap {
+    public:
+        FreeMap() = default;
+        explicit FreeMap(size_t bit_count);
+
+        void set(size_t bit);
+        void clear(size_t bit);
+        [[nodiscard]] bool test(size_t bit) const;
+        [[nodiscard]] Optional<size_t> find_first() const;
+
+        [[nodiscard]] size_t size() const { return m_bit_count; }
+
+    private:
+        static constexpr size_t bits_per_word = 64;
+        static constexpr size_t max_levels = 8;
+
+        u64& word(size_t level, size_t index) { return m_words[m_level_offsets[level] + index]; }
+        u64 word(size_t level, size_t index) const { return m_words[m_level_offsets[level] + index]; }
+
+        size_t m_bit_count { 0 };
+        size_t m_level_count { 0 };
+        size_t m_level_offsets[max_levels] {};
+
+        // Level 0 has a bit per block, every next level has a bit per non-zero word of the previous one
+        DynamicArray<u64> m_words;
+    };
+
+    [[nodiscard]] size_t block_index(size_t frame, size_t order) const { return (frame >> order) - (m_first_frame >> order); }
+    [[nodiscard]] bool is_block_in_range(size_t frame, size_t order) const
+    {
+        return frame >= m_first_frame && frame + (1ull << order) <= m_end_frame;
+    }
+
+    void free_frames(size_t frame, size_t order);
+
+    // Takes a block of this order whose first page_count pages end before end_frame_limit
+    Optional<Address> allocate_below(size_t order, size_t page_count, u64 end_frame_limit);
+
+    // Number of the first frame that isn't entirely at or below ceiling
+    static u64 end_frame_for(u64 ceiling);
+
+private:
+    size_t m_first_frame { 0 };
+    size_t m_end_frame { 0 };
+    size_t m_free_pages { 0 };
+    FreeMap m_free_blocks[max_order + 1];
+};
+}
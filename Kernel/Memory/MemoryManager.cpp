@@ -4,12 +4,16 @@
 #include "Interrupts/Utilities.h"
 
 #include "Multitasking/Scheduler.h"
+#include "Time/TSC.h"
 
 #include "AddressSpace.h"
 #include "BootAllocator.h"
 #include "MemoryManager.h"
 #include "NonOwningVirtualRegion.h"
+#include "ObjectCache.h"
 #include "Page.h"
+#include "PageZeroer.h"
+#include "PhysicalPageCache.h"
 #include "PhysicalRegion.h"
 #include "Utilities.h"
 
@@ -78,6 +82,7 @@ void MemoryManager::early_initialize(LoaderContext* loader_context)
 #endif
 
     HeapAllocator::initialize();
+    ObjectCache::initialize();
 }
 
 void MemoryManager::initialize_all()
@@ -218,34 +223,226 @@ void unquickmap_page(Address) { }
 
 #endif
 
-Page MemoryManager::allocate_page(bool should_zero)
+MemoryManager::PhysicalStats MemoryManager::physical_stats() const
 {
-    for (auto& region : m_physical_regions) {
-        auto page = region->allocate_page();
+    auto free_bytes = m_free_physical_bytes.load(MemoryOrder::ACQUIRE);
+
+    auto zeroer_stats = PageZeroer::stats();
+    auto zeroed_pages = zeroer_stats.pooled_pages;
+    u64 zeroed_hits = 0;
+    u64 zeroed_misses = 0;
+    u64 synchronous_zeroing_cycles = 0;
+
+    if (CPU::is_initialized()) {
+        for (auto& cpu : CPU::processors()) {
+            auto& cache = cpu.physical_page_cache();
+
+            free_bytes += cache.size() * Page::size;
+            zeroed_pages += cache.zeroed_size();
+            zeroed_hits += cache.zeroed_hits();
+            zeroed_misses += cache.zeroed_misses();
+            synchronous_zeroing_cycles += cache.synchronous_zeroing_cycles();
+        }
+    }
+
+    auto zeroed_bytes = zeroed_pages * Page::size;
+    free_bytes += zeroed_bytes;
+
+    return { m_initial_physical_bytes.load(MemoryOrder::ACQUIRE),
+        free_bytes,
+        zeroed_bytes,
+        zeroed_hits,
+        zeroed_misses,
+        zeroer_stats.background_ns,
+        TSC::cycles_to_nanoseconds(synchronous_zeroing_cycles) };
+}
 
-        if (!page)
+size_t MemoryManager::take_region_pages(Address* into, size_t count)
+{
+    size_t taken = 0;
+
+    for (auto& region : m_physical_regions) {
+        if (!region->has_free_pages())
             continue;
 
-        m_free_physical_bytes.fetch_subtract(Page::size, MemoryOrder::ACQ_REL);
+        taken += region->allocate_pages(into + taken, count - taken);
 
-        if (should_zero) {
-            MM_DEBUG_EX << "zeroing the page at physaddr " << page->address();
+        if (taken == count)
+            break;
+    }
+
+    m_free_physical_bytes.fetch_subtract(taken * Page::size, MemoryOrder::ACQ_REL);
+
+    return taken;
+}
+
+void MemoryManager::refill(PhysicalPageCache& cache)
+{
+    Address pages[PhysicalPageCache::batch_size];
+    auto count = take_region_pages(pages, PhysicalPageCache::batch_size);
+
+    // The regions are dry, whatever is left is sitting zeroed in the pool or on this processor
+    if (!count)
+        count = PageZeroer::take_pages(pages, PhysicalPageCache::batch_size);
+    if (!count)
+        count = cache.take_zeroed(pages, PhysicalPageCache::batch_size);
+
+    if (!count)
+        runtime::panic("Out of physical memory!");
+
+    cache.put_batch(pages, count);
+}
+
+void MemoryManager::drain(PhysicalPageCache& cache)
+{
+    Address pages[PhysicalPageCache::batch_size];
+    auto count = cache.take_batch(pages);
+
+    // Group the pages by region so that every region is locked once
+    quick_sort(pages, pages + count);
+
+    for (size_t i = 0; i < count;) {
+        auto* region = physical_region_responsible_for_page(Page(pages[i]));
+        ASSERT(region != nullptr);
+
+        auto run_end = i + 1;
+        while (run_end < count && region->range().contains(pages[run_end]))
+            ++run_end;
+
+        region->free_pages(pages + i, run_end - i);
+        i = run_end;
+    }
+
+    m_free_physical_bytes.fetch_add(count * Page::size, MemoryOrder::ACQ_REL);
+}
+
+Address MemoryManager::take_free_page()
+{
+    // Early boot, there's no local data for the caches yet
+    if (!CPU::is_initialized()) {
+        for (auto& region : m_physical_regions) {
+            auto page = region->allocate_page();
+
+            if (!page)
+                continue;
+
+            m_free_physical_bytes.fetch_subtract(Page::size, MemoryOrder::ACQ_REL);
+            return page->address();
+        }
+
+        runtime::panic("Out of physical memory!");
+    }
+
+    Interrupts::ScopedDisabler d;
+    auto& cache = CPU::current().physical_page_cache();
+
+    if (cache.is_empty())
+        refill(cache);
+
+    return cache.pop();
+}
+
+void MemoryManager::return_free_page(Address address)
+{
+    if (!CPU::is_initialized()) {
+        physical_region_responsible_for_page(Page(address))->free_page(Page(address));
+        m_free_physical_bytes.fetch_add(Page::size, MemoryOrder::ACQ_REL);
+        return;
+    }
+
+    Interrupts::ScopedDisabler d;
+    auto& cache = CPU::current().physical_page_cache();
+
+    if (cache.is_full())
+        drain(cache);
+
+    cache.push(address);
+}
+
+void MemoryManager::zero_page(Address physical_address)
+{
+    MM_DEBUG_EX << "zeroing the page at physaddr " << physical_address;
 
 #ifdef ULTRA_32
-            Interrupts::ScopedDisabler d;
-            ScopedPageMapping mapping(page->address());
+    Interrupts::ScopedDisabler d;
+    ScopedPageMapping mapping(physical_address);
 
-            zero_memory(mapping.as_pointer(), Page::size);
+    zero_memory(mapping.as_pointer(), Page::size);
 
 #elif defined(ULTRA_64)
-            zero_memory(physical_to_virtual(page->address()).as_pointer<void>(), Page::size);
+    zero_memory(physical_to_virtual(physical_address).as_pointer<void>(), Page::size);
 #endif
+}
+
+Optional<Address> MemoryManager::take_zeroed_page()
+{
+    if (!CPU::is_initialized())
+        return {};
+
+    Interrupts::ScopedDisabler d;
+    auto& cache = CPU::current().physical_page_cache();
+
+    if (!cache.has_zeroed_pages()) {
+        Address pages[PhysicalPageCache::zeroed_capacity];
+        auto count = PageZeroer::take_pages(pages, PhysicalPageCache::zeroed_capacity);
+
+        if (!count)
+            return {};
+
+        cache.put_zeroed_batch(pages, count);
+    }
+
+    cache.count_zeroed_hit();
+    return cache.pop_zeroed();
+}
+
+Page MemoryManager::allocate_page(bool should_zero)
+{
+    if (!should_zero)
+        return Page(take_free_page());
+
+    if (auto zeroed_page = take_zeroed_page())
+        return Page(*zeroed_page);
+
+    Page page(take_free_page());
+
+    auto start = CPU::read_tsc();
+    zero_page(page.address());
+    auto cycles = CPU::read_tsc() - start;
+
+    if (CPU::is_initialized()) {
+        Interrupts::ScopedDisabler d;
+        CPU::current().physical_page_cache().count_zeroed_miss(cycles);
+    }
+
+    return page;
+}
+
+Optional<Address> MemoryManager::allocate_contiguous_pages(size_t count, size_t alignment, Address64 ceiling, bool should_zero)
+{
+    for (auto& region : m_physical_regions) {
+        if (Address64(region->begin().raw()) >= ceiling)
+            break;
+
+        if (region->free_page_count() < count)
+            continue;
+
+        auto address = region->allocate_contiguous(count, alignment, ceiling);
+
+        if (!address)
+            continue;
+
+        m_free_physical_bytes.fetch_subtract(count * Page::size, MemoryOrder::ACQ_REL);
+
+        if (should_zero) {
+            for (size_t i = 0; i < count; ++i)
+                zero_page(*address + i * Page::size);
         }
 
-        return *page;
+        return address;
     }
 
-    runtime::panic("Out of physical memory!");
+    return {};
 }
 
 PhysicalRegion* MemoryManager::physical_region_responsible_for_page(const Page& page)
@@ -298,11 +495,8 @@ MemoryManager::VR MemoryManager::virtual_region_responsible_for_address(Address
 
 void MemoryManager::free_page(const Page& page)
 {
-    auto* region = physical_region_responsible_for_page(page);
-
-    if (region) {
-        region->free_page(page);
-        m_free_physical_bytes.fetch_add(Page::size, MemoryOrder::ACQ_REL);
+    if (physical_region_responsible_for_page(page)) {
+        return_free_page(page.address());
         return;
     }
 
@@ -686,7 +880,28 @@ MemoryManager::VR MemoryManager::allocate_kernel_shared(SharedVirtualRegion& reg
 MemoryManager::VR MemoryManager::allocate_dma_buffer(StringView purpose, size_t length)
 {
     auto region = allocate_kernel_private_anywhere(purpose, length);
-    static_cast<PrivateVirtualRegion*>(region.get())->preallocate_entire(false);
+    auto& private_region = static_cast<PrivateVirtualRegion&>(*region);
+
+    // Devices don't go through the MMU, so the buffer has to be contiguous in physical memory as well
+    auto page_count = Page::round_up(length) / Page::size;
+    auto physical_base = allocate_contiguous_pages(page_count, Page::size, max_memory_address.raw(), false);
+
+    if (!physical_base) {
+        String error_string;
+        error_string << "MemoryManager: Couldn't allocate " << page_count << " contiguous pages for " << purpose;
+        runtime::panic(error_string.data());
+    }
+
+    LOCK_GUARD(private_region.lock());
+    private_region.owned_pages().reserve(page_count);
+
+    for (size_t i = 0; i < page_count; ++i) {
+        auto virtual_address = private_region.virtual_range().begin() + i * Page::size;
+        Page page(*physical_base + i * Page::size);
+
+        AddressSpace::of_kernel().map_page(virtual_address, page.address(), IsSupervisor::YES);
+        private_region.store_page(page, virtual_address);
+    }
 
     return region;
 }
@@ -855,9 +1070,8 @@ void MemoryManager::free_virtual_region(VirtualRegion& vr)
         m_kernel_virtual_regions.remove(vr.virtual_range().begin());
     }
 
-    // Technically this is only needed if kernel virtual region OR
-    // user virtual region for a process with multiple threads.
-    // Otherwise we can afford unmap_local
+    // Only processors that have the address space loaded get an IPI,
+    // so this is local unless other threads of this process are running.
     if (vr.is_supervisor() == IsSupervisor::YES)
         AddressSpace::of_kernel().unmap_range(vr.virtual_range());
     else if (AddressSpace::current() != AddressSpace::of_kernel())
@@ -902,6 +1116,17 @@ void MemoryManager::free_virtual_region(VirtualRegion& vr)
 
 void MemoryManager::free_all_virtual_regions(Process& process)
 {
+    // Kernel mappings are visible to every processor, so shoot all of them down
+    // with one round of IPIs before any of the backing pages get released.
+    {
+        AddressSpace::UnmapBatch batch(AddressSpace::of_kernel());
+
+        for (auto& vr : process.virtual_regions()) {
+            if (vr->is_supervisor() == IsSupervisor::YES && (vr->is_private() || vr->is_non_owning()))
+                batch.unmap_range(vr->virtual_range());
+        }
+    }
+
     for (auto& vr : process.virtual_regions()) {
         ASSERT(!vr->is_eternal());
         ASSERT(!vr->is_released());
@@ -911,13 +1136,12 @@ void MemoryManager::free_all_virtual_regions(Process& process)
 
             if (pvr->is_supervisor() == IsSupervisor::YES) {
                 LOCK_GUARD(m_virtual_region_lock);
-                AddressSpace::of_kernel().unmap_range(vr->virtual_range());
                 m_kernel_virtual_regions.remove(pvr->virtual_range().begin());
             }
 
             release_all_pages(*pvr);
         } else if (vr->is_non_owning() && vr->is_supervisor() == IsSupervisor::YES) {
-            AddressSpace::of_kernel().unmap_range(vr->virtual_range());
+            // Already unmapped above
         } else if (vr->is_shared()) {
             auto* svr = static_cast<SharedVirtualRegion*>(vr.get());
 
@@ -20,6 +20,7 @@
 namespace kernel {
 
 class PageFault;
+class PhysicalPageCache;
 
 // defined in Architecture/X/Entrypoint.asm
 extern "C" ptr_t bsp_kernel_stack_end;
@@ -193,12 +194,16 @@ public:
     struct PhysicalStats {
         size_t total_bytes;
         size_t free_bytes;
+
+        // Free pages already zeroed by the PageZeroer, included in free_bytes
+        size_t zeroed_bytes;
+        u64 zeroed_pool_hits;
+        u64 zeroed_pool_misses;
+        u64 background_zeroing_ns;
+        u64 synchronous_zeroing_ns;
     };
 
-    [[nodiscard]] PhysicalStats physical_stats() const
-    {
-        return { m_initial_physical_bytes.load(MemoryOrder::ACQUIRE), m_free_physical_bytes.load(MemoryOrder::ACQUIRE) };
-    }
+    [[nodiscard]] PhysicalStats physical_stats() const;
 
     using VR = RefPtr<VirtualRegion>;
 
@@ -228,10 +233,18 @@ public:
     void free_all_virtual_regions(Process&);
     void free_address_space(AddressSpace&);
 
+    // Kernel regions for kernel addresses, regions of the current process otherwise
+    VR virtual_region_responsible_for_address(Address);
+
     // Only use directly when must, otherwise use functions above
     [[nodiscard]] Page allocate_page(bool should_zero = true);
     void free_page(const Page& page);
 
+    // Physically contiguous pages starting at an address aligned to alignment bytes, all of them below ceiling.
+    // These bypass the per-processor caches and are freed one page at a time with free_page.
+    [[nodiscard]] Optional<Address> allocate_contiguous_pages(size_t count, size_t alignment = Page::size,
+                                                              Address64 ceiling = max_memory_address.raw(), bool should_zero = true);
+
     // Should only be used publically for performance critical operations
 #ifdef ULTRA_32
     class ScopedPageMapping {
@@ -301,7 +314,20 @@ private:
     }
 
     PhysicalRegion* physical_region_responsible_for_page(const Page&);
-    MemoryManager::VR virtual_region_responsible_for_address(Address);
+
+    // Pages come from the cache of the current processor, which goes to the regions a batch at a time
+    Address take_free_page();
+    Optional<Address> take_zeroed_page();
+    void return_free_page(Address);
+    void refill(PhysicalPageCache&);
+    void drain(PhysicalPageCache&);
+
+    // Up to count pages straight from the regions, returns the number taken
+    size_t take_region_pages(Address* into, size_t count);
+
+    friend class PageZeroer;
+
+    void zero_page(Address physical_address);
 
     static void mark_as_released(VirtualRegion&);
 
@@ -330,6 +356,7 @@ private:
     MemoryMap m_memory_map;
 
     Atomic<size_t> m_initial_physical_bytes { 0 };
+    // Free bytes in the physical regions, not counting pages sitting in the per-processor caches
     Atomic<size_t> m_free_physical_bytes { 0 };
 
 #ifdef ULTRA_32
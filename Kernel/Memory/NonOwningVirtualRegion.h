@@ -8,6 +8,8 @@ namespace kernel {
 
 class NonOwningVirtualRegion : public VirtualRegion {
 public:
+    MAKE_SLAB_ALLOCATED(NonOwningVirtualRegion)
+
     NonOwningVirtualRegion(Range virtual_range, Range physical_range, Properties properties, StringView name)
         : VirtualRegion(virtual_range, properties, name)
         , m_physical_range(physical_range)
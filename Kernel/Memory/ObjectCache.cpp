@@ -0,0 +1,413 @@
+#include "Common/Memory.h"
+#include "Common/String.h"
+
+#include "Core/CPU.h"
+#include "Core/Runtime.h"
+
+#include "Interrupts/Utilities.h"
+
+#include "HeapAllocator.h"
+#include "ObjectCache.h"
+
+namespace kernel {
+
+bool ObjectCache::s_is_initialized;
+size_t ObjectCache::s_cache_count;
+
+// Slab allocated objects are created before global constructors run, so none of this can have one
+alignas(ObjectCache) static u8 cache_storage[ObjectCache::max_caches][sizeof(ObjectCache)];
+alignas(InterruptSafeSpinLock) static u8 registry_lock_storage[sizeof(InterruptSafeSpinLock)];
+
+static InterruptSafeSpinLock& registry_lock()
+{
+    return *reinterpret_cast<InterruptSafeSpinLock*>(registry_lock_storage);
+}
+
+static ObjectCache& cache_at(size_t index)
+{
+    return *reinterpret_cast<ObjectCache*>(cache_storage[index]);
+}
+
+static size_t round_up_to(size_t value, size_t multiple)
+{
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+void ObjectCache::initialize()
+{
+    ASSERT(!s_is_initialized);
+
+    new (registry_lock_storage) InterruptSafeSpinLock;
+    s_is_initialized = true;
+}
+
+ObjectCache& ObjectCache::find_or_create(const char* name, size_t object_size, size_t alignment,
+                                         Constructor constructor, Destructor destructor)
+{
+    ASSERT(s_is_initialized);
+    ASSERT(object_size != 0 && object_size <= max_object_size);
+    ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= max_alignment);
+
+    object_size = round_up_to(object_size, object_size <= 256 ? 16 : 64);
+    object_size = round_up_to(object_size, alignment);
+
+    LOCK_GUARD(registry_lock());
+
+    for (size_t i = 0; i < s_cache_count; ++i) {
+        auto& cache = cache_at(i);
+
+        if (cache.m_object_size == object_size && cache.m_alignment == alignment
+            && cache.m_constructor == constructor && cache.m_destructor == destructor
+            && StringView(cache.m_name) == StringView(name))
+            return cache;
+    }
+
+    if (s_cache_count == max_caches)
+        runtime::panic("ObjectCache: out of cache slots");
+
+    auto* cache = new (cache_storage[s_cache_count]) ObjectCache(s_cache_count, name, object_size, alignment, constructor, destructor);
+    __atomic_store_n(&s_cache_count, s_cache_count + 1, __ATOMIC_RELEASE);
+
+    return *cache;
+}
+
+ObjectCache::ObjectCache(size_t id, const char* name, size_t object_size, size_t alignment,
+                         Constructor constructor, Destructor destructor)
+    : m_id(id)
+    , m_name(name)
+    , m_object_size(object_size)
+    , m_alignment(alignment)
+    , m_constructor(constructor)
+    , m_destructor(destructor)
+{
+    // One index byte per object, end_of_free_list must never be a valid index
+    auto count = min((slab_size - sizeof(Slab)) / (object_size + 1), end_of_free_list);
+
+    for (;; --count) {
+        ASSERT(count != 0);
+
+        auto offset = round_up_to(sizeof(Slab) + count, alignment);
+
+        if (offset + count * object_size <= slab_size) {
+            m_objects_per_slab = count;
+            m_objects_offset = offset;
+            break;
+        }
+    }
+}
+
+ObjectCache::Magazine* ObjectCache::magazine_of_this_processor()
+{
+    if (!CPU::is_initialized())
+        return nullptr;
+
+    auto* magazines = CPU::current().object_magazines();
+
+    return magazines ? &magazines->of(*this) : nullptr;
+}
+
+ObjectCache::Slab* ObjectCache::create_slab()
+{
+    auto* memory = reinterpret_cast<u8*>(HeapAllocator::allocate(slab_size, slab_size));
+    auto* slab = new (memory) Slab;
+
+    slab->owner = this;
+    slab->previous = nullptr;
+    slab->next = nullptr;
+    slab->objects = memory + m_objects_offset;
+    slab->free_count = m_objects_per_slab;
+    slab->first_free = 0;
+
+    for (size_t i = 0; i < m_objects_per_slab; ++i)
+        slab->next_free()[i] = i + 1 < m_objects_per_slab ? i + 1 : end_of_free_list;
+
+    if (m_constructor) {
+        for (size_t i = 0; i < m_objects_per_slab; ++i)
+            m_constructor(slab->objects + i * m_object_size);
+    }
+
+    return slab;
+}
+
+void ObjectCache::destroy_slab(Slab* slab)
+{
+    ASSERT(slab->free_count == m_objects_per_slab);
+
+    if (m_destructor) {
+        for (size_t i = 0; i < m_objects_per_slab; ++i)
+            m_destructor(slab->objects + i * m_object_size);
+    }
+
+    HeapAllocator::free(slab);
+}
+
+void ObjectCache::link_front(Slab* slab)
+{
+    slab->previous = nullptr;
+    slab->next = m_first_slab;
+
+    if (m_first_slab)
+        m_first_slab->previous = slab;
+    else
+        m_last_slab = slab;
+
+    m_first_slab = slab;
+}
+
+void ObjectCache::link_back(Slab* slab)
+{
+    slab->previous = m_last_slab;
+    slab->next = nullptr;
+
+    if (m_last_slab)
+        m_last_slab->next = slab;
+    else
+        m_first_slab = slab;
+
+    m_last_slab = slab;
+}
+
+void ObjectCache::unlink(Slab* slab)
+{
+    if (slab->previous)
+        slab->previous->next = slab->next;
+    else
+        m_first_slab = slab->next;
+
+    if (slab->next)
+        slab->next->previous = slab->previous;
+    else
+        m_last_slab = slab->previous;
+
+    slab->previous = nullptr;
+    slab->next = nullptr;
+}
+
+void* ObjectCache::take_object()
+{
+    auto* slab = m_first_slab;
+
+    if (!slab)
+        return nullptr;
+
+    if (slab->free_count == m_objects_per_slab)
+        --m_empty_slabs;
+
+    auto index = slab->first_free;
+    ASSERT(index != end_of_free_list);
+
+    slab->first_free = slab->next_free()[index];
+    --slab->free_count;
+    ++m_used_objects;
+
+    // Full slabs aren't on the list, return_object puts them back
+    if (!slab->free_count)
+        unlink(slab);
+
+    return slab->objects + index * m_object_size;
+}
+
+void ObjectCache::return_object(void* object, Slab*& slab_to_destroy)
+{
+    auto* slab = slab_of(object);
+    auto offset = reinterpret_cast<u8*>(object) - slab->objects;
+
+    ASSERT(offset % m_object_size == 0);
+    auto index = offset / m_object_size;
+
+    if (!slab->free_count)
+        link_front(slab);
+
+    slab->next_free()[index] = slab->first_free;
+    slab->first_free = index;
+    ++slab->free_count;
+    --m_used_objects;
+
+    if (slab->free_count != m_objects_per_slab)
+        return;
+
+    unlink(slab);
+
+    if (m_empty_slabs < max_empty_slabs) {
+        link_back(slab);
+        ++m_empty_slabs;
+        return;
+    }
+
+    --m_slab_count;
+    slab_to_destroy = slab;
+}
+
+void* ObjectCache::allocate()
+{
+    {
+        Interrupts::ScopedDisabler d;
+        auto* magazine = magazine_of_this_processor();
+
+        if (magazine) {
+            ++magazine->m_allocations;
+
+            if (!magazine->is_empty()) {
+                ++magazine->m_hits;
+                return magazine->pop();
+            }
+
+            LOCK_GUARD(m_lock);
+
+            for (size_t i = 0; i < Magazine::batch_size; ++i) {
+                auto* object = take_object();
+
+                if (!object)
+                    break;
+
+                magazine->push(object);
+            }
+
+            if (!magazine->is_empty())
+                return magazine->pop();
+        } else {
+            m_early_allocations.fetch_add(1, MemoryOrder::RELAXED);
+        }
+    }
+
+    return allocate_slow();
+}
+
+void* ObjectCache::allocate_slow()
+{
+    {
+        LOCK_GUARD(m_lock);
+
+        if (auto* object = take_object())
+            return object;
+    }
+
+    // Not under the lock, getting memory from the heap might need another object of this very cache
+    auto* slab = create_slab();
+
+    LOCK_GUARD(m_lock);
+
+    ++m_slab_count;
+    ++m_empty_slabs;
+    link_back(slab);
+
+    return take_object();
+}
+
+void ObjectCache::free(void* object)
+{
+    Slab* slabs_to_destroy[Magazine::batch_size];
+    size_t destroy_count = 0;
+
+    {
+        Interrupts::ScopedDisabler d;
+        auto* magazine = magazine_of_this_processor();
+
+        if (magazine) {
+            ++magazine->m_frees;
+
+            if (!magazine->is_full()) {
+                magazine->push(object);
+                return;
+            }
+        }
+
+        LOCK_GUARD(m_lock);
+
+        if (!magazine) {
+            m_early_frees.fetch_add(1, MemoryOrder::RELAXED);
+
+            Slab* slab = nullptr;
+            return_object(object, slab);
+
+            if (slab)
+                slabs_to_destroy[destroy_count++] = slab;
+        } else {
+            // Give back the objects that were freed the longest ago, the fresh ones are still hot in the cache
+            for (size_t i = 0; i < Magazine::batch_size; ++i) {
+                Slab* slab = nullptr;
+                return_object(magazine->m_objects[i], slab);
+
+                if (slab)
+                    slabs_to_destroy[destroy_count++] = slab;
+            }
+
+            magazine->m_count -= Magazine::batch_size;
+            move_memory(magazine->m_objects + Magazine::batch_size, magazine->m_objects, magazine->m_count * sizeof(void*));
+            magazine->push(object);
+        }
+    }
+
+    for (size_t i = 0; i < destroy_count; ++i)
+        destroy_slab(slabs_to_destroy[i]);
+}
+
+DynamicArray<ObjectCache::Stats> ObjectCache::stats()
+{
+    DynamicArray<Stats> stats;
+    auto cache_count = __atomic_load_n(&s_cache_count, __ATOMIC_ACQUIRE);
+    stats.reserve(cache_count);
+
+    for (size_t i = 0; i < cache_count; ++i) {
+        auto& cache = cache_at(i);
+        size_t magazine_objects = 0;
+        u64 allocations = cache.m_early_allocations.load(MemoryOrder::RELAXED);
+        u64 frees = cache.m_early_frees.load(MemoryOrder::RELAXED);
+        u64 magazine_hits = 0;
+
+        if (CPU::is_initialized()) {
+            for (auto& cpu : CPU::processors()) {
+                auto* magazines = cpu.object_magazines();
+
+                if (!magazines)
+                    continue;
+
+                auto& magazine = magazines->of(cache);
+                magazine_objects += magazine.size();
+                allocations += magazine.allocations();
+                frees += magazine.frees();
+                magazine_hits += magazine.hits();
+            }
+        }
+
+        size_t slabs = 0;
+        size_t used_objects = 0;
+
+        {
+            LOCK_GUARD(cache.m_lock);
+            slabs = cache.m_slab_count;
+            used_objects = cache.m_used_objects;
+        }
+
+        // Magazines are read without their processor's cooperation, don't let the race go negative
+        auto active_objects = used_objects > magazine_objects ? used_objects - magazine_objects : 0;
+
+        stats.append({ cache.m_name,
+            cache.m_object_size,
+            cache.m_objects_per_slab,
+            slabs,
+            active_objects,
+            magazine_objects,
+            allocations,
+            frees,
+            magazine_hits });
+    }
+
+    return stats;
+}
+
+ObjectCache& object_cache_for(const char* name, size_t object_size, size_t alignment)
+{
+    return ObjectCache::find_or_create(name, object_size, alignment);
+}
+
+void* allocate_from(ObjectCache& cache)
+{
+    return cache.allocate();
+}
+
+void free_to(ObjectCache& cache, void* object)
+{
+    cache.free(object);
+}
+}
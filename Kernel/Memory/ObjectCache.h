@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/DynamicArray.h"
+#include "Common/Lock.h"
+#include "Common/Macros.h"
+#include "Common/Types.h"
+
+#include "Page.h"
+#include "SlabAllocated.h"
+
+namespace kernel {
+
+// Slab allocator for fixed size objects. Every cache carves page sized slabs from the kernel heap
+// into equally sized objects, and every processor keeps a magazine of free objects for each cache,
+// so that most allocations and frees never take a lock. Slab lists are protected by a per-cache lock,
+// the heap is only touched to get a new slab or to give back an empty one.
+//
+// Caches created with a constructor hand out objects in the constructed state, objects
+// must be freed in that same state. The constructor only runs when a slab is created,
+// and the destructor when it's given back to the heap.
+class ObjectCache {
+    MAKE_NONCOPYABLE(ObjectCache);
+    MAKE_NONMOVABLE(ObjectCache);
+
+public:
+    static constexpr size_t slab_size = Page::size;
+    static constexpr size_t max_object_size = max_slab_object_size;
+    static constexpr size_t max_alignment = 64;
+    static constexpr size_t max_caches = 96;
+
+    using Constructor = void (*)(void*);
+    using Destructor = void (*)(void*);
+
+    // Must be called before anything slab allocated is created, right after the heap is up
+    static void initialize();
+
+    // Caches with the same name, size and alignment are shared. Sizes are rounded up to a few classes
+    // so that different instantiations of the same template end up in the same cache most of the time.
+    static ObjectCache& find_or_create(const char* name, size_t object_size, size_t alignment,
+                                       Constructor = nullptr, Destructor = nullptr);
+
+    void* allocate();
+    void free(void*);
+
+    [[nodiscard]] size_t id() const { return m_id; }
+    [[nodiscard]] size_t object_size() const { return m_object_size; }
+
+    class Magazine {
+    public:
+        static constexpr size_t capacity = 16;
+        static constexpr size_t batch_size = capacity / 2;
+
+        [[nodiscard]] bool is_empty() const { return m_count == 0; }
+        [[nodiscard]] bool is_full() const { return m_count == capacity; }
+
+        // Might be called from other processors for stats, the value is approximate then
+        [[nodiscard]] size_t size() const { return __atomic_load_n(&m_count, __ATOMIC_RELAXED); }
+
+        void* pop()
+        {
+            ASSERT(!is_empty());
+            return m_objects[--m_count];
+        }
+
+        void push(void* object)
+        {
+            ASSERT(!is_full());
+            m_objects[m_count++] = object;
+        }
+
+        // Counted here rather than in the cache, so that a hit never writes to a shared cache line
+        [[nodiscard]] u64 allocations() const { return __atomic_load_n(&m_allocations, __ATOMIC_RELAXED); }
+        [[nodiscard]] u64 frees() const { return __atomic_load_n(&m_frees, __ATOMIC_RELAXED); }
+        [[nodiscard]] u64 hits() const { return __atomic_load_n(&m_hits, __ATOMIC_RELAXED); }
+
+    private:
+        friend class ObjectCache;
+
+        void* m_objects[capacity] {};
+        size_t m_count { 0 };
+
+        u64 m_allocations { 0 };
+        u64 m_frees { 0 };
+        u64 m_hits { 0 };
+    };
+
+    struct Stats {
+        const char* name;
+        size_t object_size;
+        size_t objects_per_slab;
+        size_t slabs;
+        size_t active_objects;
+        size_t magazine_objects;
+        u64 allocations;
+        u64 frees;
+        u64 magazine_hits;
+    };
+
+    static DynamicArray<Stats> stats();
+
+private:
+    ObjectCache(size_t id, const char* name, size_t object_size, size_t alignment, Constructor, Destructor);
+
+    struct Slab {
+        ObjectCache* owner;
+        Slab* previous;
+        Slab* next;
+        u8* objects;
+        size_t free_count;
+        size_t first_free;
+
+        // Free objects are chained through a byte index per object right after the header,
+        // this way a free object is never written to and stays constructed
+        u8* next_free() { return reinterpret_cast<u8*>(this + 1); }
+    };
+
+    static constexpr size_t end_of_free_list = 0xFF;
+
+    Slab* slab_of(void* object) const
+    {
+        auto* slab = reinterpret_cast<Slab*>(reinterpret_cast<ptr_t>(object) & ~(slab_size - 1));
+        ASSERT(slab->owner == this);
+
+        return slab;
+    }
+
+    Magazine* magazine_of_this_processor();
+
+    Slab* create_slab();
+    void destroy_slab(Slab*);
+
+    // These expect the lock to be held
+    void* take_object();
+    void return_object(void* object, Slab*& slab_to_destroy);
+    void link_front(Slab*);
+    void link_back(Slab*);
+    void unlink(Slab*);
+
+    void* allocate_slow();
+
+private:
+    size_t m_id;
+    const char* m_name;
+    size_t m_object_size;
+    size_t m_alignment;
+    size_t m_objects_per_slab;
+    size_t m_objects_offset;
+    Constructor m_constructor;
+    Destructor m_destructor;
+
+    InterruptSafeSpinLock m_lock;
+
+    // Slabs that have at least one free object, partially used ones in front and completely free ones at the back
+    Slab* m_first_slab { nullptr };
+    Slab* m_last_slab { nullptr };
+    size_t m_empty_slabs { 0 };
+    size_t m_slab_count { 0 };
+    size_t m_used_objects { 0 };
+
+    // Only before the processors have magazines, everything after that is counted per processor
+    Atomic<u64> m_early_allocations { 0 };
+    Atomic<u64> m_early_frees { 0 };
+
+    static constexpr size_t max_empty_slabs = 1;
+
+    static bool s_is_initialized;
+    static size_t s_cache_count;
+};
+
+// Magazines of every cache for one processor, lives in CPU::LocalData
+class ObjectMagazines {
+public:
+    ObjectCache::Magazine& of(const ObjectCache& cache) { return m_magazines[cache.id()]; }
+
+private:
+    ObjectCache::Magazine m_magazines[ObjectCache::max_caches];
+};
+}
@@ -0,0 +1,76 @@
+#include "Common/Logger.h"
+#include "Core/CPU.h"
+
+#include "PCID.h"
+
+namespace kernel {
+
+bool PCID::s_is_enabled;
+
+void PCID::initialize_for_this_cpu()
+{
+#ifdef ULTRA_64
+    static constexpr u32 pcid_support_bit = SET_BIT(17);
+    static constexpr size_t pcid_enable_bit = SET_BIT(17);
+
+    if (!(CPU::feature_flags().c & pcid_support_bit))
+        return;
+
+    // The BSP comes first, APs are started after it's done
+    if (!s_is_enabled)
+        log() << "PCID: supported, address space switches won't flush the TLB";
+
+    // We're running with PCID 0 here, which is required for setting the bit
+    CPU::write_cr4(CPU::read_cr4() | pcid_enable_bit);
+    s_is_enabled = true;
+#endif
+}
+
+PCID::Cache::Assignment PCID::Cache::assign(u64 address_space_id, u64 tlb_generation)
+{
+    for (size_t i = 0; i < slot_count; ++i) {
+        auto& slot = m_slots[i];
+
+        if (slot.address_space_id != address_space_id)
+            continue;
+
+        bool needs_flush = slot.tlb_generation != tlb_generation;
+        slot.tlb_generation = tlb_generation;
+        m_active_slot = i;
+
+        return { active_pcid(), needs_flush };
+    }
+
+    m_active_slot = m_next_victim;
+    m_next_victim = (m_next_victim + 1) % slot_count;
+
+    m_slots[m_active_slot] = { address_space_id, tlb_generation };
+
+    return { active_pcid(), true };
+}
+
+bool PCID::Cache::advance_active_generation(u64 tlb_generation)
+{
+    auto& slot = m_slots[m_active_slot];
+
+    // Already flushed past this invalidation
+    if (slot.tlb_generation >= tlb_generation)
+        return true;
+
+    if (slot.tlb_generation + 1 != tlb_generation)
+        return false;
+
+    slot.tlb_generation = tlb_generation;
+    return true;
+}
+
+void PCID::Cache::drop_inactive()
+{
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (i == m_active_slot)
+            continue;
+
+        m_slots[i].tlb_generation = stale_generation;
+    }
+}
+}
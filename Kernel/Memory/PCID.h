@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Common/Macros.h"
+#include "Common/Types.h"
+
+namespace kernel {
+
+// Process-context identifiers let the TLB keep entries of several address spaces at once,
+// so switching between them doesn't have to throw everything away. AMD64 only.
+class PCID {
+    MAKE_STATIC(PCID);
+
+public:
+    static void initialize_for_this_cpu();
+
+    static bool is_enabled() { return s_is_enabled; }
+
+    static constexpr u64 no_flush_bit = 1ull << 63;
+
+    // Per-processor mapping of recently active address spaces to PCIDs.
+    // PCID 0 is what we boot with, it's never handed out to an address space.
+    // Every slot remembers the TLB generation of its address space it's in sync with,
+    // an address space whose generation has moved on since has to be flushed before use.
+    class Cache {
+        MAKE_NONCOPYABLE(Cache);
+        MAKE_NONMOVABLE(Cache);
+
+    public:
+        Cache() = default;
+
+        struct Assignment {
+            u16 pcid;
+            bool needs_flush;
+        };
+
+        Assignment assign(u64 address_space_id, u64 tlb_generation);
+
+        // Accounts for an invalidation of the active address space up to this generation,
+        // returns false if some earlier one was missed and the entire PCID has to be flushed.
+        bool advance_active_generation(u64 tlb_generation);
+        void set_active_generation(u64 tlb_generation) { m_slots[m_active_slot].tlb_generation = tlb_generation; }
+
+        [[nodiscard]] u16 active_pcid() const { return m_active_slot + 1; }
+
+        // Kernel mappings are shared by every address space, so they might be cached under any PCID.
+        // Makes sure every other PCID gets flushed before it's used again.
+        void drop_inactive();
+
+    private:
+        static constexpr size_t slot_count = 8;
+        static constexpr u64 stale_generation = ~0ull;
+
+        struct Slot {
+            u64 address_space_id { 0 };
+            u64 tlb_generation { 0 };
+        };
+
+        Slot m_slots[slot_count] {};
+        size_t m_active_slot { 0 };
+        size_t m_next_victim { 0 };
+    };
+
+private:
+    static bool s_is_enabled;
+};
+}
@@ -0,0 +1,96 @@
+#include "Common/Memory.h"
+
+#include "Core/CPU.h"
+
+#include "Multitasking/Process.h"
+#include "Multitasking/Sleep.h"
+
+#include "Time/TSC.h"
+
+#include "MemoryManager.h"
+#include "PageZeroer.h"
+
+namespace kernel {
+
+InterruptSafeSpinLock PageZeroer::s_pool_lock;
+Address PageZeroer::s_pool[pool_capacity];
+size_t PageZeroer::s_pool_size;
+
+Atomic<u64> PageZeroer::s_pages_zeroed;
+Atomic<u64> PageZeroer::s_background_cycles;
+
+void PageZeroer::spawn()
+{
+    auto process = Process::create_supervisor(&PageZeroer::run, "PageZeroer");
+    process->set_priority_class(PriorityClass::BACKGROUND);
+}
+
+void PageZeroer::run()
+{
+    Thread::current()->set_invulnerable(true);
+
+    for (;;) {
+        // Background priority, anything else that wants to run preempts us between batches
+        if (!fill_batch())
+            sleep::for_milliseconds(idle_poll_interval_ms);
+    }
+}
+
+bool PageZeroer::fill_batch()
+{
+    auto& mm = MemoryManager::the();
+
+    auto pooled_pages = pool_size();
+    auto free_pages = mm.m_free_physical_bytes.load(MemoryOrder::ACQUIRE) / Page::size + pooled_pages;
+    auto target = min(pool_capacity, free_pages / pool_share_of_free_memory);
+
+    if (pooled_pages >= target)
+        return false;
+
+    Address pages[batch_size];
+    auto count = mm.take_region_pages(pages, min(batch_size, target - pooled_pages));
+
+    if (!count)
+        return false;
+
+    for (size_t i = 0; i < count; ++i) {
+        auto start = CPU::read_tsc();
+        mm.zero_page(pages[i]);
+        s_background_cycles.fetch_add(CPU::read_tsc() - start, MemoryOrder::RELAXED);
+    }
+
+    s_pages_zeroed.fetch_add(count, MemoryOrder::RELAXED);
+
+    LOCK_GUARD(s_pool_lock);
+
+    // We're the only ones adding pages, so the space checked above is still there
+    ASSERT(s_pool_size + count <= pool_capacity);
+
+    copy_memory(pages, s_pool + s_pool_size, count * sizeof(Address));
+    __atomic_store_n(&s_pool_size, s_pool_size + count, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+size_t PageZeroer::take_pages(Address* into, size_t count)
+{
+    // Every processor misses at once when the pool runs dry, don't make them line up for the lock to see that
+    if (!pool_size())
+        return 0;
+
+    LOCK_GUARD(s_pool_lock);
+
+    count = min(count, s_pool_size);
+    __atomic_store_n(&s_pool_size, s_pool_size - count, __ATOMIC_RELAXED);
+    copy_memory(s_pool + s_pool_size, into, count * sizeof(Address));
+
+    return count;
+}
+
+PageZeroer::Stats PageZeroer::stats()
+{
+    return { pool_size(),
+        s_pages_zeroed.load(MemoryOrder::RELAXED),
+        TSC::cycles_to_nanoseconds(s_background_cycles.load(MemoryOrder::RELAXED)) };
+}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Lock.h"
+#include "Common/Macros.h"
+#include "Common/Types.h"
+
+namespace kernel {
+
+// Background thread that takes free pages out of the physical regions, zeroes them
+// while the system has nothing better to do and keeps them in a pool. Processors move them
+// to their PhysicalPageCache a batch at a time, so that MemoryManager::allocate_page(should_zero = true)
+// neither has to zero them synchronously nor take the pool lock for every page.
+// Pages in the pool are still free memory, they go back to the allocator when it runs dry.
+class PageZeroer {
+    MAKE_STATIC(PageZeroer);
+
+public:
+    static constexpr size_t pool_capacity = 1024;
+    static constexpr size_t batch_size = 32;
+
+    // Never keep more than 1/pool_share_of_free_memory of free physical memory zeroed
+    static constexpr size_t pool_share_of_free_memory = 8;
+
+    static void spawn();
+
+    // Up to count zeroed pages, returns the number taken. Doesn't touch the lock if the pool is empty.
+    static size_t take_pages(Address* into, size_t count);
+
+    struct Stats {
+        size_t pooled_pages;
+        u64 pages_zeroed_in_background;
+        u64 background_ns;
+    };
+
+    static Stats stats();
+
+    // Approximate, might be called from any processor
+    static size_t pool_size() { return __atomic_load_n(&s_pool_size, __ATOMIC_RELAXED); }
+
+private:
+    [[noreturn]] static void run();
+    static bool fill_batch();
+
+private:
+    static constexpr size_t idle_poll_interval_ms = 100;
+
+    static InterruptSafeSpinLock s_pool_lock;
+    static Address s_pool[pool_capacity];
+    static size_t s_pool_size;
+
+    static Atomic<u64> s_pages_zeroed;
+    static Atomic<u64> s_background_cycles;
+};
+}
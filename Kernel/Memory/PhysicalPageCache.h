@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Macros.h"
+#include "Common/Memory.h"
+#include "Common/Types.h"
+
+namespace kernel {
+
+// Per-processor magazine of free physical pages. MemoryManager moves pages between it and
+// the physical regions a batch at a time, so most allocations and frees never touch a region lock.
+// Pages zeroed by the PageZeroer are kept on a separate, smaller stack that's refilled from its pool.
+// Only ever accessed by its own processor with interrupts disabled.
+class PhysicalPageCache {
+    MAKE_NONCOPYABLE(PhysicalPageCache);
+    MAKE_NONMOVABLE(PhysicalPageCache);
+
+public:
+    PhysicalPageCache() = default;
+
+    static constexpr size_t capacity = 64;
+    static constexpr size_t batch_size = capacity / 2;
+
+    static constexpr size_t zeroed_capacity = 16;
+
+    [[nodiscard]] bool is_empty() const { return m_count == 0; }
+    [[nodiscard]] bool is_full() const { return m_count == capacity; }
+
+    // Might be called from other processors for stats, the value is approximate then
+    [[nodiscard]] size_t size() const { return __atomic_load_n(&m_count, __ATOMIC_RELAXED); }
+
+    Address pop()
+    {
+        ASSERT(!is_empty());
+        return m_pages[--m_count];
+    }
+
+    void push(Address page)
+    {
+        ASSERT(!is_full());
+        m_pages[m_count++] = page;
+    }
+
+    void put_batch(const Address* pages, size_t count)
+    {
+        ASSERT(m_count + count <= capacity);
+
+        copy_memory(pages, m_pages + m_count, count * sizeof(Address));
+        m_count += count;
+        m_refills.fetch_add(1, MemoryOrder::RELAXED);
+    }
+
+    // Takes out up to batch_size of the most recently freed pages, returns the number taken
+    size_t take_batch(Address* into)
+    {
+        auto count = min(m_count, batch_size);
+
+        m_count -= count;
+        copy_memory(m_pages + m_count, into, count * sizeof(Address));
+        m_drains.fetch_add(1, MemoryOrder::RELAXED);
+
+        return count;
+    }
+
+    [[nodiscard]] size_t refills() const { return m_refills.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t drains() const { return m_drains.load(MemoryOrder::RELAXED); }
+
+    [[nodiscard]] bool has_zeroed_pages() const { return m_zeroed_count != 0; }
+    [[nodiscard]] size_t zeroed_size() const { return __atomic_load_n(&m_zeroed_count, __ATOMIC_RELAXED); }
+
+    Address pop_zeroed()
+    {
+        ASSERT(has_zeroed_pages());
+        return m_zeroed_pages[--m_zeroed_count];
+    }
+
+    void put_zeroed_batch(const Address* pages, size_t count)
+    {
+        ASSERT(m_zeroed_count + count <= zeroed_capacity);
+
+        copy_memory(pages, m_zeroed_pages + m_zeroed_count, count * sizeof(Address));
+        m_zeroed_count += count;
+    }
+
+    // Zeroed pages are still free memory, this gives them up once everything else is gone
+    size_t take_zeroed(Address* into, size_t max_count)
+    {
+        auto count = min(m_zeroed_count, max_count);
+
+        m_zeroed_count -= count;
+        copy_memory(m_zeroed_pages + m_zeroed_count, into, count * sizeof(Address));
+
+        return count;
+    }
+
+    // Allocations that wanted a zeroed page, and whether one was ready for them
+    void count_zeroed_hit() { m_zeroed_hits.fetch_add(1, MemoryOrder::RELAXED); }
+    void count_zeroed_miss(u64 zeroing_cycles)
+    {
+        m_zeroed_misses.fetch_add(1, MemoryOrder::RELAXED);
+        m_synchronous_zeroing_cycles.fetch_add(zeroing_cycles, MemoryOrder::RELAXED);
+    }
+
+    [[nodiscard]] u64 zeroed_hits() const { return m_zeroed_hits.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] u64 zeroed_misses() const { return m_zeroed_misses.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] u64 synchronous_zeroing_cycles() const { return m_synchronous_zeroing_cycles.load(MemoryOrder::RELAXED); }
+
+private:
+    Address m_pages[capacity] {};
+    size_t m_count { 0 };
+
+    Address m_zeroed_pages[zeroed_capacity] {};
+    size_t m_zeroed_count { 0 };
+
+    Atomic<u64> m_zeroed_hits { 0 };
+    Atomic<u64> m_zeroed_misses { 0 };
+    Atomic<u64> m_synchronous_zeroing_cycles { 0 };
+
+    Atomic<size_t> m_refills { 0 };
+    Atomic<size_t> m_drains { 0 };
+};
+
+}
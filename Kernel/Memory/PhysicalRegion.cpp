@@ -9,69 +9,99 @@ namespace kernel {
 PhysicalRegion::PhysicalRegion(const Range& range)
     : m_range(range)
     , m_free_pages(range.length() / Page::size)
-    , m_allocation_map(m_free_pages.load(MemoryOrder::ACQUIRE))
+    , m_allocator(range.begin(), range.length() / Page::size)
 {
     ASSERT_PAGE_ALIGNED(Address(range.begin()));
     ASSERT_PAGE_ALIGNED(range.length());
 }
 
-Address PhysicalRegion::bit_as_physical_address(size_t bit)
+Optional<Address> PhysicalRegion::allocate_locked()
 {
-    return m_range.begin() + bit * Page::size;
+    auto address = m_allocator.allocate(0);
+
+    if (!address)
+        return {};
+
+    m_free_pages.fetch_subtract(1, MemoryOrder::ACQ_REL);
+
+#ifdef PHYSICAL_REGION_DEBUG
+    log() << "PhysicalRegion: allocating a page at address " << *address;
+#endif
+
+    return address;
 }
 
-size_t PhysicalRegion::physical_address_as_bit(Address address)
+void PhysicalRegion::free_locked(Address address)
 {
-    ASSERT_PAGE_ALIGNED(address);
+#ifdef PHYSICAL_REGION_DEBUG
+    log() << "PhysicalRegion: deallocating a page at address " << address;
+#endif
 
-    return (address - m_range.begin()) / Page::size;
+    ASSERT(m_range.contains(address));
+
+    m_allocator.free(address);
+    m_free_pages.fetch_add(1, MemoryOrder::ACQ_REL);
 }
 
 Optional<Page> PhysicalRegion::allocate_page()
 {
     LOCK_GUARD(m_lock);
 
-    if (m_free_pages.load(MemoryOrder::ACQUIRE) == 0)
+    auto address = allocate_locked();
+
+    if (!address)
         return {};
 
-    auto index = m_allocation_map.find_bit(false, m_next_hint);
+    return Page(*address);
+}
 
-    if (!index)
-        return {};
+void PhysicalRegion::free_page(const Page& page)
+{
+    LOCK_GUARD(m_lock);
+    free_locked(page.address());
+}
 
-    m_next_hint = static_cast<size_t>(index.value() + 1);
+size_t PhysicalRegion::allocate_pages(Address* into, size_t count)
+{
+    LOCK_GUARD(m_lock);
 
-    // reset hint in case we got the last index
-    if (m_next_hint == m_allocation_map.size())
-        m_next_hint = 0;
+    size_t allocated = 0;
 
-    m_allocation_map.set_bit(*index, true);
-    m_free_pages.fetch_subtract(1, MemoryOrder::ACQ_REL);
+    for (; allocated < count; ++allocated) {
+        auto address = allocate_locked();
 
-#ifdef PHYSICAL_REGION_DEBUG
-    log() << "PhysicalRegion: allocating a page at address " << bit_as_physical_address(index);
-#endif
+        if (!address)
+            break;
 
-    return Page(bit_as_physical_address(*index));
+        into[allocated] = *address;
+    }
+
+    return allocated;
 }
 
-void PhysicalRegion::free_page(const Page& page)
+void PhysicalRegion::free_pages(const Address* pages, size_t count)
 {
     LOCK_GUARD(m_lock);
 
-#ifdef PHYSICAL_REGION_DEBUG
-    log() << "PhysicalRegion: deallocating a page at index " << physical_address_as_bit(page.address())
-          << " Address:" << page.address();
-#endif
+    for (size_t i = 0; i < count; ++i)
+        free_locked(pages[i]);
+}
 
-    ASSERT(m_range.contains(page.address()));
+Optional<Address> PhysicalRegion::allocate_contiguous(size_t page_count, size_t alignment, Address64 ceiling)
+{
+    LOCK_GUARD(m_lock);
 
-    auto bit = physical_address_as_bit(page.address());
+    auto address = m_allocator.allocate_contiguous(page_count, alignment, ceiling.raw());
 
-    // check for double free
-    ASSERT(m_allocation_map.bit_at(bit));
+    if (!address)
+        return {};
 
-    m_allocation_map.set_bit(bit, false);
-    m_free_pages.fetch_add(1, MemoryOrder::ACQ_REL);
+    m_free_pages.fetch_subtract(page_count, MemoryOrder::ACQ_REL);
+
+#ifdef PHYSICAL_REGION_DEBUG
+    log() << "PhysicalRegion: allocating " << page_count << " contiguous pages at address " << *address;
+#endif
+
+    return address;
 }
 }
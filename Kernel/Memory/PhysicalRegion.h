@@ -1,17 +1,15 @@
 #pragma once
 
-#include "Common/DynamicBitArray.h"
 #include "Common/Lock.h"
 #include "Common/Logger.h"
 #include "Common/Optional.h"
 #include "Common/Types.h"
 #include "Common/UniquePtr.h"
+#include "BuddyAllocator.h"
 #include "Range.h"
 
 namespace kernel {
 
-class Page;
-
 class PhysicalRegion {
 public:
     explicit PhysicalRegion(const Range& range);
@@ -23,10 +21,17 @@ public:
     size_t free_page_count() const { return m_free_pages.load(MemoryOrder::ACQUIRE); }
     bool has_free_pages() const { return m_free_pages.load(MemoryOrder::ACQUIRE); }
 
-    [[nodiscard]] Optional<DynamicArray<Page>> allocate_pages(size_t count);
     [[nodiscard]] Optional<Page> allocate_page();
     void free_page(const Page& page);
 
+    // Batched versions of the above that take the lock once, allocate_pages returns the number of pages it got
+    [[nodiscard]] size_t allocate_pages(Address* into, size_t count);
+    void free_pages(const Address* pages, size_t count);
+
+    // Physically contiguous pages, the first one aligned to alignment bytes. Freed one page at a time as usual.
+    [[nodiscard]] Optional<Address> allocate_contiguous(size_t page_count, size_t alignment = Page::size,
+                                                        Address64 ceiling = BuddyAllocator::no_ceiling);
+
     template <typename LoggerT>
     friend LoggerT& operator<<(LoggerT&& logger, const PhysicalRegion& region)
     {
@@ -58,14 +63,13 @@ public:
     }
 
 private:
-    Address bit_as_physical_address(size_t bit);
-    size_t physical_address_as_bit(Address address);
+    Optional<Address> allocate_locked();
+    void free_locked(Address);
 
 private:
     InterruptSafeSpinLock m_lock;
     Range m_range;
     Atomic<size_t> m_free_pages { 0 };
-    size_t m_next_hint { 0 };
-    DynamicBitArray m_allocation_map;
+    BuddyAllocator m_allocator;
 };
 }
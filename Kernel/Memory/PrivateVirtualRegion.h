@@ -8,6 +8,8 @@ namespace kernel {
 
 class PrivateVirtualRegion : public VirtualRegion {
 public:
+    MAKE_SLAB_ALLOCATED(PrivateVirtualRegion)
+
     PrivateVirtualRegion(Range range, Properties properties, StringView name);
 
     void preallocate_entire(bool zeroed = true);
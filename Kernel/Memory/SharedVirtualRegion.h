@@ -8,11 +8,16 @@ namespace kernel {
 
 class SharedVirtualRegion : public VirtualRegion {
 public:
+    MAKE_SLAB_ALLOCATED(SharedVirtualRegion)
+
     SharedVirtualRegion(Range range, Properties properties, StringView name);
 
     void preallocate_entire(bool zeroed = true);
     void preallocate_specific(Range, bool zeroed = true);
 
+    // Same for every mapping of this region, no matter the address space
+    [[nodiscard]] const void* identity() const { return m_shared_block; }
+
     ~SharedVirtualRegion();
 
 private:
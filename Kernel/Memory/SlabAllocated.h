@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common/Macros.h"
+#include "Common/Types.h"
+#include "Core/Runtime.h"
+
+namespace kernel {
+
+class ObjectCache;
+
+// Objects bigger than this don't fit a slab well enough, they keep coming from the heap
+static constexpr size_t max_slab_object_size = 1024;
+
+// Out of line so that the containers in Common can use this header without pulling in the locks
+ObjectCache& object_cache_for(const char* name, size_t object_size, size_t alignment);
+void* allocate_from(ObjectCache&);
+void free_to(ObjectCache&, void*);
+
+template <typename T>
+class SlabAllocated {
+    MAKE_STATIC(SlabAllocated);
+
+public:
+    static void* allocate(const char* name)
+    {
+        if constexpr (sizeof(T) > max_slab_object_size)
+            return ::operator new(sizeof(T));
+        else
+            return allocate_from(cache(name));
+    }
+
+    static void free(void* ptr)
+    {
+        if constexpr (sizeof(T) > max_slab_object_size)
+            ::operator delete(ptr);
+        else
+            free_to(*__atomic_load_n(&s_cache, __ATOMIC_ACQUIRE), ptr);
+    }
+
+private:
+    static ObjectCache& cache(const char* name)
+    {
+        auto* cache = __atomic_load_n(&s_cache, __ATOMIC_ACQUIRE);
+
+        // Racing here is fine, every caller gets the same cache back
+        if (!cache) {
+            cache = &object_cache_for(name, sizeof(T), alignof(T));
+            __atomic_store_n(&s_cache, cache, __ATOMIC_RELEASE);
+        }
+
+        return *cache;
+    }
+
+    inline static ObjectCache* s_cache;
+};
+
+// Routes new/delete of exactly this class through an object cache named after it.
+// Objects of derived classes have a different size and keep coming from the heap,
+// unless the derived class is slab allocated itself. Must be placed in a public section.
+#define MAKE_SLAB_ALLOCATED(class_name)                                    \
+    static void* operator new(size_t size)                                 \
+    {                                                                      \
+        if (size != sizeof(class_name))                                    \
+            return ::operator new(size);                                   \
+                                                                           \
+        return ::kernel::SlabAllocated<class_name>::allocate(#class_name); \
+    }                                                                      \
+                                                                           \
+    static void operator delete(void* ptr, size_t size)                    \
+    {                                                                      \
+        if (size != sizeof(class_name)) {                                  \
+            ::operator delete(ptr);                                        \
+            return;                                                        \
+        }                                                                  \
+                                                                           \
+        ::kernel::SlabAllocated<class_name>::free(ptr);                    \
+    }
+}
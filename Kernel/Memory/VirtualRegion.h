@@ -161,6 +161,7 @@ public:
     }
 
     [[nodiscard]] const String& name() const { return m_name; }
+    void set_name(StringView name) { m_name = name; }
     [[nodiscard]] Properties properties() const { return m_properties; }
     [[nodiscard]] const Range& virtual_range() const { return m_virtual_range; }
 
@@ -54,12 +54,13 @@ IOBlocker::IOBlocker(Thread& blocked_thread)
 SleepBlocker::SleepBlocker(Thread& blocked_thread, u64 wake_time)
     : Blocker(blocked_thread, Type::SLEEP)
     , m_wake_time(wake_time)
+    , m_timeout(on_timeout, this)
 {
 }
 
-bool SleepBlocker::should_be_woken_up() const
+void SleepBlocker::on_timeout(void* blocker)
 {
-    return m_wake_time <= Timer::nanoseconds_since_boot();
+    Scheduler::the().unblock(*static_cast<SleepBlocker*>(blocker));
 }
 
 IRQBlocker::IRQBlocker(Thread& blocked_thread)
@@ -3,6 +3,8 @@
 #include "Common/Atomic.h"
 #include "Common/List.h"
 
+#include "Time/TimerWheel.h"
+
 namespace kernel {
 
 class Thread;
@@ -15,7 +17,8 @@ public:
         IO,
         PROCESS_LOAD,
         SLEEP,
-        IRQ
+        IRQ,
+        FUTEX
     };
 
     enum class Result : u32 {
@@ -54,7 +57,7 @@ public:
     bool is_interruptable() override { return false; }
 };
 
-class MutexBlocker : public Blocker, public StandaloneListNode<MutexBlocker> {
+class MutexBlocker : public Blocker {
 public:
     MutexBlocker(Thread& blocked_thread);
 
@@ -70,7 +73,7 @@ public:
     bool is_interruptable() override { return false; }
 };
 
-class IOBlocker : public Blocker, public StandaloneListNode<IOBlocker> {
+class IOBlocker : public Blocker {
 public:
     IOBlocker(Thread& blocked_thread);
 };
@@ -79,22 +82,16 @@ class SleepBlocker : public Blocker {
 public:
     SleepBlocker(Thread& blocked_thread, u64 wake_time);
 
-    class WakeTimePtrComparator {
-    public:
-        bool operator()(const SleepBlocker* l, const SleepBlocker* r) const
-        {
-            ASSERT(l != nullptr);
-            ASSERT(r != nullptr);
+    [[nodiscard]] u64 wakeup_time() const { return m_wake_time; }
 
-            return l->wakeup_time() < r->wakeup_time();
-        }
-    };
+    Timeout& timeout() { return m_timeout; }
 
-    [[nodiscard]] u64 wakeup_time() const { return m_wake_time; }
-    [[nodiscard]] bool should_be_woken_up() const;
+private:
+    static void on_timeout(void* blocker);
 
 private:
     u64 m_wake_time { 0 };
+    Timeout m_timeout;
 };
 
 class IRQBlocker : public Blocker {
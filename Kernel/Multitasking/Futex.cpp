@@ -0,0 +1,171 @@
+#include "Interrupts/Timer.h"
+#include "Memory/MemoryManager.h"
+#include "Memory/SafeOperations.h"
+#include "Memory/SharedVirtualRegion.h"
+
+#include "Futex.h"
+#include "Scheduler.h"
+#include "Thread.h"
+
+namespace kernel {
+
+Futex::Bucket Futex::s_buckets[bucket_count];
+
+Futex::Waiter::Waiter(Thread& blocked_thread, const Key& key)
+    : Blocker(blocked_thread, Type::FUTEX)
+    , m_key(key)
+    , m_timeout(on_timeout, this)
+{
+}
+
+void Futex::Waiter::arm_timeout(u64 deadline)
+{
+    m_has_timeout = true;
+    m_timeout.arm(deadline);
+}
+
+void Futex::Waiter::disarm_timeout()
+{
+    if (!m_has_timeout || m_timeout.cancel())
+        return;
+
+    // Already fired, possibly still running on some other processor
+    while (!m_timeout_done.load(MemoryOrder::ACQUIRE))
+        pause();
+}
+
+void Futex::Waiter::on_timeout(void* context)
+{
+    auto& waiter = *static_cast<Waiter*>(context);
+
+    {
+        auto& bucket = bucket_for(waiter.key());
+        LOCK_GUARD(bucket.lock);
+
+        // Woken up normally in the meantime
+        if (waiter.is_on_a_list()) {
+            waiter.pop_off();
+            waiter.set_result(Result::TIMEOUT);
+            Scheduler::the().unblock(waiter);
+        }
+    }
+
+    // The waiter is free to go away past this point
+    waiter.m_timeout_done.store(true, MemoryOrder::RELEASE);
+}
+
+ErrorOr<Futex::Key> Futex::key_for(Address user_address)
+{
+    auto region = MemoryManager::the().virtual_region_responsible_for_address(user_address);
+
+    if (!region || region->is_supervisor() == IsSupervisor::YES)
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    if (region->is_shared()) {
+        auto& shared_region = static_cast<SharedVirtualRegion&>(*region);
+        return Key { shared_region.identity(), user_address - region->virtual_range().begin() };
+    }
+
+    return Key { &AddressSpace::current(), user_address };
+}
+
+Futex::Bucket& Futex::bucket_for(const Key& key)
+{
+    auto hash = reinterpret_cast<ptr_t>(key.space) ^ (key.offset >> 2);
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return s_buckets[hash % bucket_count];
+}
+
+bool Futex::read_user_word(Address user_address, u32& value)
+{
+    return safe_copy_memory(user_address.as_pointer<void>(), &value, sizeof(u32));
+}
+
+ErrorCode Futex::wait(Address user_address, u32 expected, u64 timeout_ns)
+{
+    if (!MemoryManager::is_potentially_valid_userspace_pointer(user_address) || user_address % sizeof(u32))
+        return ErrorCode::INVALID_ARGUMENT;
+
+    // Faults the page in if needed, so that the read below can be done with the bucket locked
+    u32 value = 0;
+    if (!read_user_word(user_address, value))
+        return ErrorCode::MEMORY_ACCESS_VIOLATION;
+
+    auto key = key_for(user_address);
+    if (key.is_error())
+        return key.error();
+
+    auto& bucket = bucket_for(key.value());
+    Waiter waiter(*Thread::current(), key.value());
+
+    {
+        LOCK_GUARD(bucket.lock);
+
+        // Checked under the lock, a waker changes the value before taking it, so no wake up is lost
+        if (!read_user_word(user_address, value))
+            return ErrorCode::MEMORY_ACCESS_VIOLATION;
+        if (value != expected)
+            return ErrorCode::TRY_AGAIN;
+
+        bucket.waiters.insert_back(waiter);
+    }
+
+    if (timeout_ns)
+        waiter.arm_timeout(Timer::nanoseconds_since_boot() + timeout_ns);
+
+    auto result = waiter.block();
+    waiter.disarm_timeout();
+
+    {
+        LOCK_GUARD(bucket.lock);
+        if (waiter.is_on_a_list())
+            waiter.pop_off();
+    }
+
+    switch (result) {
+    case Blocker::Result::UNBLOCKED:
+        return ErrorCode::NO_ERROR;
+    case Blocker::Result::TIMEOUT:
+        return ErrorCode::TIMED_OUT;
+    default:
+        return ErrorCode::INTERRUPTED;
+    }
+}
+
+ErrorOr<size_t> Futex::wake(Address user_address, size_t count)
+{
+    if (!MemoryManager::is_potentially_valid_userspace_pointer(user_address) || user_address % sizeof(u32))
+        return ErrorCode::INVALID_ARGUMENT;
+
+    auto key = key_for(user_address);
+    if (key.is_error())
+        return key.error();
+
+    auto& bucket = bucket_for(key.value());
+    size_t woken = 0;
+
+    LOCK_GUARD(bucket.lock);
+
+    for (auto itr = bucket.waiters.begin(); itr != bucket.waiters.end() && woken < count;) {
+        auto& waiter = *itr++;
+
+        if (!(waiter.key() == key.value()))
+            continue;
+
+        waiter.pop_off();
+
+        // Interrupted but hasn't gotten around to removing itself yet
+        if (!waiter.should_block())
+            continue;
+
+        waiter.unblock();
+        ++woken;
+    }
+
+    return woken;
+}
+
+}
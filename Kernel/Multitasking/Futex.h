@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common/List.h"
+#include "Common/Lock.h"
+#include "Common/Macros.h"
+#include "Core/ErrorCode.h"
+
+#include "Blocker.h"
+
+namespace kernel {
+
+// Userland synchronization primitive: threads wait on a 32-bit word in their address space
+// and get woken up by whoever changes it. The uncontended paths never have to enter the kernel.
+class Futex {
+    MAKE_STATIC(Futex);
+
+public:
+    // Blocks until woken up if the word at user_address still contains expected.
+    // Fails with TRY_AGAIN if it doesn't, timeout_ns of 0 means no timeout.
+    static ErrorCode wait(Address user_address, u32 expected, u64 timeout_ns);
+
+    // Wakes up to count waiters of user_address, returns the number actually woken up
+    static ErrorOr<size_t> wake(Address user_address, size_t count);
+
+    // Private mappings are told apart by their address space, shared ones by the
+    // region they're a window into, so every process mapping it agrees on the key.
+    struct Key {
+        const void* space { nullptr };
+        ptr_t offset { 0 };
+
+        friend bool operator==(const Key& l, const Key& r) { return l.space == r.space && l.offset == r.offset; }
+    };
+
+private:
+    class Waiter : public Blocker, public StandaloneListNode<Waiter> {
+    public:
+        Waiter(Thread& blocked_thread, const Key& key);
+
+        const Key& key() const { return m_key; }
+
+        void arm_timeout(u64 deadline);
+
+        // Makes sure the timeout callback isn't running anymore, so the waiter can go away
+        void disarm_timeout();
+
+    private:
+        static void on_timeout(void* waiter);
+
+    private:
+        Key m_key;
+        Timeout m_timeout;
+        bool m_has_timeout { false };
+        Atomic<bool> m_timeout_done { false };
+    };
+
+    struct Bucket {
+        InterruptSafeSpinLock lock;
+        List<Waiter> waiters;
+    };
+
+    static constexpr size_t bucket_count = 64;
+
+    static ErrorOr<Key> key_for(Address user_address);
+    static Bucket& bucket_for(const Key&);
+    static bool read_user_word(Address user_address, u32& value);
+
+    static Bucket s_buckets[bucket_count];
+};
+
+}
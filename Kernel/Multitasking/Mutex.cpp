@@ -5,6 +5,9 @@ namespace kernel {
 
 void Mutex::lock()
 {
+    bool contended = false;
+    bool spun = false;
+
     for (;;) {
         bool interrupt_state = false;
         ILOCK(m_state_access_lock, interrupt_state);
@@ -14,21 +17,46 @@ void Mutex::lock()
         // Threads shouldn't be able to die when acquiring/owning a mutex
         ASSERT(current_thread->is_invulnerable());
 
-        if (m_owner == current_thread)
+        auto* current_owner = owner();
+
+        if (current_owner == current_thread)
             FAILED_ASSERTION("Mutex deadlock");
 
-        if (m_owner == nullptr) {
-            m_owner = current_thread;
+        if (current_owner == nullptr) {
+            set_owner(current_thread);
             m_state_access_lock.unlock(interrupt_state);
+
+            if (spun)
+                did_spin_successfully();
+
             return;
         }
 
+        if (!contended) {
+            contended = true;
+            did_contend();
+        }
+
+        auto* owner_processor = spun ? nullptr : processor_to_spin_on(current_owner);
+
+        if (owner_processor) {
+            m_state_access_lock.unlock(interrupt_state);
+
+            spun = true;
+            spin_on(current_owner, *owner_processor);
+            continue;
+        }
+
         MutexBlocker blocker(*current_thread);
-        m_waiters.insert_back(blocker);
+        WaitQueue::Entry entry(blocker);
+        m_waiters.add(entry);
         m_state_access_lock.unlock(interrupt_state);
 
         auto res = blocker.block();
         ASSERT(res == Blocker::Result::UNBLOCKED);
+
+        // Whoever we're racing against now gets a fresh spin
+        spun = false;
     }
 }
 
@@ -36,19 +64,17 @@ void Mutex::unlock()
 {
     LOCK_GUARD(m_state_access_lock);
 
-    ASSERT(m_owner == Thread::current());
-
-    m_owner = nullptr;
-
-    if (m_waiters.empty())
-        return;
+    ASSERT(owner() == Thread::current());
 
-    auto& blocker = m_waiters.pop_front();
-    blocker.unblock();
+    set_owner(nullptr);
+    m_waiters.wake_one();
 }
 
 void SharedMutex::exclusive_lock()
 {
+    bool contended = false;
+    bool spun = false;
+
     for (;;) {
         bool interrupt_state = false;
         ILOCK(m_state_access_lock, interrupt_state);
@@ -60,16 +86,41 @@ void SharedMutex::exclusive_lock()
 
         if (m_shared_refcount == free_mode) {
             m_shared_refcount = exclusive_mode;
+            set_owner(current_thread);
             m_state_access_lock.unlock(interrupt_state);
+
+            if (spun)
+                did_spin_successfully();
+
             return;
         }
 
+        if (!contended) {
+            contended = true;
+            did_contend();
+        }
+
+        auto* current_owner = owner();
+
+        auto* owner_processor = spun || !current_owner ? nullptr : processor_to_spin_on(current_owner);
+
+        if (owner_processor) {
+            m_state_access_lock.unlock(interrupt_state);
+
+            spun = true;
+            spin_on(current_owner, *owner_processor);
+            continue;
+        }
+
         MutexBlocker blocker(*current_thread);
-        m_exclusive_waiters.insert_back(blocker);
+        WaitQueue::Entry entry(blocker);
+        m_exclusive_waiters.add(entry);
         m_state_access_lock.unlock(interrupt_state);
 
         auto res = blocker.block();
         ASSERT(res == Blocker::Result::UNBLOCKED);
+
+        spun = false;
     }
 }
 
@@ -79,24 +130,22 @@ void SharedMutex::exclusive_unlock()
 
     ASSERT(m_shared_refcount == exclusive_mode);
     m_shared_refcount = free_mode;
+    set_owner(nullptr);
 
-    bool woke_one = false;
-
-    while (!m_shared_waiters.empty()) {
-        woke_one = true;
-        auto& waiter = m_shared_waiters.pop_front();
-        waiter.unblock();
-    }
-
-    if (woke_one)
+    // Readers first, a writer is only woken up if there's none
+    if (!m_shared_waiters.empty()) {
+        m_shared_waiters.wake_all();
         return;
+    }
 
-    if (!m_exclusive_waiters.empty())
-        m_exclusive_waiters.pop_front().unblock();
+    m_exclusive_waiters.wake_one();
 }
 
 void SharedMutex::shared_lock()
 {
+    bool contended = false;
+    bool spun = false;
+
     for (;;) {
         bool interrupt_state = false;
         ILOCK(m_state_access_lock, interrupt_state);
@@ -109,15 +158,39 @@ void SharedMutex::shared_lock()
         if (m_shared_refcount >= free_mode) {
             m_shared_refcount++;
             m_state_access_lock.unlock(interrupt_state);
+
+            if (spun)
+                did_spin_successfully();
+
             return;
         }
 
+        if (!contended) {
+            contended = true;
+            did_contend();
+        }
+
+        auto* current_owner = owner();
+
+        auto* owner_processor = spun || !current_owner ? nullptr : processor_to_spin_on(current_owner);
+
+        if (owner_processor) {
+            m_state_access_lock.unlock(interrupt_state);
+
+            spun = true;
+            spin_on(current_owner, *owner_processor);
+            continue;
+        }
+
         MutexBlocker blocker(*current_thread);
-        m_shared_waiters.insert_back(blocker);
+        WaitQueue::Entry entry(blocker, false);
+        m_shared_waiters.add(entry);
         m_state_access_lock.unlock(interrupt_state);
 
         auto res = blocker.block();
         ASSERT(res == Blocker::Result::UNBLOCKED);
+
+        spun = false;
     }
 }
 
@@ -129,8 +202,8 @@ void SharedMutex::shared_unlock()
 
     auto new_refcount = --m_shared_refcount;
 
-    if (new_refcount == free_mode && !m_exclusive_waiters.empty())
-        m_exclusive_waiters.pop_front().unblock();
+    if (new_refcount == free_mode)
+        m_exclusive_waiters.wake_one();
 }
 
 }
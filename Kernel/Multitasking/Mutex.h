@@ -2,24 +2,77 @@
 
 #include "Blocker.h"
 #include "Common/Lock.h"
+#include "Core/CPU.h"
+#include "WaitQueue.h"
 
 namespace kernel {
 
 class Thread;
 
-class Mutex {
+// Contended acquirers spin for a while if the owner is running on another processor,
+// most critical sections are short enough to be over before a context switch would be.
+class AdaptiveSpinner {
+public:
+    static constexpr size_t max_spin_iterations = 4096;
+
+    [[nodiscard]] size_t contention_count() const { return m_contention_count.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t spin_success_count() const { return m_spin_success_count.load(MemoryOrder::RELAXED); }
+
+protected:
+    void set_owner(Thread* owner)
+    {
+        m_owner_processor.store(owner ? &CPU::current() : nullptr, MemoryOrder::RELAXED);
+        m_owner.store(owner, MemoryOrder::RELEASE);
+    }
+
+    [[nodiscard]] Thread* owner() const { return m_owner.load(MemoryOrder::ACQUIRE); }
+
+    // Must be called with the state lock held, returns the processor the owner is running on or nullptr if it isn't.
+    // The owner is only ever compared against so it's never dereferenced and is free to go away while we're spinning.
+    [[nodiscard]] CPU::LocalData* processor_to_spin_on(Thread* owner) const
+    {
+        auto* processor = m_owner_processor.load(MemoryOrder::RELAXED);
+        return processor && processor->current_thread() == owner ? processor : nullptr;
+    }
+
+    // Returns once the owner has changed or stopped running, or the budget has run out.
+    // The processor comes from processor_to_spin_on, m_owner_processor can't be trusted without the state lock.
+    void spin_on(Thread* owner, CPU::LocalData& processor)
+    {
+        for (size_t i = 0; i < max_spin_iterations; ++i) {
+            if (m_owner.load(MemoryOrder::ACQUIRE) != owner)
+                return;
+            if (processor.current_thread() != owner)
+                return;
+
+            pause();
+        }
+    }
+
+    void did_contend() { m_contention_count.fetch_add(1, MemoryOrder::RELAXED); }
+    void did_spin_successfully() { m_spin_success_count.fetch_add(1, MemoryOrder::RELAXED); }
+
+private:
+    Atomic<Thread*> m_owner { nullptr };
+    Atomic<CPU::LocalData*> m_owner_processor { nullptr };
+
+    Atomic<size_t> m_contention_count { 0 };
+    Atomic<size_t> m_spin_success_count { 0 };
+};
+
+class Mutex : public AdaptiveSpinner {
 public:
     void lock();
     void unlock();
 
 private:
     InterruptSafeSpinLock m_state_access_lock;
-    Thread* m_owner { nullptr };
 
-    List<MutexBlocker> m_waiters;
+    WaitQueue m_waiters;
 };
 
-class SharedMutex {
+// Only exclusive owners are spun on, there's no single thread to watch in shared mode
+class SharedMutex : public AdaptiveSpinner {
 public:
     void exclusive_lock();
     void exclusive_unlock();
@@ -38,8 +91,8 @@ private:
     // > 0 - shared ownership of N
     ssize_t m_shared_refcount { 0 };
 
-    List<MutexBlocker> m_shared_waiters;
-    List<MutexBlocker> m_exclusive_waiters;
+    WaitQueue m_shared_waiters;
+    WaitQueue m_exclusive_waiters;
 };
 
 template <>
@@ -3,6 +3,7 @@
 #include "Interrupts/Utilities.h"
 #include "Memory/MemoryManager.h"
 #include "Scheduler.h"
+#include "ThreadResourceCache.h"
 
 namespace kernel {
 
@@ -30,7 +31,7 @@ RefPtr<Process> Process::create_supervisor(Address entrypoint, StringView name,
     String process_name;
     process_name << name << " thread 0 stack"_sv;
 
-    auto stack = MemoryManager::the().allocate_kernel_stack(process_name.to_view(), stack_size);
+    auto stack = ThreadResourceCache::allocate_kernel_stack(process_name.to_view(), stack_size);
 
     auto main_thread = Thread::create_supervisor(*process, stack, entrypoint);
     process->m_threads.emplace(main_thread);
@@ -48,7 +49,7 @@ RefPtr<Process> Process::create_user(StringView name, AddressSpace* address_spac
     String process_name;
     process_name << name << " thread 0 stack"_sv;
 
-    auto kernel_stack = MemoryManager::the().allocate_kernel_stack(process_name.to_view(), default_kernel_stack_size);
+    auto kernel_stack = ThreadResourceCache::allocate_kernel_stack(process_name.to_view(), default_kernel_stack_size);
 
     auto main_thread = Thread::create_user(*process, kernel_stack, load_req);
     process->m_threads.emplace(main_thread);
@@ -69,7 +70,7 @@ ErrorCode Process::create_thread(Address entrypoint, size_t stack_size)
         if (m_is_supervisor == IsSupervisor::YES) {
             String name = m_name;
             name << " thread " << m_next_thread_id.load(MemoryOrder::ACQUIRE) << " stack";
-            auto stack = MemoryManager::the().allocate_kernel_stack(name.to_view(), stack_size);
+            auto stack = ThreadResourceCache::allocate_kernel_stack(name.to_view(), stack_size);
             thread = Thread::create_supervisor(*this, stack, entrypoint);
         } else {
             ASSERT_NEVER_REACHED(); // trying to create user thread (TODO)
@@ -93,6 +94,53 @@ Process::Process(AddressSpace& address_space, IsSupervisor is_supervisor, String
 {
 }
 
+void Process::set_priority_class(PriorityClass priority_class)
+{
+    LOCK_GUARD(m_lock);
+
+    m_priority_class.store(priority_class, MemoryOrder::RELEASE);
+
+    for (auto& thread : m_threads)
+        thread->set_priority_class(priority_class);
+}
+
+void Process::set_affinity(Thread::AffinityMask affinity)
+{
+    LOCK_GUARD(m_lock);
+
+    m_affinity.store(affinity, MemoryOrder::RELEASE);
+
+    for (auto& thread : m_threads)
+        thread->set_affinity(affinity);
+}
+
+static void add_cpu_times(CPUTimes& total, const CPUTimes& times)
+{
+    total.user_ns += times.user_ns;
+    total.kernel_ns += times.kernel_ns;
+    total.wait_ns += times.wait_ns;
+    total.max_wait_ns = max(total.max_wait_ns, times.max_wait_ns);
+    total.voluntary_switches += times.voluntary_switches;
+    total.preemptions += times.preemptions;
+}
+
+CPUTimes Process::cpu_times()
+{
+    LOCK_GUARD(m_lock);
+
+    auto times = m_exited_threads_times;
+
+    for (auto& thread : m_threads)
+        add_cpu_times(times, thread->cpu_times());
+
+    return times;
+}
+
+void Process::account_exited_thread(const Thread& thread)
+{
+    add_cpu_times(m_exited_threads_times, thread.cpu_times());
+}
+
 void Process::set_working_directory(StringView path)
 {
     LOCK_GUARD(m_lock);
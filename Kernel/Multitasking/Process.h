@@ -4,6 +4,7 @@
 #include "Common/Set.h"
 
 #include "FileSystem/FileIterator.h"
+#include "FileSystem/IORing.h"
 #include "Memory/VirtualRegion.h"
 #include "TaskLoader.h"
 #include "Thread.h"
@@ -71,6 +72,23 @@ public:
     [[nodiscard]] const String& name() const { return m_name; }
     [[nodiscard]] InterruptSafeSpinLock& lock() const { return m_lock; }
 
+    [[nodiscard]] PriorityClass priority_class() const { return m_priority_class.load(MemoryOrder::ACQUIRE); }
+
+    // Applies to all existing threads as well as the ones created later on
+    void set_priority_class(PriorityClass);
+
+    [[nodiscard]] Thread::AffinityMask affinity() const { return m_affinity.load(MemoryOrder::ACQUIRE); }
+
+    // Same as above, see Thread::set_affinity
+    void set_affinity(Thread::AffinityMask);
+
+    // Sum of all threads, including the ones that have already exited
+    CPUTimes cpu_times();
+
+    // NOTE: not thread safe (lock() must be held)
+    // Called right before an exited thread is freed so that its times aren't lost.
+    void account_exited_thread(const Thread&);
+
     static Process& current() { return CPU::current().current_process(); }
 
     void set_working_directory(StringView);
@@ -83,6 +101,15 @@ public:
     ErrorOr<u32> store_io_stream(const RefPtr<IOStream>&);
     RefPtr<IOStream> pop_io_stream(u32 id);
 
+    [[nodiscard]] IORing* io_ring() const { return m_io_ring.load(MemoryOrder::ACQUIRE); }
+
+    // Takes ownership of the ring, returns false if the process already has one
+    bool install_io_ring(IORing& ring)
+    {
+        IORing* expected = nullptr;
+        return m_io_ring.compare_and_exchange(&expected, &ring);
+    }
+
     friend bool operator<(const RefPtr<Process>& l, const RefPtr<Process>& r)
     {
         return l->id() < r->id();
@@ -101,6 +128,7 @@ public:
     ~Process()
     {
         ASSERT(m_state.load(MemoryOrder::ACQUIRE) == State::EXITED);
+        delete m_io_ring.load(MemoryOrder::ACQUIRE);
     }
 
     [[nodiscard]] u32 alive_thread_count() const { return m_alive_thread_count.load(MemoryOrder::ACQUIRE); }
@@ -142,6 +170,10 @@ private:
     Atomic<u32> m_next_thread_id { main_thread_id };
     Atomic<u32> m_alive_thread_count { 0 }; // not always equal to m_threads.size()
     Atomic<State> m_state { State::ALIVE };
+    Atomic<PriorityClass> m_priority_class { PriorityClass::NORMAL };
+    Atomic<Thread::AffinityMask> m_affinity { Thread::any_processor };
+    Atomic<IORing*> m_io_ring { nullptr };
+    CPUTimes m_exited_threads_times {};
 
     mutable InterruptSafeSpinLock m_lock;
 
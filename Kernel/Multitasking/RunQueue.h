@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/List.h"
+#include "Common/Lock.h"
+
+#include "Thread.h"
+
+namespace kernel {
+
+// Per-processor queue of threads that are ready to run, one FIFO per priority level.
+// Owned by CPU::LocalData, the ready threads must only be accessed with lock() held.
+// Dead threads, the pending migration and the tick deadline are only ever touched by the owning processor with interrupts disabled.
+class RunQueue {
+    MAKE_NONCOPYABLE(RunQueue);
+    MAKE_NONMOVABLE(RunQueue);
+
+public:
+    RunQueue() = default;
+
+    InterruptSafeSpinLock& lock() { return m_lock; }
+
+    // A thread that waited this long gets picked regardless of its priority level
+    static constexpr u64 starvation_threshold = 250 * Time::nanoseconds_in_millisecond;
+
+    void enqueue(Thread& thread)
+    {
+        thread.set_enqueue_time(Timer::nanoseconds_since_boot());
+        m_ready_threads[thread.priority_level()].insert_back(thread);
+        m_size.fetch_add(1, MemoryOrder::RELAXED);
+    }
+
+    Thread* dequeue()
+    {
+        if (size() == 0)
+            return nullptr;
+
+        auto now = Timer::nanoseconds_since_boot();
+        List<Thread>* queue_to_pick = nullptr;
+
+        for (auto& queue : m_ready_threads) {
+            if (queue.empty())
+                continue;
+
+            if (!queue_to_pick) {
+                queue_to_pick = &queue;
+                continue;
+            }
+
+            if (now - queue.front().enqueue_time() >= starvation_threshold) {
+                queue_to_pick = &queue;
+                break;
+            }
+        }
+
+        ASSERT(queue_to_pick != nullptr);
+
+        m_size.fetch_subtract(1, MemoryOrder::RELAXED);
+        return &queue_to_pick->pop_front();
+    }
+
+    // Takes the highest priority thread that's allowed to run on the given processor.
+    // Used for stealing, starvation is left for the owning processor to deal with.
+    Thread* dequeue_for(const CPU::LocalData& processor)
+    {
+        if (size() == 0)
+            return nullptr;
+
+        for (auto& queue : m_ready_threads) {
+            for (auto& thread : queue) {
+                if (!thread.can_run_on(processor))
+                    continue;
+
+                thread.pop_off();
+                m_size.fetch_subtract(1, MemoryOrder::RELAXED);
+                return &thread;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Can be called without the lock, used as a load estimate when picking a processor
+    [[nodiscard]] size_t size() const { return m_size.load(MemoryOrder::RELAXED); }
+
+    List<Thread>& dead_threads() { return m_dead_threads; }
+
+    // The thread this processor just switched away from, which isn't allowed to run here anymore.
+    // It was still running on its own kernel stack while picking the next thread, so it's only
+    // handed over to another processor once the switch is done, see Scheduler::finish_switch.
+    void set_pending_migration(Thread& thread)
+    {
+        ASSERT(m_pending_migration == nullptr);
+        m_pending_migration = &thread;
+    }
+
+    Thread* take_pending_migration()
+    {
+        auto* thread = m_pending_migration;
+        m_pending_migration = nullptr;
+        return thread;
+    }
+
+    // When the owning processor takes its next tick in tickless mode, see Scheduler::arm_tick
+    void set_tick_deadline(u64 deadline) { m_tick_deadline = deadline; }
+    [[nodiscard]] u64 tick_deadline() const { return m_tick_deadline; }
+
+    // Priority level of whatever the owning processor is running, idle_priority_level while idle.
+    // Read by other processors to decide whether a woken up thread should preempt it.
+    static constexpr size_t idle_priority_level = Thread::priority_level_count;
+
+    void set_running_priority_level(size_t level) { m_running_priority_level.store(level, MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t running_priority_level() const { return m_running_priority_level.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] bool is_idle() const { return running_priority_level() == idle_priority_level; }
+
+    // Returns false if a reschedule is already pending, so a burst of wake ups only sends one IPI
+    bool request_reschedule() { return !m_reschedule_pending.exchange(true, MemoryOrder::ACQ_REL); }
+    bool consume_reschedule_request() { return m_reschedule_pending.exchange(false, MemoryOrder::ACQ_REL); }
+
+    // Set right before the owning processor reschedules because of a tick or a wake up request,
+    // tells pick_next that the current thread didn't give up the processor on its own.
+    void set_preempting() { m_is_preempting = true; }
+    bool consume_preempting()
+    {
+        bool is_preempting = m_is_preempting;
+        m_is_preempting = false;
+        return is_preempting;
+    }
+
+    void count_context_switch() { m_context_switches.fetch_add(1, MemoryOrder::RELAXED); }
+    void count_stolen_thread() { m_stolen_threads.fetch_add(1, MemoryOrder::RELAXED); }
+    void count_tick() { m_ticks.fetch_add(1, MemoryOrder::RELAXED); }
+
+    [[nodiscard]] size_t context_switches() const { return m_context_switches.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t stolen_threads() const { return m_stolen_threads.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t ticks() const { return m_ticks.load(MemoryOrder::RELAXED); }
+
+private:
+    InterruptSafeSpinLock m_lock;
+    List<Thread> m_ready_threads[Thread::priority_level_count];
+    List<Thread> m_dead_threads;
+    Thread* m_pending_migration { nullptr };
+    u64 m_tick_deadline { 0 };
+    Atomic<size_t> m_size { 0 };
+    bool m_is_preempting { false };
+    Atomic<size_t> m_running_priority_level { idle_priority_level };
+    Atomic<bool> m_reschedule_pending { false };
+
+    Atomic<size_t> m_context_switches { 0 };
+    Atomic<size_t> m_stolen_threads { 0 };
+    Atomic<size_t> m_ticks { 0 };
+};
+}
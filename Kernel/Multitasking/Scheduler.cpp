@@ -1,15 +1,24 @@
+#include "Core/Profiler.h"
 #include "Core/Runtime.h"
+#include "Core/Tracer.h"
 
 #include "Interrupts/IDT.h"
 #include "Interrupts/Utilities.h"
 #include "Interrupts/DeferredIRQ.h"
+#include "Interrupts/IPICommunicator.h"
+#include "Interrupts/InterruptController.h"
+#include "Interrupts/SyscallDispatcher.h"
 
+#include "Memory/PageZeroer.h"
+
+#include "RunQueue.h"
 #include "Scheduler.h"
 #include "TaskFinalizer.h"
 
 namespace kernel {
 
 InterruptSafeSpinLock Scheduler::s_queues_lock;
+Timer* Scheduler::s_tick_source;
 
 Scheduler* Scheduler::s_instance;
 
@@ -19,35 +28,49 @@ void Scheduler::inititalize()
 
     Process::create_idle_for_this_processor();
     CPU::current().set_tss(*new TSS);
+    SyscallDispatcher::initialize_fast_entry_for_this_cpu();
 #ifdef ULTRA_64
     IDT::the().configure_ist();
 #endif
 
     TaskFinalizer::spawn();
+    PageZeroer::spawn();
     DeferredIRQManager::initialize();
 
     Timer::register_scheduler_handler(on_tick);
 }
 
-void Scheduler::sleep(u64 wake_time)
+void Scheduler::enable_tickless_mode(Timer& timer)
 {
-    SleepBlocker blocker(*Thread::current(), wake_time);
-    block(blocker);
+    ASSERT(timer.is_per_cpu());
+    ASSERT(timer.supports_one_shot());
+
+    s_tick_source = &timer;
 }
 
-void Scheduler::wake_ready_threads()
+void Scheduler::arm_tick(CPU::LocalData& cpu, bool is_idle)
 {
-    if (m_sleeping_threads.empty())
-        return;
+    auto& run_queue = cpu.run_queue();
+    auto now = Timer::nanoseconds_since_boot();
+    auto tick_deadline = run_queue.tick_deadline();
+    auto tick_interval = is_idle ? idle_balance_interval : time_slice;
+
+    // Ticks keep their cadence no matter how often threads get switched, otherwise a processor that
+    // switches more often than every slice would never get one. Coming out of idle cuts the wait back to a slice.
+    if (tick_deadline <= now || tick_deadline > now + tick_interval) {
+        tick_deadline = now + tick_interval;
+        run_queue.set_tick_deadline(tick_deadline);
+    }
 
-    for (auto thread_itr = m_sleeping_threads.begin(); thread_itr != m_sleeping_threads.end();) {
-        if (!(*thread_itr)->should_be_woken_up())
-            return; // we can afford to do this since threads are sorted in wake-up time order
+    // Timeouts armed on this processor only ever fire from its own timer interrupt
+    auto deadline = min(tick_deadline, cpu.timer_wheel().next_deadline());
+    s_tick_source->arm_one_shot(deadline > now ? deadline - now : 0);
+}
 
-        auto* ready_thread = *thread_itr;
-        m_sleeping_threads.remove(thread_itr++);
-        unblock_unchecked(*ready_thread);
-    }
+void Scheduler::sleep(u64 wake_time)
+{
+    SleepBlocker blocker(*Thread::current(), wake_time);
+    block(blocker);
 }
 
 void Scheduler::exit_thread(i32 code)
@@ -96,11 +119,13 @@ void Scheduler::crash(ErrorCode code)
     pick_next();
 }
 
-void Scheduler::free_deferred_threads()
+void Scheduler::free_deferred_threads(CPU::LocalData& cpu)
 {
-    for (auto itr = m_deferred_deleted_dead_threads.begin(); itr != m_deferred_deleted_dead_threads.end(); ++itr) {
+    auto& dead_threads = cpu.run_queue().dead_threads();
+
+    for (auto itr = dead_threads.begin(); itr != dead_threads.end(); ++itr) {
         auto* thread = itr.node();
-        m_deferred_deleted_dead_threads.pop(itr++);
+        dead_threads.pop(itr++);
         TaskFinalizer::the().free_thread(*thread);
     }
 }
@@ -118,29 +143,17 @@ void Scheduler::kill_current_thread()
         if (process.decrement_alive_thread_count() == 0)
             process.exit(current_thread->exit_code());
 
-        m_deferred_deleted_dead_threads.insert_back(*current_thread);
+        CPU::current().run_queue().dead_threads().insert_back(*current_thread);
         return;
     }
 
     // We are the process killer, so we have to kill all threads.
 
-    auto remove_sleeping_blocker = [this](SleepBlocker* blocker) {
-        auto lb = m_sleeping_threads.lower_bound(blocker);
-
-        while (lb != m_sleeping_threads.end() && *lb != blocker)
-            ++lb;
-
-        ASSERT(lb != m_sleeping_threads.end());
-        ASSERT(*lb == blocker);
-
-        m_sleeping_threads.remove(lb);
-    };
-
     LOCK_GUARD(process.lock());
     for (const auto& thread : process.threads()) {
         if (thread.get() == current_thread) {
             process.decrement_alive_thread_count();
-            m_deferred_deleted_dead_threads.insert_back(*current_thread);
+            CPU::current().run_queue().dead_threads().insert_back(*current_thread);
             continue;
         }
 
@@ -148,18 +161,19 @@ void Scheduler::kill_current_thread()
         thread->exit(0);
 
         if (thread->is_blocked()) {
+            // If the timeout fails to cancel it's firing right now, the thread then dies once dequeued
             if (thread->blocker()->type() == Blocker::Type::SLEEP) {
-                process.decrement_alive_thread_count();
-                remove_sleeping_blocker(static_cast<SleepBlocker*>(thread->blocker()));
-                TaskFinalizer::the().free_thread(*thread);
+                if (static_cast<SleepBlocker*>(thread->blocker())->timeout().cancel()) {
+                    process.decrement_alive_thread_count();
+                    TaskFinalizer::the().free_thread(*thread);
+                }
             } else if (thread->interrupt()) { // allow thread to clean-up if needed before exiting
-                m_ready_threads.insert_back(*thread);
+                enqueue(*thread);
             }
-        } else if (thread->is_ready()) {
-            process.decrement_alive_thread_count();
-            thread->pop_off();
-            TaskFinalizer::the().free_thread(*thread);
-        } // else thread is currently running, kill once it gets preempted OR thread is already dead
+        }
+
+        // else thread is either running or sitting in some run queue,
+        // it gets killed once preempted or dequeued OR thread is already dead
     }
 }
 
@@ -174,7 +188,7 @@ void Scheduler::register_process(RefPtr<Process> process)
     for (auto& thread : process->threads()) {
         thread->set_state(Thread::State::READY);
         process->increment_alive_thread_count();
-        m_ready_threads.insert_back(*thread);
+        enqueue(*thread);
     }
 }
 
@@ -207,7 +221,7 @@ bool Scheduler::register_thread(Thread& thread)
     ASSERT(m_processes.contains(thread.owner().id()));
     process.increment_alive_thread_count();
     thread.set_state(Thread::State::READY);
-    m_ready_threads.insert_back(thread);
+    enqueue(thread);
     return true;
 }
 
@@ -216,6 +230,7 @@ void Scheduler::block(Blocker& blocker)
     Interrupts::ScopedDisabler d;
 
     Thread::current()->block(&blocker);
+    TRACE(BLOCK, static_cast<u64>(blocker.type()), 0);
 
     save_state_and_schedule();
 }
@@ -237,8 +252,107 @@ void Scheduler::unblock_unchecked(Blocker& blocker)
         return;
     }
 
+    auto type = blocker.type();
+    if (type == Blocker::Type::IO || type == Blocker::Type::IRQ)
+        thread.boost_priority();
+
     thread.unblock();
-    m_ready_threads.insert_back(thread);
+    TRACE(WAKE_UP, Tracer::key_of(thread), static_cast<u64>(type));
+
+    enqueue(thread);
+}
+
+CPU::LocalData& Scheduler::least_loaded_processor(Thread& thread)
+{
+    auto& current_cpu = CPU::current();
+    CPU::LocalData* best = nullptr;
+    size_t best_load = 0;
+
+    if (thread.can_run_on(current_cpu)) {
+        best = &current_cpu;
+        best_load = current_cpu.run_queue().size();
+    }
+
+    for (auto& cpu : CPU::processors()) {
+        if (!cpu.is_online() || !thread.can_run_on(cpu))
+            continue;
+
+        auto load = cpu.run_queue().size();
+
+        if (!best || load < best_load) {
+            best = &cpu;
+            best_load = load;
+        }
+    }
+
+    // Masks are validated against online processors, so this is only a safety net
+    return best ? *best : current_cpu;
+}
+
+CPU::LocalData& Scheduler::processor_for_ready_thread(Thread& thread)
+{
+    auto can_start_right_away = [](Thread& thread, CPU::LocalData& cpu) {
+        return cpu.is_online() && thread.can_run_on(cpu) && cpu.run_queue().is_idle() && cpu.run_queue().size() == 0;
+    };
+
+    // An idle processor can start running it right away, the current one doesn't even need an IPI
+    auto& current_cpu = CPU::current();
+
+    if (can_start_right_away(thread, current_cpu))
+        return current_cpu;
+
+    // Otherwise prefer the one it last ran on, its caches might still be warm
+    auto* last_cpu = thread.last_processor();
+
+    if (last_cpu && can_start_right_away(thread, *last_cpu))
+        return *last_cpu;
+
+    for (auto& cpu : CPU::processors()) {
+        if (can_start_right_away(thread, cpu))
+            return cpu;
+    }
+
+    return least_loaded_processor(thread);
+}
+
+bool Scheduler::is_valid_affinity(Thread::AffinityMask affinity)
+{
+    for (auto& cpu : CPU::processors()) {
+        if (cpu.is_online() && Thread::affinity_allows(affinity, cpu))
+            return true;
+    }
+
+    return false;
+}
+
+void Scheduler::kick(CPU::LocalData& cpu, size_t priority_level)
+{
+    // No LAPIC to send IPIs with, the thread gets picked up on the next tick
+    if (InterruptController::is_legacy_mode())
+        return;
+
+    auto& run_queue = cpu.run_queue();
+
+    if (priority_level >= run_queue.running_priority_level())
+        return;
+
+    // Goes to ourselves as well, the IPI is then taken as soon as interrupts are enabled again
+    if (run_queue.request_reschedule())
+        IPICommunicator::the().wake_up(cpu.id());
+}
+
+void Scheduler::enqueue(Thread& thread)
+{
+    auto& cpu = processor_for_ready_thread(thread);
+    auto& run_queue = cpu.run_queue();
+    auto priority_level = thread.priority_level();
+
+    {
+        LOCK_GUARD(run_queue.lock());
+        run_queue.enqueue(thread);
+    }
+
+    kick(cpu, priority_level);
 }
 
 Scheduler& Scheduler::the()
@@ -260,42 +374,121 @@ Scheduler::Stats Scheduler::stats() const
 
     LOCK_GUARD(s_queues_lock);
 
-    for (auto& cpu : CPU::processors())
+    for (auto& cpu : CPU::processors()) {
         stats_per_cpu.processor_to_task.emplace(cpu.id(), cpu.current_thread()->owner().name().to_view());
 
+        auto& run_queue = cpu.run_queue();
+        stats_per_cpu.run_queues.append({ cpu.id(), run_queue.size(), run_queue.context_switches(), run_queue.stolen_threads(), run_queue.ticks(),
+            cpu.idle_task().cpu_times().kernel_ns });
+    }
+
+    for (auto& process : m_processes) {
+        LOCK_GUARD(process->lock());
+
+        for (auto& thread : process->threads())
+            stats_per_cpu.threads.append({ process->id(), thread->id(), thread->affinity(), thread->migrations(), thread->cpu_times() });
+    }
+
     return stats_per_cpu;
 }
 
-Thread* Scheduler::pick_next_thread()
+Thread* Scheduler::steal_thread(CPU::LocalData& thief)
 {
-    if (m_ready_threads.empty())
-        return &CPU::current().idle_task();
+    CPU::LocalData* victim = nullptr;
+    size_t victim_load = 0;
+
+    for (auto& cpu : CPU::processors()) {
+        if (&cpu == &thief || !cpu.is_online())
+            continue;
+
+        auto load = cpu.run_queue().size();
+
+        if (load > victim_load) {
+            victim = &cpu;
+            victim_load = load;
+        }
+    }
+
+    if (!victim)
+        return nullptr;
 
-    return &m_ready_threads.pop_front();
+    auto& victim_queue = victim->run_queue();
+
+    // We're already holding our own run queue lock, so never spin on the victim's.
+    // Two processors trying to steal from each other would deadlock otherwise.
+    bool interrupt_state = false;
+    if (!victim_queue.lock().try_lock(interrupt_state, __FILE__, __LINE__, thief.id()))
+        return nullptr;
+
+    auto* thread = victim_queue.dequeue_for(thief);
+    victim_queue.lock().unlock(interrupt_state);
+
+    if (thread)
+        thief.run_queue().count_stolen_thread();
+
+    return thread;
 }
 
-void Scheduler::pick_next()
+Thread* Scheduler::pick_next_thread(CPU::LocalData& cpu, List<Thread>& to_migrate)
 {
-    // Cannot use LOCK_GUARD here as switch_task never returns
-    bool interrupt_state = false;
-    ILOCK(s_queues_lock, interrupt_state);
+    for (;;) {
+        auto* thread = cpu.run_queue().dequeue();
 
-    auto* current_thread = Thread::current();
+        if (!thread)
+            thread = steal_thread(cpu);
 
-    free_deferred_threads();
-    wake_ready_threads();
+        if (!thread)
+            return &cpu.idle_task();
+
+        if (thread->should_die() && !thread->is_invulnerable()) {
+            // Thread's process got killed while this thread was sitting in a run queue
+            thread->set_state(Thread::State::DEAD);
+            thread->owner().decrement_alive_thread_count();
+            TaskFinalizer::the().free_thread(*thread);
+            continue;
+        }
+
+        // Affinity changed while it was sitting here
+        if (!thread->can_run_on(cpu)) {
+            to_migrate.insert_back(*thread);
+            continue;
+        }
+
+        return thread;
+    }
+}
+
+void Scheduler::pick_next()
+{
+    auto& current_cpu = CPU::current();
+    auto& run_queue = current_cpu.run_queue();
+    auto* current_thread = Thread::current();
 
     auto requested_state = current_thread->requested_state();
+    bool should_die = current_thread->should_die() && !current_thread->is_invulnerable();
+
+    // The global lock is only needed to manage blocked threads, plain preemption
+    // and yields only ever touch the run queue of this processor.
+    bool needs_queues_lock = should_die || requested_state != Thread::State::UNDEFINED;
+
+    // Cannot use LOCK_GUARD here as switch_task never returns
+    bool queues_interrupt_state = false;
+    if (needs_queues_lock)
+        ILOCK(s_queues_lock, queues_interrupt_state);
 
-    if (current_thread->should_die() && !current_thread->is_invulnerable()) {
+    free_deferred_threads(current_cpu);
+
+    if (should_die) {
         kill_current_thread();
     } else if (requested_state != Thread::State::UNDEFINED) {
         switch (requested_state) {
         case Thread::State::BLOCKED:
             if (current_thread->blocker()->should_block()) {
                 current_thread->set_state(Thread::State::BLOCKED);
-                if (current_thread->blocker()->type() == Blocker::Type::SLEEP)
-                    m_sleeping_threads.emplace(static_cast<SleepBlocker*>(current_thread->blocker()));
+                if (current_thread->blocker()->type() == Blocker::Type::SLEEP) {
+                    auto* blocker = static_cast<SleepBlocker*>(current_thread->blocker());
+                    current_cpu.timer_wheel().arm(blocker->timeout(), blocker->wakeup_time());
+                }
             } else { // got unblocked too early
                 current_thread->unblock();
             }
@@ -307,21 +500,59 @@ void Scheduler::pick_next()
         current_thread->request_state(Thread::State::UNDEFINED, requested_state);
     }
 
-    if (current_thread->is_running() && current_thread != &CPU::current().idle_task())
-        m_ready_threads.insert_back(*current_thread);
+    bool interrupt_state = false;
+    ILOCK(run_queue.lock(), interrupt_state);
+
+    // We're about to pick the best thread anyway, whoever enqueues one after this point sends a new IPI
+    run_queue.consume_reschedule_request();
 
-    auto* next_thread = pick_next_thread();
+    List<Thread> to_migrate;
+
+    if (current_thread->is_running() && current_thread != &current_cpu.idle_task()) {
+        if (current_thread->can_run_on(current_cpu))
+            run_queue.enqueue(*current_thread);
+        else
+            run_queue.set_pending_migration(*current_thread);
+    }
+
+    auto* next_thread = pick_next_thread(current_cpu, to_migrate);
+
+    run_queue.set_running_priority_level(
+        next_thread == &current_cpu.idle_task() ? RunQueue::idle_priority_level : next_thread->priority_level());
+
+    bool is_preemption = run_queue.consume_preempting();
 
     if (current_thread != next_thread) {
-        current_thread->deactivate();
+        current_thread->deactivate(is_preemption);
         next_thread->activate();
+        run_queue.count_context_switch();
+
+        TRACE(SWITCH, Tracer::key_of(*current_thread), Tracer::key_of(*next_thread));
     }
 
-    s_queues_lock.unlock(interrupt_state);
+    // The BSP keeps its periodic tick, that's what advances the system time and wakes up sleeping threads
+    if (s_tick_source && !current_cpu.is_bsp())
+        arm_tick(current_cpu, next_thread == &current_cpu.idle_task());
+
+    run_queue.lock().unlock(interrupt_state);
+
+    // Never hold two run queue locks at once, same as with stealing
+    while (!to_migrate.empty())
+        enqueue(to_migrate.pop_front());
+
+    if (needs_queues_lock)
+        s_queues_lock.unlock(queues_interrupt_state);
 
     switch_task(next_thread->control_block());
 }
 
+void Scheduler::finish_switch()
+{
+    // Nothing runs on the stack of the previous thread anymore, another processor may pick it up now
+    if (auto* thread = CPU::current().run_queue().take_pending_migration())
+        enqueue(*thread);
+}
+
 void Scheduler::schedule(const RegisterState* ptr)
 {
     Thread::current()->control_block()->current_kernel_stack_top = reinterpret_cast<ptr_t>(ptr);
@@ -330,6 +561,47 @@ void Scheduler::schedule(const RegisterState* ptr)
 
 void Scheduler::on_tick(const RegisterState& registers)
 {
+    auto& current_cpu = CPU::current();
+    auto* current_thread = Thread::current();
+    auto now = Timer::nanoseconds_since_boot();
+
+    // In tickless mode the one-shot also fires for timeouts due before the next tick, that's not a tick of the running thread.
+    // Whatever gets woken up asks for a reschedule on its own.
+    if (s_tick_source && !current_cpu.is_bsp() && now < current_cpu.run_queue().tick_deadline()) {
+        current_cpu.timer_wheel().advance(now);
+        arm_tick(current_cpu, current_thread == &current_cpu.idle_task());
+        return;
+    }
+
+    current_cpu.run_queue().count_tick();
+
+    if (current_thread != &current_cpu.idle_task())
+        current_thread->account_tick();
+
+    Profiler::on_tick(registers);
+
+    // Sleeping threads are woken up here, so they're put into a run queue before we pick the next thread
+    current_cpu.timer_wheel().advance(now);
+
+    // schedule() never returns to IRQManager, which would record this otherwise
+    TRACE(IRQ_EXIT, registers.interrupt_number, 0);
+
+    current_cpu.run_queue().set_preempting();
+    schedule(&registers);
+}
+
+void Scheduler::on_wake_up_request(const RegisterState& registers)
+{
+    if (!is_initialized())
+        return;
+
+    auto& run_queue = CPU::current().run_queue();
+
+    // Might've been handled by a tick or a yield in the meantime
+    if (!run_queue.consume_reschedule_request())
+        return;
+
+    run_queue.set_preempting();
     schedule(&registers);
 }
 }
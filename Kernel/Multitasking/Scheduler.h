@@ -20,6 +20,14 @@ public:
 
     static Scheduler& the();
 
+    // Makes every processor apart from the BSP run off one-shot ticks of this timer,
+    // with the tick stopped entirely (apart from a rare load balancing poll) while idle.
+    static void enable_tickless_mode(Timer&);
+
+    // Called from the IPI handler, picks up work that got queued for an idle processor
+    // or preempts the current thread in favor of a higher priority one that just woke up.
+    static void on_wake_up_request(const RegisterState&);
+
     void yield();
     void sleep(u64 wake_time);
     void block(Blocker&);
@@ -33,37 +41,72 @@ public:
 
     bool register_thread(Thread&);
 
+    struct RunQueueStats {
+        u32 processor_id;
+        size_t ready_threads;
+        size_t context_switches;
+        size_t stolen_threads;
+        size_t ticks;
+        u64 idle_time; // in nanoseconds, only accounted once the processor stops idling
+    };
+
+    struct ThreadStats {
+        u32 process_id;
+        u32 thread_id;
+        Thread::AffinityMask affinity;
+        size_t migrations;
+        CPUTimes times;
+    };
+
     struct Stats {
         DynamicArray<Pair<u32, StringView>> processor_to_task;
+        DynamicArray<RunQueueStats> run_queues;
+        DynamicArray<ThreadStats> threads;
     };
 
     Stats stats() const;
 
+    // Returns false if the mask doesn't allow any of the online processors
+    static bool is_valid_affinity(Thread::AffinityMask);
+
 private:
-    // The 5 functions below assume s_queues_lock is held by the caller
-    void wake_ready_threads();
+    // The 2 functions below assume s_queues_lock is held by the caller
     void unblock_unchecked(Blocker&);
-    Thread* pick_next_thread();
     void kill_current_thread();
-    void free_deferred_threads();
+
+    // The 2 functions below assume the run queue lock of the current processor is held by the caller.
+    // Queued threads that aren't allowed to run here anymore are put into to_migrate, to be enqueued elsewhere once it's released.
+    Thread* pick_next_thread(CPU::LocalData&, List<Thread>& to_migrate);
+    Thread* steal_thread(CPU::LocalData&);
+
+    // Must only be called by the processor that owns the run queue with interrupts disabled
+    void free_deferred_threads(CPU::LocalData&);
+
+    static CPU::LocalData& least_loaded_processor(Thread&);
+    static CPU::LocalData& processor_for_ready_thread(Thread&);
+    static void kick(CPU::LocalData&, size_t priority_level);
+    static void enqueue(Thread&);
+    static void arm_tick(CPU::LocalData&, bool is_idle);
 
     [[noreturn]] void pick_next();
 
     static void schedule(const RegisterState* registers);
     static void on_tick(const RegisterState&);
     [[noreturn]] static void switch_task(Thread::ControlBlock* new_task);
+
+    // Called by switch_task right after moving to the stack of the new thread
+    static void finish_switch() USED;
     static void save_state_and_schedule();
 
 private:
     Set<RefPtr<Process>, Less<>> m_processes; // sorted by pid
 
-    MultiSet<SleepBlocker*, SleepBlocker::WakeTimePtrComparator> m_sleeping_threads; // sorted by wake-up time
-
-    List<Thread> m_deferred_deleted_dead_threads;
-    List<Thread> m_ready_threads;
-
     static InterruptSafeSpinLock s_queues_lock;
 
+    static constexpr u64 time_slice = Time::nanoseconds_in_second / Timer::default_ticks_per_second;
+    static constexpr u64 idle_balance_interval = time_slice * 10;
+    static Timer* s_tick_source;
+
     static Scheduler* s_instance;
 };
 }
@@ -27,7 +27,12 @@ private:
     u32 m_kernel_stack_segment = GDT::kernel_data_selector();
     u32 m_unused_2[23];
 #elif defined(ULTRA_64)
-    u32 m_unused_3[6]; // RSP1/RSP2 + IGN
+    u64 m_unused_3; // RSP1
+
+    // RSP2 is never used as we don't run anything in ring 2,
+    // the SYSCALL entry stashes the userspace stack pointer here.
+    u64 m_syscall_scratch;
+    u32 m_unused_5[2];
     u64 m_ist_slots[7];
     u32 m_unused_4[3];
 #endif
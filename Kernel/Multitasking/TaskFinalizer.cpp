@@ -4,6 +4,7 @@
 #include "Memory/MemoryManager.h"
 #include "Process.h"
 #include "Sleep.h"
+#include "ThreadResourceCache.h"
 #include "WindowManager/Window.h"
 
 namespace kernel {
@@ -18,7 +19,8 @@ TaskFinalizer::TaskFinalizer()
 
 void TaskFinalizer::spawn()
 {
-    Process::create_supervisor(&TaskFinalizer::run, "TaskFinalizer");
+    auto process = Process::create_supervisor(&TaskFinalizer::run, "TaskFinalizer");
+    process->set_priority_class(PriorityClass::BACKGROUND);
 }
 
 void TaskFinalizer::run()
@@ -89,12 +91,14 @@ void TaskFinalizer::do_free_thread(Thread& thread)
     }
 
     if (thread.fpu_state())
-        FPU::free_state(thread.fpu_state());
+        ThreadResourceCache::recycle_fpu_state(thread.fpu_state());
 
-    MemoryManager::the().free_virtual_region(thread.kernel_stack());
+    ThreadResourceCache::recycle_kernel_stack(thread.release_kernel_stack());
 
     {
         LOCK_GUARD(owner.lock());
+        owner.account_exited_thread(thread);
+
         auto& threads = owner.threads();
         threads.remove(thread.id()); // thread gets freed here
 
@@ -1,5 +1,4 @@
 #include "TaskLoader.h"
-#include "Core/FPU.h"
 #include "ELF/ELFLoader.h"
 #include "FileSystem/VFS.h"
 #include "Memory/PrivateVirtualRegion.h"
@@ -149,7 +148,7 @@ void TaskLoader::do_load(LoadRequest* request)
     reg_state->set_instruction_pointer(userspace_entrypoint);
     reg_state->set_userspace_stack_pointer(current_sp);
 
-    FPU::restore_state(main_thread->fpu_state());
+    main_thread->claim_fpu();
 
     Thread::current()->set_invulnerable(false);
     jump_to_userspace(userspace_iret_frame);
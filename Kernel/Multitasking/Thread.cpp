@@ -2,10 +2,12 @@
 #include "Core/Registers.h"
 
 #include "Interrupts/IDT.h"
+#include "Time/TSC.h"
 #include "Process.h"
 #include "Scheduler.h"
 #include "TaskFinalizer.h"
 #include "Thread.h"
+#include "ThreadResourceCache.h"
 
 namespace kernel {
 
@@ -91,6 +93,7 @@ RefPtr<Thread> Thread::create_user(
     adjusted_stack += sizeof(u32) * 2; // ss and esp are not popped for kernel iret
 #endif
     auto thread = new Thread(owner, kernel_stack, IsSupervisor::NO);
+    thread->m_is_in_user_mode = true;
     thread->m_control_block.current_kernel_stack_top = adjusted_stack.raw();
 
     auto* frame = new (adjusted_stack.as_pointer<void>()) RegisterState {};
@@ -149,7 +152,7 @@ RefPtr<Thread> Thread::create_user(
     frame->rflags = static_cast<size_t>(CPU::FLAGS::INTERRUPTS);
 #endif
 
-    thread->m_fpu_state = FPU::allocate_state();
+    thread->m_fpu_state = ThreadResourceCache::allocate_fpu_state();
 
     return thread;
 }
@@ -158,6 +161,8 @@ Thread::Thread(Process& owner)
     : m_id(owner.consume_thread_id())
     , m_owner(owner)
     , m_is_supervisor(IsSupervisor::YES)
+    , m_priority_class(owner.priority_class())
+    , m_affinity(owner.affinity())
 {
 }
 
@@ -167,9 +172,43 @@ Thread::Thread(Process& owner, RefPtr<VirtualRegion> kernel_stack, IsSupervisor
     , m_kernel_stack(kernel_stack)
     , m_control_block { kernel_stack->virtual_range().end() }
     , m_is_supervisor(is_supervisor)
+    , m_priority_class(owner.priority_class())
+    , m_affinity(owner.affinity())
 {
 }
 
+size_t Thread::priority_level() const
+{
+    static constexpr size_t class_to_base_level[] = {
+        0, // REALTIME
+        1, // INTERACTIVE
+        3, // NORMAL
+        5, // BACKGROUND
+    };
+    static_assert(class_to_base_level[static_cast<size_t>(PriorityClass::BACKGROUND)] + max_demotion == priority_level_count - 1);
+
+    auto priority_class = this->priority_class();
+
+    if (priority_class == PriorityClass::REALTIME)
+        return 0;
+
+    return class_to_base_level[static_cast<size_t>(priority_class)] + m_demotion;
+}
+
+void Thread::account_tick()
+{
+    if (priority_class() == PriorityClass::REALTIME)
+        return;
+
+    if (++m_ticks_at_level < ticks_per_level)
+        return;
+
+    m_ticks_at_level = 0;
+
+    if (m_demotion < max_demotion)
+        ++m_demotion;
+}
+
 bool Thread::is_main() const
 {
     return m_id == Process::main_thread_id;
@@ -181,22 +220,54 @@ void Thread::activate()
 
     m_state = State::RUNNING;
 
+    auto& cpu = CPU::current();
+
+    if (m_last_processor && m_last_processor != &cpu)
+        m_migrations.fetch_add(1, MemoryOrder::RELAXED);
+
+    m_last_processor = &cpu;
+
+    // Idle tasks are never enqueued
+    if (m_enqueue_time) {
+        auto wait_time = Timer::nanoseconds_since_boot() - m_enqueue_time;
+
+        m_wait_time.store(m_wait_time.load(MemoryOrder::RELAXED) + wait_time, MemoryOrder::RELAXED);
+        if (wait_time > m_max_wait_time.load(MemoryOrder::RELAXED))
+            m_max_wait_time.store(wait_time, MemoryOrder::RELAXED);
+    }
+
+    m_accounted_until = CPU::read_tsc();
+
     if (is_supervisor() == IsSupervisor::NO)
-        CPU::current().tss().set_kernel_stack_pointer(m_kernel_stack->virtual_range().end());
+        cpu.tss().set_kernel_stack_pointer(m_kernel_stack->virtual_range().end());
 
+    // Our state might still be loaded if nobody else used the FPU here since we last ran,
+    // otherwise it's loaded on the first FPU instruction, most threads never execute one.
     if (m_fpu_state)
-        FPU::restore_state(m_fpu_state);
+        FPU::set_access_trapped(cpu.fpu_owner() != this || m_fpu_processor != &cpu);
 
     if (m_owner.address_space() != AddressSpace::current())
         m_owner.address_space().make_active();
 
-    CPU::current().set_current_thread(this);
+    cpu.set_current_thread(this);
 }
 
-void Thread::deactivate()
+void Thread::deactivate(bool is_preemption)
 {
-    if (m_fpu_state)
-        FPU::save_state(m_fpu_state);
+    account_running_time();
+    m_accounted_until = 0;
+
+    auto& switches = is_preemption ? m_preemptions : m_voluntary_switches;
+    switches.store(switches.load(MemoryOrder::RELAXED) + 1, MemoryOrder::RELAXED);
+
+    // Only save if the FPU was accessible to us, the saved state is up to date otherwise.
+    // Saving it right away means it's always safe to resume this thread on a different processor.
+    if (m_fpu_state) {
+        auto& cpu = CPU::current();
+
+        if (cpu.fpu_owner() == this && m_fpu_processor == &cpu)
+            FPU::save_state(m_fpu_state);
+    }
 
     if (!is_running())
         return;
@@ -204,6 +275,75 @@ void Thread::deactivate()
     m_state = State::READY;
 }
 
+void Thread::account_running_time()
+{
+    // Not activated yet, e.g. the boot context of a processor
+    if (!m_accounted_until)
+        return;
+
+    auto now = CPU::read_tsc();
+    auto& cycles = m_is_in_user_mode ? m_user_cycles : m_kernel_cycles;
+
+    cycles.store(cycles.load(MemoryOrder::RELAXED) + (now - m_accounted_until), MemoryOrder::RELAXED);
+    m_accounted_until = now;
+}
+
+void Thread::switch_accounting_mode(bool is_user)
+{
+    // Everything a supervisor thread does is kernel time
+    if (is_supervisor() == IsSupervisor::YES)
+        return;
+
+    Interrupts::ScopedDisabler d;
+
+    account_running_time();
+    m_is_in_user_mode = is_user;
+}
+
+CPUTimes Thread::cpu_times() const
+{
+    CPUTimes times {};
+
+    times.user_ns = TSC::cycles_to_nanoseconds(m_user_cycles.load(MemoryOrder::RELAXED));
+    times.kernel_ns = TSC::cycles_to_nanoseconds(m_kernel_cycles.load(MemoryOrder::RELAXED));
+    times.wait_ns = m_wait_time.load(MemoryOrder::RELAXED);
+    times.max_wait_ns = m_max_wait_time.load(MemoryOrder::RELAXED);
+    times.voluntary_switches = m_voluntary_switches.load(MemoryOrder::RELAXED);
+    times.preemptions = m_preemptions.load(MemoryOrder::RELAXED);
+
+    return times;
+}
+
+void Thread::claim_fpu()
+{
+    ASSERT(m_fpu_state != nullptr);
+
+    Interrupts::ScopedDisabler d;
+
+    auto& cpu = CPU::current();
+
+    // The previous owner had its state saved when it got switched out
+    FPU::set_access_trapped(false);
+    FPU::restore_state(m_fpu_state);
+
+    cpu.set_fpu_owner(this);
+    m_fpu_processor = &cpu;
+}
+
+void Thread::allocate_fpu_state()
+{
+    ASSERT(this == current());
+    ASSERT(m_fpu_state == nullptr);
+
+    auto* state = ThreadResourceCache::allocate_fpu_state();
+
+    Interrupts::ScopedDisabler d;
+    m_fpu_state = state;
+
+    // FPU registers belong to someone else right now
+    FPU::set_access_trapped(true);
+}
+
 void Thread::unblock()
 {
     ASSERT(m_blocker != nullptr);
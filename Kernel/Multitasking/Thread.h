@@ -10,13 +10,30 @@
 
 #include "Blocker.h"
 
+#include <Shared/CPUTimes.h>
+#include <Shared/Scheduling.h>
+
 namespace kernel {
 
+enum class PriorityClass : u8 {
+#define PRIORITY_CLASS(name) name,
+    ENUMERATE_PRIORITY_CLASSES
+#undef PRIORITY_CLASS
+};
+
+enum class AffinityScope : u8 {
+#define AFFINITY_SCOPE(name) name,
+    ENUMERATE_AFFINITY_SCOPES
+#undef AFFINITY_SCOPE
+};
+
 class Thread : public StandaloneListNode<Thread> {
     MAKE_NONCOPYABLE(Thread);
     MAKE_NONMOVABLE(Thread);
 
 public:
+    MAKE_SLAB_ALLOCATED(Thread)
+
     friend class Process;
 
     enum class State {
@@ -39,12 +56,19 @@ public:
         TaskLoader::LoadRequest*);
 
     void activate();
-    void deactivate();
+    void deactivate(bool is_preemption);
 
     [[nodiscard]] State state() const { return m_state; }
 
     void* fpu_state() const { return m_fpu_state; }
 
+    // Loads the FPU state of this thread, must be called by the processor that's running it
+    void claim_fpu();
+
+    // Supervisor threads don't get an FPU state by default since the kernel itself never uses the FPU.
+    // Must be called by the thread itself.
+    void allocate_fpu_state();
+
     static Thread* current()
     {
         Interrupts::ScopedDisabler d;
@@ -66,6 +90,55 @@ public:
         return *m_kernel_stack;
     }
 
+    RefPtr<VirtualRegion> release_kernel_stack() { return move(m_kernel_stack); }
+
+    // Multilevel feedback queue, lower level means higher priority.
+    // Each priority class (apart from REALTIME) spans max_demotion + 1 levels,
+    // a thread gets demoted after using up ticks_per_level full ticks at its current level
+    // and boosted back to the top level of its class once it wakes up from I/O.
+    static constexpr size_t max_demotion = 2;
+    static constexpr size_t ticks_per_level = 5;
+    static constexpr size_t priority_level_count = 8;
+
+    [[nodiscard]] PriorityClass priority_class() const { return m_priority_class.load(MemoryOrder::ACQUIRE); }
+    void set_priority_class(PriorityClass priority_class) { m_priority_class.store(priority_class, MemoryOrder::RELEASE); }
+    [[nodiscard]] size_t priority_level() const;
+
+    // Bit N allows the thread to run on the processor with index N.
+    // Processors past the width of the mask are only allowed by any_processor.
+    using AffinityMask = u64;
+    static constexpr AffinityMask any_processor = ~static_cast<AffinityMask>(0);
+    static constexpr size_t affinity_mask_bits = sizeof(AffinityMask) * 8;
+
+    [[nodiscard]] AffinityMask affinity() const { return m_affinity.load(MemoryOrder::ACQUIRE); }
+
+    // Takes effect lazily, a thread that's running or queued on a processor it's no longer
+    // allowed on gets moved once it next goes through the scheduler of that processor.
+    void set_affinity(AffinityMask affinity) { m_affinity.store(affinity, MemoryOrder::RELEASE); }
+
+    static bool affinity_allows(AffinityMask affinity, const CPU::LocalData& processor)
+    {
+        if (processor.index() >= affinity_mask_bits)
+            return affinity == any_processor;
+
+        return affinity & (static_cast<AffinityMask>(1) << processor.index());
+    }
+
+    [[nodiscard]] bool can_run_on(const CPU::LocalData& processor) const { return affinity_allows(affinity(), processor); }
+
+    // Processor this thread was last activated on, nullptr if it never ran
+    [[nodiscard]] CPU::LocalData* last_processor() const { return m_last_processor; }
+    [[nodiscard]] size_t migrations() const { return m_migrations.load(MemoryOrder::RELAXED); }
+
+    // CPU time accounting, only ever updated by the processor running the thread.
+    // Running time is counted in TSC cycles and split into user and kernel time at system call
+    // boundaries, so interrupts are attributed to whatever mode the thread was in.
+    void enter_kernel_mode() { switch_accounting_mode(false); }
+    void enter_user_mode() { switch_accounting_mode(true); }
+
+    // Safe to call from any processor, the numbers might be slightly out of date
+    [[nodiscard]] CPUTimes cpu_times() const;
+
     bool should_die() const { return m_should_die.load(MemoryOrder::ACQUIRE); }
     bool is_invulnerable() const { return m_is_invulnerable; }
     void set_invulnerable(bool value) { m_is_invulnerable = value; }
@@ -140,6 +213,7 @@ private:
     Thread(Process& owner, RefPtr<VirtualRegion> kernel_stack, IsSupervisor);
 
     friend class Scheduler;
+    friend class RunQueue;
     void block(Blocker* blocker)
     {
         ASSERT(m_blocker == nullptr);
@@ -148,11 +222,25 @@ private:
         request_state(Thread::State::BLOCKED);
     }
 
+    // Called on every timer tick this thread was running for, only by the processor running it.
+    void account_tick();
+
+    // Called by whoever wakes the thread up, thread must not be running.
+    void boost_priority()
+    {
+        m_demotion = 0;
+        m_ticks_at_level = 0;
+    }
+
+    void set_enqueue_time(u64 time) { m_enqueue_time = time; }
+    [[nodiscard]] u64 enqueue_time() const { return m_enqueue_time; }
+
     void kill_all_threads_on_exit() { m_should_kill_all_threads = true; }
     [[nodiscard]] bool should_kill_all_threads_on_exit() const { return m_should_kill_all_threads; }
 
     // NOTE: Important invariant
-    // All member functions in the following block must only be called with Scheduler::s_queues_lock held.
+    // All member functions in the following block must only be called with Scheduler::s_queues_lock held,
+    // the only exception being READY <-> RUNNING transitions, which are guarded by the run queue lock.
     // ---------------------------------------------------------------------------------------------------
     void unblock();
     bool interrupt();
@@ -206,6 +294,28 @@ private:
     Blocker* m_blocker { nullptr };
 
     void* m_fpu_state { nullptr };
+    CPU::LocalData* m_fpu_processor { nullptr }; // the last processor our FPU state was loaded on
+
+    Atomic<PriorityClass> m_priority_class { PriorityClass::NORMAL };
+    u8 m_demotion { 0 };
+    u8 m_ticks_at_level { 0 };
+    u64 m_enqueue_time { 0 };
+
+    Atomic<AffinityMask> m_affinity { any_processor };
+    CPU::LocalData* m_last_processor { nullptr };
+    Atomic<size_t> m_migrations { 0 };
+
+    void account_running_time();
+    void switch_accounting_mode(bool is_user);
+
+    bool m_is_in_user_mode { false };
+    u64 m_accounted_until { 0 }; // TSC cycles, 0 while not running
+    Atomic<u64> m_user_cycles { 0 };
+    Atomic<u64> m_kernel_cycles { 0 };
+    Atomic<u64> m_wait_time { 0 };
+    Atomic<u64> m_max_wait_time { 0 };
+    Atomic<u64> m_voluntary_switches { 0 };
+    Atomic<u64> m_preemptions { 0 };
 
     Atomic<State> m_requested_state { State::UNDEFINED };
     Atomic<bool> m_should_die { false };
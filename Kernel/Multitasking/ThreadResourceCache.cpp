@@ -0,0 +1,101 @@
+#include "Core/CPU.h"
+#include "Core/FPU.h"
+#include "Memory/MemoryManager.h"
+
+#include "Process.h"
+#include "ThreadResourceCache.h"
+
+namespace kernel {
+
+ThreadResourceCache& ThreadResourceCache::current()
+{
+    return CPU::current().thread_resource_cache();
+}
+
+RefPtr<VirtualRegion> ThreadResourceCache::pop_kernel_stack()
+{
+    LOCK_GUARD(m_lock);
+
+    if (m_kernel_stack_count == 0)
+        return {};
+
+    return move(m_kernel_stacks[--m_kernel_stack_count]);
+}
+
+void* ThreadResourceCache::pop_fpu_state()
+{
+    LOCK_GUARD(m_lock);
+
+    if (m_fpu_state_count == 0)
+        return nullptr;
+
+    return m_fpu_states[--m_fpu_state_count];
+}
+
+RefPtr<VirtualRegion> ThreadResourceCache::allocate_kernel_stack(StringView purpose, size_t length)
+{
+    if (length != Process::default_kernel_stack_size)
+        return MemoryManager::the().allocate_kernel_stack(purpose, length);
+
+    auto& cache = current();
+    auto stack = cache.pop_kernel_stack();
+    cache.count(!stack.is_null());
+
+    if (stack.is_null())
+        return MemoryManager::the().allocate_kernel_stack(purpose, length);
+
+    stack->set_name(purpose);
+    return stack;
+}
+
+void* ThreadResourceCache::allocate_fpu_state()
+{
+    auto& cache = current();
+    auto* state = cache.pop_fpu_state();
+    cache.count(state != nullptr);
+
+    if (!state)
+        return FPU::allocate_state();
+
+    FPU::reset_state(state);
+    return state;
+}
+
+void ThreadResourceCache::recycle_kernel_stack(RefPtr<VirtualRegion> stack)
+{
+    if (stack->virtual_range().length() != Process::default_kernel_stack_size + Page::size) {
+        MemoryManager::the().free_virtual_region(*stack);
+        return;
+    }
+
+    auto& cache = current();
+
+    {
+        LOCK_GUARD(cache.m_lock);
+
+        if (cache.m_kernel_stack_count < capacity) {
+            cache.m_kernel_stacks[cache.m_kernel_stack_count++] = move(stack);
+            return;
+        }
+    }
+
+    MemoryManager::the().free_virtual_region(*stack);
+}
+
+void ThreadResourceCache::recycle_fpu_state(void* state)
+{
+    auto& cache = current();
+
+    {
+        LOCK_GUARD(cache.m_lock);
+
+        if (cache.m_fpu_state_count < capacity) {
+            cache.m_fpu_states[cache.m_fpu_state_count++] = state;
+            return;
+        }
+    }
+
+    FPU::free_state(state);
+}
+
+}
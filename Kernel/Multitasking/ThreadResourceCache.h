@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common/Atomic.h"
+#include "Common/Lock.h"
+#include "Common/Macros.h"
+#include "Common/RefPtr.h"
+#include "Common/String.h"
+
+namespace kernel {
+
+class VirtualRegion;
+
+// Per-processor stash of kernel stacks and FPU save areas of dead threads.
+// A new thread takes them from here instead of allocating, mapping and preallocating them from scratch,
+// TaskFinalizer puts them back instead of freeing. Only stacks of the default size are cached.
+class ThreadResourceCache {
+    MAKE_NONCOPYABLE(ThreadResourceCache);
+    MAKE_NONMOVABLE(ThreadResourceCache);
+
+public:
+    ThreadResourceCache() = default;
+
+    static constexpr size_t capacity = 8;
+
+    static RefPtr<VirtualRegion> allocate_kernel_stack(StringView purpose, size_t length);
+    static void* allocate_fpu_state();
+
+    // Frees the resource if the cache of the current processor is full
+    static void recycle_kernel_stack(RefPtr<VirtualRegion>);
+    static void recycle_fpu_state(void*);
+
+    [[nodiscard]] size_t hits() const { return m_hits.load(MemoryOrder::RELAXED); }
+    [[nodiscard]] size_t misses() const { return m_misses.load(MemoryOrder::RELAXED); }
+
+private:
+    static ThreadResourceCache& current();
+
+    RefPtr<VirtualRegion> pop_kernel_stack();
+    void* pop_fpu_state();
+    void count(bool hit) { (hit ? m_hits : m_misses).fetch_add(1, MemoryOrder::RELAXED); }
+
+private:
+    InterruptSafeSpinLock m_lock;
+
+    RefPtr<VirtualRegion> m_kernel_stacks[capacity];
+    size_t m_kernel_stack_count { 0 };
+
+    void* m_fpu_states[capacity] {};
+    size_t m_fpu_state_count { 0 };
+
+    Atomic<size_t> m_hits { 0 };
+    Atomic<size_t> m_misses { 0 };
+};
+
+}
@@ -0,0 +1,43 @@
+#include "WaitQueue.h"
+
+namespace kernel {
+
+size_t WaitQueue::wake_n(size_t count)
+{
+    size_t woken = 0;
+
+    for (auto itr = m_entries.begin(); itr != m_entries.end();) {
+        if (woken == count && m_non_exclusive_count == 0)
+            break;
+
+        auto& entry = *itr++;
+
+        if (entry.is_exclusive() && woken == count)
+            continue;
+
+        take(entry);
+        auto& blocker = entry.blocker();
+
+        // Interrupted but hasn't taken itself off yet, wouldn't make use of the wake up
+        if (!blocker.should_block())
+            continue;
+
+        blocker.unblock();
+
+        if (entry.is_exclusive())
+            ++woken;
+    }
+
+    return woken;
+}
+
+void WaitQueue::wake_all()
+{
+    while (!m_entries.empty()) {
+        auto& entry = m_entries.front();
+        take(entry);
+        entry.blocker().unblock();
+    }
+}
+
+}
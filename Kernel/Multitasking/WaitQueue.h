@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Common/List.h"
+#include "Common/Macros.h"
+
+#include "Blocker.h"
+
+namespace kernel {
+
+// A list of threads waiting for some condition to become true.
+// Not synchronized on its own, every access must be done with the lock protecting the condition held,
+// that way a waker can never miss a thread that has checked the condition but hasn't blocked yet.
+class WaitQueue {
+    MAKE_NONCOPYABLE(WaitQueue);
+    MAKE_NONMOVABLE(WaitQueue);
+
+public:
+    WaitQueue() = default;
+
+    // Lives on the stack of the waiting thread next to its blocker.
+    // Exclusive entries are woken up one at a time, the rest are woken up whenever anyone is.
+    class Entry : public StandaloneListNode<Entry> {
+    public:
+        explicit Entry(Blocker& blocker, bool is_exclusive = true)
+            : m_blocker(blocker)
+            , m_is_exclusive(is_exclusive)
+        {
+        }
+
+        Blocker& blocker() { return m_blocker; }
+        [[nodiscard]] bool is_exclusive() const { return m_is_exclusive; }
+
+        ~Entry() override { ASSERT(!is_on_a_list()); }
+
+    private:
+        Blocker& m_blocker;
+        bool m_is_exclusive;
+    };
+
+    void add(Entry& entry)
+    {
+        m_entries.insert_back(entry);
+
+        if (!entry.is_exclusive())
+            ++m_non_exclusive_count;
+    }
+
+    // For waiters that got interrupted or gave up, wakers take the entry off on their own
+    void remove(Entry& entry)
+    {
+        if (entry.is_on_a_list())
+            take(entry);
+    }
+
+    // Every non-exclusive waiter plus up to count exclusive ones, returns the number of exclusive ones woken up
+    size_t wake_n(size_t count);
+    size_t wake_one() { return wake_n(1); }
+    void wake_all();
+
+    [[nodiscard]] bool empty() const { return m_entries.empty(); }
+
+private:
+    void take(Entry& entry)
+    {
+        entry.pop_off();
+
+        if (!entry.is_exclusive())
+            --m_non_exclusive_count;
+    }
+
+private:
+    List<Entry> m_entries;
+    size_t m_non_exclusive_count { 0 };
+};
+
+}
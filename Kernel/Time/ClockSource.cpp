@@ -0,0 +1,39 @@
+#include "Common/Logger.h"
+#include "Interrupts/Timer.h"
+
+#include "ClockSource.h"
+#include "HPET.h"
+#include "TSC.h"
+
+namespace kernel {
+
+ClockSource* ClockSource::s_primary;
+
+void ClockSource::discover_and_setup()
+{
+    auto* hpet = HPET::create();
+    ClockSource* source = hpet;
+
+    if (TSC::is_invariant())
+        source = TSC::create(hpet);
+    else
+        TSC::calibrate(hpet); // still needed for CPU time accounting
+
+    if (!source) {
+        warning() << "ClockSource: no invariant TSC or HPET, time is driven by timer ticks";
+        return;
+    }
+
+    source->make_primary();
+    log() << "ClockSource: using " << source->name() << " as the primary clock source";
+}
+
+void ClockSource::make_primary()
+{
+    // Continue from the tick based time so that it never goes backwards
+    m_base_nanoseconds = Timer::nanoseconds_since_boot();
+    m_base_ticks = read_ticks();
+
+    s_primary = this;
+}
+}
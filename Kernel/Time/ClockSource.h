@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Common/Macros.h"
+#include "Common/String.h"
+#include "Common/Types.h"
+
+#include "Time.h"
+
+namespace kernel {
+
+// A free running counter that can be read at any time from any processor.
+// Once one is set up Timer::nanoseconds_since_boot() reads it instead of counting timer ticks.
+class ClockSource {
+    MAKE_NONCOPYABLE(ClockSource);
+    MAKE_NONMOVABLE(ClockSource);
+
+public:
+    // Prefers invariant TSC, then HPET, otherwise time keeps being driven by timer ticks
+    static void discover_and_setup();
+
+    static ClockSource* primary() { return s_primary; }
+
+    virtual StringView name() const = 0;
+    virtual u64 read_ticks() const = 0;
+
+    [[nodiscard]] u64 ticks_per_second() const { return m_ticks_per_second; }
+
+    [[nodiscard]] u64 nanoseconds_since_boot() const
+    {
+        return m_base_nanoseconds + ticks_to_nanoseconds(read_ticks() - m_base_ticks);
+    }
+
+    virtual ~ClockSource() = default;
+
+protected:
+    ClockSource() = default;
+
+    void set_ticks_per_second(u64 ticks_per_second) { m_ticks_per_second = ticks_per_second; }
+
+private:
+    [[nodiscard]] u64 ticks_to_nanoseconds(u64 ticks) const
+    {
+        // Split to avoid overflowing the multiplication
+        auto seconds = ticks / m_ticks_per_second;
+        auto remainder = ticks % m_ticks_per_second;
+
+        return seconds * Time::nanoseconds_in_second + (remainder * Time::nanoseconds_in_second) / m_ticks_per_second;
+    }
+
+    void make_primary();
+
+private:
+    u64 m_ticks_per_second { 0 };
+    u64 m_base_ticks { 0 };
+    u64 m_base_nanoseconds { 0 };
+
+    static ClockSource* s_primary;
+};
+}
@@ -0,0 +1,97 @@
+#include "Common/Logger.h"
+#include "Memory/MemoryManager.h"
+#include "Memory/TypedMapping.h"
+
+#include "HPET.h"
+
+namespace kernel {
+
+HPET* HPET::create()
+{
+    auto* table_info = ACPI::the().get_table_info("HPET"_sv);
+
+    if (!table_info)
+        return nullptr;
+
+    auto table = TypedMapping<Table>::create("HPET"_sv, table_info->physical_address, table_info->length);
+
+    static constexpr u8 system_memory_address_space = 0;
+
+    if (table->base_address.address_space_id != system_memory_address_space) {
+        warning() << "HPET: registers are not memory mapped, ignored";
+        return nullptr;
+    }
+
+    Address physical_base = table->base_address.address;
+
+#ifdef ULTRA_32
+    auto region = MemoryManager::the().allocate_kernel_non_owning("HPET"_sv, Range(physical_base, Page::size));
+    region->make_eternal();
+    Address base = region->virtual_range().begin();
+#elif defined(ULTRA_64)
+    Address base = MemoryManager::physical_to_virtual(physical_base);
+#endif
+
+    auto* hpet = new HPET(base);
+
+    auto capabilities = hpet->read_register(Register::CAPABILITIES);
+
+    // A 32 bit counter wraps around in a few minutes, not worth the trouble
+    if (!(capabilities & counter_size_capability)) {
+        warning() << "HPET: main counter is only 32 bits wide, ignored";
+        delete hpet;
+        return nullptr;
+    }
+
+    auto period_in_femtoseconds = capabilities >> 32;
+    hpet->set_ticks_per_second(femtoseconds_in_second / period_in_femtoseconds);
+
+    hpet->write_register(Register::CONFIGURATION, hpet->read_register(Register::CONFIGURATION) | enable_bit);
+
+    log() << "HPET: main counter running at " << hpet->ticks_per_second() << " Hz";
+
+    return hpet;
+}
+
+HPET::HPET(Address base)
+    : m_base(base)
+{
+}
+
+u64 HPET::read_ticks() const
+{
+    return read_register(Register::MAIN_COUNTER);
+}
+
+u64 HPET::read_register(Register reg) const
+{
+    auto* address = Address(m_base + static_cast<size_t>(reg)).as_pointer<volatile u32>();
+
+#ifdef ULTRA_32
+    // Two 32 bit reads aren't atomic, retry if the lower half wrapped around in between
+    u32 upper;
+    u32 lower;
+
+    do {
+        upper = address[1];
+        lower = address[0];
+    } while (upper != address[1]);
+
+    return (static_cast<u64>(upper) << 32) | lower;
+#elif defined(ULTRA_64)
+    return *reinterpret_cast<volatile u64*>(address);
+#endif
+}
+
+void HPET::write_register(Register reg, u64 value)
+{
+    auto* address = Address(m_base + static_cast<size_t>(reg)).as_pointer<volatile u32>();
+
+#ifdef ULTRA_32
+    address[0] = value & 0xFFFFFFFF;
+    address[1] = value >> 32;
+#elif defined(ULTRA_64)
+    *reinterpret_cast<volatile u64*>(address) = value;
+#endif
+}
+}
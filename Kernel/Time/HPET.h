@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ACPI/ACPI.h"
+
+#include "ClockSource.h"
+
+namespace kernel {
+
+// Only the main counter is used, as a clock source.
+class HPET final : public ClockSource {
+public:
+    // Returns nullptr if there's no HPET or its main counter is only 32 bits wide
+    static HPET* create();
+
+    StringView name() const override { return "HPET"_sv; }
+    u64 read_ticks() const override;
+
+private:
+    explicit HPET(Address base);
+
+    enum class Register {
+        CAPABILITIES = 0x00,
+        CONFIGURATION = 0x10,
+        MAIN_COUNTER = 0xF0,
+    };
+
+    static constexpr u64 counter_size_capability = SET_BIT(13);
+    static constexpr u64 enable_bit = SET_BIT(0);
+    static constexpr u64 femtoseconds_in_second = 1000000000000000;
+
+    struct PACKED GenericAddress {
+        u8 address_space_id;
+        u8 register_bit_width;
+        u8 register_bit_offset;
+        u8 access_size;
+        u64 address;
+    };
+
+    struct PACKED Table {
+        ACPI::SDTHeader header;
+        u32 event_timer_block_id;
+        GenericAddress base_address;
+        u8 hpet_number;
+        u16 minimum_tick;
+        u8 page_protection;
+    };
+
+    u64 read_register(Register) const;
+    void write_register(Register, u64);
+
+private:
+    Address m_base;
+};
+}
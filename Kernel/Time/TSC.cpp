@@ -0,0 +1,81 @@
+#include "Core/CPU.h"
+#include "Interrupts/PIT.h"
+
+#include "TSC.h"
+
+namespace kernel {
+
+bool TSC::is_invariant()
+{
+    static constexpr u32 max_extended_function = 0x80000000;
+
+    if (CPU::ID(max_extended_function).a < advanced_power_management_function)
+        return false;
+
+    return CPU::ID(advanced_power_management_function).d & invariant_tsc_bit;
+}
+
+u64 TSC::s_calibrated_ticks_per_second;
+
+u64 TSC::calibrate(ClockSource* reference)
+{
+    static constexpr u64 calibration_delay_ns = calibration_delay_in_milliseconds * Time::nanoseconds_in_millisecond;
+
+    u64 tsc_ticks = 0;
+    u64 elapsed_ns = 0;
+
+    if (reference) {
+        auto reference_begin = reference->nanoseconds_since_boot();
+        auto tsc_begin = CPU::read_tsc();
+
+        while (reference->nanoseconds_since_boot() - reference_begin < calibration_delay_ns)
+            pause();
+
+        tsc_ticks = CPU::read_tsc() - tsc_begin;
+        elapsed_ns = reference->nanoseconds_since_boot() - reference_begin;
+    } else {
+        auto& pit = Timer::get_specific("PIT"_sv);
+
+        LOCK_GUARD(pit.lock());
+
+        auto tsc_begin = CPU::read_tsc();
+        pit.nano_delay(calibration_delay_ns);
+        tsc_ticks = CPU::read_tsc() - tsc_begin;
+
+        elapsed_ns = PIT::real_delay_ns(calibration_delay_ns);
+    }
+
+    s_calibrated_ticks_per_second = tsc_ticks * Time::nanoseconds_in_second / elapsed_ns;
+
+    log() << "TSC: calibrated to " << s_calibrated_ticks_per_second << " Hz against " << (reference ? reference->name() : "PIT"_sv);
+
+    return s_calibrated_ticks_per_second;
+}
+
+TSC* TSC::create(ClockSource* reference)
+{
+    auto* tsc = new TSC;
+    tsc->set_ticks_per_second(calibrate(reference));
+
+    return tsc;
+}
+
+u64 TSC::cycles_to_nanoseconds(u64 cycles)
+{
+    auto ticks_per_second = s_calibrated_ticks_per_second;
+
+    if (!ticks_per_second)
+        return 0;
+
+    // Split to avoid overflowing the multiplication
+    auto seconds = cycles / ticks_per_second;
+    auto remainder = cycles % ticks_per_second;
+
+    return seconds * Time::nanoseconds_in_second + (remainder * Time::nanoseconds_in_second) / ticks_per_second;
+}
+
+u64 TSC::read_ticks() const
+{
+    return CPU::read_tsc();
+}
+}
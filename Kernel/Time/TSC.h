@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ClockSource.h"
+
+namespace kernel {
+
+// Only usable as a clock source if it's invariant, meaning it ticks at a constant
+// rate regardless of P/C-states and is synchronized between all processors.
+class TSC final : public ClockSource {
+public:
+    static bool is_invariant();
+
+    // Calibrates against the reference if there's one, otherwise against the PIT
+    static TSC* create(ClockSource* reference);
+
+    // Measures the rate without setting up a clock source, the TSC is still good enough for
+    // timing short intervals on one processor (e.g. CPU time accounting) if it's not invariant.
+    static u64 calibrate(ClockSource* reference);
+
+    // Converts using the rate of the last calibration, returns 0 if there wasn't one
+    static u64 cycles_to_nanoseconds(u64 cycles);
+
+    StringView name() const override { return "TSC"_sv; }
+    u64 read_ticks() const override;
+
+private:
+    TSC() = default;
+
+    static constexpr u32 calibration_delay_in_milliseconds = 50;
+    static constexpr u32 invariant_tsc_bit = SET_BIT(8);
+    static constexpr u32 advanced_power_management_function = 0x80000007;
+
+    static u64 s_calibrated_ticks_per_second;
+};
+}
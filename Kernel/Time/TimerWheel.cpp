@@ -0,0 +1,181 @@
+#include "Core/CPU.h"
+
+#include "TimerWheel.h"
+
+namespace kernel {
+
+void Timeout::arm(u64 deadline_ns)
+{
+    CPU::current().timer_wheel().arm(*this, deadline_ns);
+}
+
+bool Timeout::cancel()
+{
+    auto* wheel = m_wheel;
+
+    if (!wheel)
+        return false;
+
+    return wheel->cancel(*this);
+}
+
+TimerWheel::TimerWheel()
+    : m_current_tick(Timer::nanoseconds_since_boot() / granularity_ns)
+{
+}
+
+void TimerWheel::arm(Timeout& timeout, u64 deadline_ns)
+{
+    LOCK_GUARD(m_lock);
+
+    ASSERT(!timeout.m_is_armed);
+
+    timeout.m_deadline = deadline_ns;
+
+    // Rounded up so that a timeout never fires early
+    timeout.m_expire_tick = (deadline_ns + granularity_ns - 1) / granularity_ns;
+    timeout.m_wheel = this;
+    timeout.m_is_armed = true;
+
+    enqueue(timeout);
+    m_pending_timeouts.fetch_add(1, MemoryOrder::RELAXED);
+
+    if (deadline_ns < m_next_deadline)
+        m_next_deadline = deadline_ns;
+}
+
+u64 TimerWheel::next_deadline()
+{
+    LOCK_GUARD(m_lock);
+    return m_next_deadline;
+}
+
+bool TimerWheel::cancel(Timeout& timeout)
+{
+    LOCK_GUARD(m_lock);
+
+    if (!timeout.m_is_armed)
+        return false;
+
+    timeout.pop_off();
+    timeout.m_is_armed = false;
+    m_pending_timeouts.fetch_subtract(1, MemoryOrder::RELAXED);
+
+    return true;
+}
+
+void TimerWheel::enqueue(Timeout& timeout)
+{
+    // Already expired, fire on the next tick
+    if (timeout.m_expire_tick <= m_current_tick) {
+        m_slots[0][m_current_tick & slot_mask].insert_back(timeout);
+        return;
+    }
+
+    auto ticks_ahead = timeout.m_expire_tick - m_current_tick;
+    auto expire_tick = timeout.m_expire_tick;
+
+    // Too far away even for the last level, park it as far as possible and re-enqueue once cascaded
+    if (ticks_ahead > max_ticks_ahead) {
+        ticks_ahead = max_ticks_ahead;
+        expire_tick = m_current_tick + max_ticks_ahead;
+    }
+
+    size_t level = 0;
+
+    while (level < level_count - 1 && ticks_ahead >= (1ull << (slot_bits * (level + 1))))
+        ++level;
+
+    auto slot = (expire_tick >> (slot_bits * level)) & slot_mask;
+    m_slots[level][slot].insert_back(timeout);
+}
+
+void TimerWheel::cascade(size_t level)
+{
+    auto& slot = m_slots[level][(m_current_tick >> (slot_bits * level)) & slot_mask];
+
+    while (!slot.empty())
+        enqueue(slot.pop_front());
+}
+
+void TimerWheel::find_next_deadline()
+{
+    m_next_deadline = no_deadline;
+
+    // Everything in the lowest level is due within slots_per_level ticks, each slot holds exactly one of them.
+    // Timeouts further away only get here once cascaded, which the owning processor's regular ticks take care of.
+    for (u64 tick = m_current_tick; tick < m_current_tick + slots_per_level; ++tick) {
+        auto& slot = m_slots[0][tick & slot_mask];
+
+        if (slot.empty())
+            continue;
+
+        for (auto& timeout : slot)
+            m_next_deadline = min(m_next_deadline, timeout.m_deadline);
+
+        return;
+    }
+}
+
+void TimerWheel::advance(u64 now_ns)
+{
+    List<Timeout> expired;
+    auto target_tick = now_ns / granularity_ns;
+
+    {
+        LOCK_GUARD(m_lock);
+
+        // Nothing to fire, no reason to walk every slot we skipped while idle
+        if (m_pending_timeouts.load(MemoryOrder::RELAXED) == 0) {
+            if (target_tick >= m_current_tick)
+                m_current_tick = target_tick + 1;
+
+            m_next_deadline = no_deadline;
+            return;
+        }
+
+        for (; m_current_tick <= target_tick; ++m_current_tick) {
+            // Every time a level wraps around the next slot of the level above is due
+            for (size_t level = 1; level < level_count; ++level) {
+                if ((m_current_tick >> (slot_bits * (level - 1))) & slot_mask)
+                    break;
+
+                cascade(level);
+            }
+
+            auto& slot = m_slots[0][m_current_tick & slot_mask];
+
+            while (!slot.empty()) {
+                auto& timeout = slot.pop_front();
+                timeout.m_is_armed = false;
+                m_pending_timeouts.fetch_subtract(1, MemoryOrder::RELAXED);
+                expired.insert_back(timeout);
+            }
+        }
+
+        // The tick we're in right now hasn't finished yet, but whatever is due by now doesn't have to wait for it to
+        auto& slot = m_slots[0][m_current_tick & slot_mask];
+
+        for (auto itr = slot.begin(); itr != slot.end();) {
+            auto& timeout = *itr++;
+
+            if (timeout.m_deadline > now_ns)
+                continue;
+
+            timeout.pop_off();
+            timeout.m_is_armed = false;
+            m_pending_timeouts.fetch_subtract(1, MemoryOrder::RELAXED);
+            expired.insert_back(timeout);
+        }
+
+        find_next_deadline();
+    }
+
+    // Callbacks are invoked without the lock held, so they're free to arm or cancel other timeouts.
+    // The timeout must not be touched after its callback returns as it might not exist anymore.
+    while (!expired.empty()) {
+        auto& timeout = expired.pop_front();
+        timeout.m_callback(timeout.m_context);
+    }
+}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Common/List.h"
+#include "Common/Lock.h"
+#include "Common/Macros.h"
+#include "Common/Types.h"
+
+#include "Interrupts/Timer.h"
+
+namespace kernel {
+
+class TimerWheel;
+
+// An intrusive timeout that can be armed on a TimerWheel without allocating.
+// The callback runs from the timer interrupt of the processor it was armed on,
+// so it must not block and has to be safe to call with interrupts disabled.
+class Timeout : public StandaloneListNode<Timeout> {
+    MAKE_NONCOPYABLE(Timeout);
+    MAKE_NONMOVABLE(Timeout);
+
+public:
+    using Callback = void (*)(void* context);
+
+    Timeout(Callback callback, void* context)
+        : m_callback(callback)
+        , m_context(context)
+    {
+    }
+
+    // Arms this timeout on the wheel of the current processor
+    void arm(u64 deadline_ns);
+
+    // Returns false if the timeout wasn't armed or has already fired (or is about to)
+    bool cancel();
+
+    [[nodiscard]] u64 deadline() const { return m_deadline; }
+
+private:
+    friend class TimerWheel;
+
+    Callback m_callback { nullptr };
+    void* m_context { nullptr };
+
+    u64 m_deadline { 0 };
+    u64 m_expire_tick { 0 };
+    TimerWheel* m_wheel { nullptr };
+    bool m_is_armed { false };
+};
+
+// Hierarchical timer wheel with tick granularity, arming and cancelling are O(1).
+// Timeouts that are too far away for the lower levels sit in the upper ones
+// and get cascaded down as the wheel turns. Every processor owns one.
+class TimerWheel {
+    MAKE_NONCOPYABLE(TimerWheel);
+    MAKE_NONMOVABLE(TimerWheel);
+
+public:
+    static constexpr u64 granularity_ns = Time::nanoseconds_in_second / Timer::default_ticks_per_second;
+
+    TimerWheel();
+
+    void arm(Timeout&, u64 deadline_ns);
+    bool cancel(Timeout&);
+
+    // Fires every timeout that expired by now, called from the timer interrupt of the owning processor.
+    // Timeouts due within the current tick fire as well if their deadline has passed.
+    void advance(u64 now_ns);
+
+    static constexpr u64 no_deadline = UINT64_MAX;
+
+    // Earliest deadline among the timeouts due within the next slots_per_level ticks, no_deadline if there are none.
+    // Might be earlier than that if the timeout was cancelled, the owning processor then just wakes up for nothing.
+    [[nodiscard]] u64 next_deadline();
+
+private:
+    void enqueue(Timeout&);
+    void cascade(size_t level);
+    void find_next_deadline();
+
+private:
+    static constexpr size_t level_count = 4;
+    static constexpr size_t slot_bits = 6;
+    static constexpr size_t slots_per_level = 1 << slot_bits;
+    static constexpr u64 slot_mask = slots_per_level - 1;
+    static constexpr u64 max_ticks_ahead = (1ull << (slot_bits * level_count)) - 1;
+
+    InterruptSafeSpinLock m_lock;
+    u64 m_current_tick { 0 };
+    u64 m_next_deadline { no_deadline };
+    Atomic<size_t> m_pending_timeouts { 0 };
+    List<Timeout> m_slots[level_count][slots_per_level];
+};
+}
@@ -1,12 +1,17 @@
 #include "DemoTTY.h"
 #include "ACPI/ACPI.h"
+#include "Benchmarks/Benchmark.h"
+#include "Core/LockProfiler.h"
+#include "Core/Profiler.h"
 #include "Drivers/AHCI/AHCI.h"
 #include "Drivers/PCI/PCI.h"
 #include "Drivers/Video/VideoDevice.h"
 #include "EventManager.h"
 #include "Memory/MemoryManager.h"
+#include "Memory/ObjectCache.h"
 #include "Multitasking/Process.h"
 #include "Multitasking/Scheduler.h"
+#include "Multitasking/TaskLoader.h"
 #include "WindowManager/WindowManager.h"
 
 namespace kernel {
@@ -18,7 +23,8 @@ void DemoTTY::initialize()
     ASSERT(s_instance == nullptr);
 
     s_instance = new DemoTTY();
-    Process::create_supervisor(&DemoTTY::run, "demo terminal"_sv, 4 * MB);
+    auto process = Process::create_supervisor(&DemoTTY::run, "demo terminal"_sv, 4 * MB);
+    process->set_priority_class(PriorityClass::INTERACTIVE);
 }
 
 DemoTTY::DemoTTY()
@@ -171,6 +177,15 @@ void DemoTTY::execute_command()
         auto diff = stats_struct.total_bytes - stats_struct.free_bytes;
         stats << "\nUsed MB: " << (diff) / MB << " (" << diff / Page::size << " pages)\n";
 
+        auto zeroed_allocations = stats_struct.zeroed_pool_hits + stats_struct.zeroed_pool_misses;
+        auto hit_rate = zeroed_allocations ? (100 * stats_struct.zeroed_pool_hits) / zeroed_allocations : 0;
+
+        stats << "Pre-zeroed pages: " << stats_struct.zeroed_bytes / Page::size << '\n';
+        stats << "Zeroed pool hits: " << stats_struct.zeroed_pool_hits << " / " << zeroed_allocations
+              << " (" << hit_rate << "%)\n";
+        stats << "Zeroing time (background): " << stats_struct.background_zeroing_ns / Time::nanoseconds_in_microsecond << " us\n";
+        stats << "Zeroing time (on allocation): " << stats_struct.synchronous_zeroing_ns / Time::nanoseconds_in_microsecond << " us\n";
+
         write(stats.to_view());
     } else if (m_current_command == "kheap"_sv) {
         String string;
@@ -189,6 +204,21 @@ void DemoTTY::execute_command()
         string << "Calls to allocate: " << stats.calls_to_allocate << '\n';
         string << "Calls to free: " << stats.calls_to_free << '\n';
 
+        write(string.to_view());
+    } else if (m_current_command == "slabs"_sv) {
+        String string;
+
+        string << "\nSlab caches:\n";
+
+        for (auto& cache : ObjectCache::stats()) {
+            auto hit_rate = cache.allocations ? (100 * cache.magazine_hits) / cache.allocations : 0;
+
+            string << cache.name << " (" << cache.object_size << " bytes, " << cache.objects_per_slab << " per slab) - "
+                   << cache.slabs << " slabs, " << cache.active_objects << " active, "
+                   << cache.magazine_objects << " in magazines, " << cache.allocations << " allocated, "
+                   << cache.frees << " freed, " << hit_rate << "% magazine hits\n";
+        }
+
         write(string.to_view());
     } else if (m_current_command == "e820"_sv) {
         auto loader_context = MemoryManager::loader_context();
@@ -254,6 +284,26 @@ void DemoTTY::execute_command()
         for (auto& cpu : stats.processor_to_task)
             info_string << "\ncpu " << cpu.first << ": " << cpu.second << "";
 
+        info_string << "\n\nRun queues:";
+        for (auto& queue : stats.run_queues) {
+            info_string << "\ncpu " << queue.processor_id << ": " << queue.ready_threads << " ready, "
+                        << queue.context_switches << " switches, " << queue.stolen_threads << " stolen, "
+                        << queue.ticks << " ticks, " << queue.idle_time / Time::nanoseconds_in_millisecond << " ms idle";
+        }
+
+        info_string << "\n\nThreads:";
+        for (auto& thread : stats.threads) {
+            auto& times = thread.times;
+
+            info_string << "\npid " << thread.process_id << " tid " << thread.thread_id << ": affinity "
+                        << format::as_hex << thread.affinity << format::as_dec << ", "
+                        << thread.migrations << " migrations, "
+                        << times.user_ns / Time::nanoseconds_in_millisecond << "/"
+                        << times.kernel_ns / Time::nanoseconds_in_millisecond << " ms user/kernel, "
+                        << times.max_wait_ns / Time::nanoseconds_in_microsecond << " us max wait, "
+                        << times.voluntary_switches << "/" << times.preemptions << " voluntary/preempted";
+        }
+
         write(info_string.to_view());
         write("\n");
 
@@ -303,11 +353,97 @@ void DemoTTY::execute_command()
 
         write(info_string.to_view());
         write("\n");
+    } else if (m_current_command == "bench"_sv) {
+        write("\nAvailable benchmarks:\n"_sv);
+
+        for (auto& benchmark : Benchmark::all()) {
+            String info_string;
+            info_string << benchmark.name << " - " << benchmark.description << "\n";
+            write(info_string.to_view());
+        }
+    } else if (m_current_command.starts_with("bench "_sv)) {
+        auto command = m_current_command.to_view();
+        StringView name(command.begin() + "bench "_sv.size(), command.end());
+
+        write("\nRunning benchmark...\n"_sv);
+
+        String report;
+        if (Benchmark::run(name, report))
+            write(report.to_view());
+        else
+            write("Unknown benchmark, type \"bench\" to list all\n"_sv);
+    } else if (m_current_command.starts_with("run "_sv)) {
+        auto command = m_current_command.to_view();
+        StringView path(command.begin() + "run "_sv.size(), command.end());
+
+        TaskLoader::LoadParameters params;
+        params.path = path;
+        params.argv.emplace(path);
+
+        // Only waits for the program to be loaded, not for it to exit
+        auto process = TaskLoader::load_from_file(params);
+
+        String result;
+        if (process.is_error())
+            result << "\nFailed to run " << path << ": " << process.error().to_string() << "\n";
+        else
+            result << "\nStarted " << path << " as PID " << process.value()->id() << "\n";
+
+        write(result.to_view());
+    } else if (m_current_command == "profile"_sv) {
+        write("\nProfile:\n"_sv);
+
+        String report;
+        Profiler::report(report);
+        write(report.to_view());
+    } else if (m_current_command.starts_with("profile start"_sv)) {
+        auto command = m_current_command.to_view();
+        u32 samples_per_second = 0;
+
+        for (auto* c = command.begin() + "profile start"_sv.size(); c != command.end(); ++c) {
+            if (*c >= '0' && *c <= '9')
+                samples_per_second = samples_per_second * 10 + (*c - '0');
+        }
+
+        Profiler::start(samples_per_second);
+        write("\nProfiler started\n"_sv);
+    } else if (m_current_command == "profile stop"_sv) {
+        Profiler::stop();
+        write("\nProfiler stopped\n"_sv);
+    } else if (m_current_command == "locks"_sv) {
+        write("\nLock contention (most waited on first):\n"_sv);
+
+        static constexpr size_t max_sites_shown = 15;
+        auto stats = LockProfiler::stats();
+
+        String info_string;
+        for (size_t i = 0; i < min(stats.size(), max_sites_shown); ++i) {
+            auto& site = stats[i];
+
+            info_string << site.file << ":" << site.line << " - " << site.acquisitions << " acquired, "
+                        << site.contentions << " contended, " << site.spins << " spins, "
+                        << site.wait_ns / Time::nanoseconds_in_microsecond << "/"
+                        << site.max_wait_ns / Time::nanoseconds_in_microsecond << " us wait total/max, "
+                        << site.hold_ns / Time::nanoseconds_in_microsecond << "/"
+                        << site.max_hold_ns / Time::nanoseconds_in_microsecond << " us held total/max\n";
+        }
+
+        if (LockProfiler::dropped_sites())
+            info_string << LockProfiler::dropped_sites() << " acquisitions of unregistered sites\n";
+
+        write(info_string.to_view());
+    } else if (m_current_command == "locks start"_sv) {
+        LockProfiler::enable();
+        write("\nLock profiler started\n"_sv);
+    } else if (m_current_command == "locks stop"_sv) {
+        LockProfiler::disable();
+        write("\nLock profiler stopped\n"_sv);
     } else if (m_current_command == "help"_sv) {
         write("\nWelcome to UltraOS demo terminal.\n"_sv);
         write("Here's a few things you can do:\n"_sv);
         write("uptime - get current uptime\n"_sv);
         write("kheap - get current kernel heap usage stats\n"_sv);
+        write("slabs - per-cache slab allocator stats\n"_sv);
         write("e820 - physical RAM memory map as reported by BIOS\n");
         write("memory-map - UltraOS memory map, sorted & formatted\n"_sv);
         write("kvm - dump kernel address space information\n"_sv);
@@ -320,6 +456,10 @@ void DemoTTY::execute_command()
         write("pci - dump all detected PCIe devices\n"_sv);
         write("devices - dump all system devices\n"_sv);
         write("ahci - dump AHCI state\n"_sv);
+        write("bench [name] - list or run kernel benchmarks\n"_sv);
+        write("run <path> - start a userland program, e.g. \"run /sysbench\" for the system call benchmark\n"_sv);
+        write("profile [start [hz] | stop] - sample where the CPUs spend their time, show the report\n"_sv);
+        write("locks [start | stop] - profile spin lock contention, show per-site stats\n"_sv);
         write("clear - clear the terminal screen\n"_sv);
     } else if (m_current_command == "kvm"_sv) {
         write("\nKernel address space virtual memory dump:\n");
@@ -19,7 +19,8 @@ void WindowManager::initialize()
     Screen::initialize(VideoDevice::primary());
     s_instance = new WindowManager();
     Compositor::initialize();
-    Process::create_supervisor(&WindowManager::run, "window manager"_sv, 4 * MB);
+    auto process = Process::create_supervisor(&WindowManager::run, "window manager"_sv, 4 * MB);
+    process->set_priority_class(PriorityClass::INTERACTIVE);
 }
 
 WindowManager::WindowManager()
@@ -196,6 +197,7 @@ void WindowManager::run()
     auto& self = the();
 
     static constexpr auto nanoseconds_between_frames = Time::nanoseconds_in_second / 60;
+    static constexpr auto sleep_granularity = Time::nanoseconds_in_second / Timer::default_ticks_per_second;
 
     auto next_frame_time = Timer::nanoseconds_since_boot() + nanoseconds_between_frames;
 
@@ -209,10 +211,22 @@ void WindowManager::run()
             Compositor::the().compose();
         }
 
+        // Sleeps are only as precise as the scheduler tick, so sleep
+        // through the coarse part and spin for the rest of the frame.
+        auto now = Timer::nanoseconds_since_boot();
+
+        if (now + sleep_granularity < next_frame_time)
+            sleep::until(next_frame_time - sleep_granularity);
+
         while (Timer::nanoseconds_since_boot() < next_frame_time)
-            continue;
+            pause();
+
+        // Advance by a whole frame to avoid accumulating drift, unless we fell too far behind
+        next_frame_time += nanoseconds_between_frames;
+        now = Timer::nanoseconds_since_boot();
 
-        next_frame_time = Timer::nanoseconds_since_boot() + nanoseconds_between_frames;
+        if (next_frame_time < now)
+            next_frame_time = now + nanoseconds_between_frames;
     }
 }
 }
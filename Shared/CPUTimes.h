@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Filled in by the GET_CPU_TIMES syscall, either for a single thread or summed over all threads
+// of a process (including the ones that have already exited).
+// User and kernel time are split at system call boundaries, interrupts count towards whatever they interrupted.
+typedef struct {
+    uint64_t user_ns;
+    uint64_t kernel_ns;
+
+    // Time spent runnable in a run queue before getting a processor
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+
+    uint64_t voluntary_switches; // blocked, yielded or exited
+    uint64_t preemptions;        // descheduled by a tick or a higher priority thread
+} CPUTimes;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef IO_RING_OPERATION_TYPE
+#define IO_RING_OPERATION_TYPE uint32_t
+#endif
+
+// Operation arguments -> completion result:
+// READ/WRITE: handle, buffer, length -> bytes transferred
+// OPEN: buffer = path, length = io mode -> handle
+// CLOSE: handle -> 0
+// SLEEP: length = nanoseconds since submission -> 0
+typedef struct {
+    IO_RING_OPERATION_TYPE operation;
+    uint32_t reserved;
+    uint64_t handle;
+    uint64_t buffer;
+    uint64_t length;
+    uint64_t user_data; // copied to the completion as is
+} IORingSubmission;
+
+typedef struct {
+    uint64_t user_data;
+    int64_t result; // negated error code on failure
+} IORingCompletion;
+
+// Placed at the beginning of the ring region, the entries follow at the given offsets.
+// Entry counts are powers of two, heads and tails are free running and wrap around.
+// Userland writes submission_tail and completion_head, the kernel writes the other two.
+typedef struct {
+    uint32_t submission_head;
+    uint32_t submission_tail;
+    uint32_t completion_head;
+    uint32_t completion_tail;
+
+    uint32_t submission_entry_count;
+    uint32_t completion_entry_count;
+    uint32_t submission_offset;
+    uint32_t completion_offset;
+} IORingHeader;
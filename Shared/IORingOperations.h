@@ -0,0 +1,9 @@
+#pragma once
+
+#define ENUMERATE_IO_RING_OPERATIONS \
+    IO_RING_OPERATION(NOP)           \
+    IO_RING_OPERATION(READ)          \
+    IO_RING_OPERATION(WRITE)         \
+    IO_RING_OPERATION(OPEN)          \
+    IO_RING_OPERATION(CLOSE)         \
+    IO_RING_OPERATION(SLEEP)
@@ -0,0 +1,13 @@
+#pragma once
+
+// Ordered from the highest to the lowest priority
+#define ENUMERATE_PRIORITY_CLASSES \
+    PRIORITY_CLASS(REALTIME)       \
+    PRIORITY_CLASS(INTERACTIVE)    \
+    PRIORITY_CLASS(NORMAL)         \
+    PRIORITY_CLASS(BACKGROUND)
+
+// Targets of the GET/SET_AFFINITY and GET_CPU_TIMES syscalls
+#define ENUMERATE_AFFINITY_SCOPES \
+    AFFINITY_SCOPE(THREAD)        \
+    AFFINITY_SCOPE(PROCESS)
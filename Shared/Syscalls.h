@@ -22,4 +22,13 @@
     SYSCALL(SLEEP)          \
     SYSCALL(TICKS)          \
     SYSCALL(DEBUG_LOG)      \
+    SYSCALL(SET_PRIORITY)   \
+    SYSCALL(GET_AFFINITY)   \
+    SYSCALL(SET_AFFINITY)   \
+    SYSCALL(GET_CPU_TIMES)  \
+    SYSCALL(TRACE_CONTROL)  \
+    SYSCALL(IO_RING_SETUP)  \
+    SYSCALL(IO_RING_ENTER)  \
+    SYSCALL(FUTEX_WAIT)     \
+    SYSCALL(FUTEX_WAKE)     \
     SYSCALL(MAX)
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+// Arguments of every event:
+// SWITCH: previous thread, next thread
+// WAKE_UP: woken up thread, blocker type
+// BLOCK: blocker type, -
+// IRQ_ENTER/IRQ_EXIT: vector, -. The timer's IRQ_EXIT comes right before the reschedule it ends with.
+//                     IPIs don't go through IRQManager and aren't recorded.
+// PAGE_FAULT: faulting address, error code
+// SYSCALL_ENTER: syscall number, first argument
+// SYSCALL_EXIT: syscall number, return value
+// Threads are encoded as (process id << 32) | thread id.
+#define ENUMERATE_TRACE_EVENT_TYPES    \
+    TRACE_EVENT_TYPE(SWITCH)           \
+    TRACE_EVENT_TYPE(WAKE_UP)          \
+    TRACE_EVENT_TYPE(BLOCK)            \
+    TRACE_EVENT_TYPE(IRQ_ENTER)        \
+    TRACE_EVENT_TYPE(IRQ_EXIT)         \
+    TRACE_EVENT_TYPE(PAGE_FAULT)       \
+    TRACE_EVENT_TYPE(SYSCALL_ENTER)    \
+    TRACE_EVENT_TYPE(SYSCALL_EXIT)
+
+// Commands of the TRACE_CONTROL syscall:
+// ENABLE/DISABLE: starts or stops recording, events recorded so far are kept
+// READ: buffer, max event count -> number of events copied, every event is only ever read once.
+//       Events are ordered by time within a processor, but processors are read one after another.
+#define ENUMERATE_TRACE_COMMANDS \
+    TRACE_COMMAND(ENABLE)        \
+    TRACE_COMMAND(DISABLE)       \
+    TRACE_COMMAND(READ)
+
+typedef struct {
+    uint64_t timestamp_ns; // TSC based, recorded as cycles and converted when read
+    uint64_t thread;       // the one running when the event was recorded, encoded same as arguments
+    uint64_t arg0;
+    uint64_t arg1;
+    uint16_t type;
+    uint16_t processor; // index, not the LAPIC id
+    uint32_t reserved;
+} TraceEvent;
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace kernel {
+
+class ObjectMagazines;
+
+// Tests run on a single fake processor, which only gets per-processor data when a test asks for it
+class CPU
+{
+public:
+    class LocalData
+    {
+    public:
+        ObjectMagazines* object_magazines() const { return m_object_magazines; }
+        void set_object_magazines(ObjectMagazines* magazines) { m_object_magazines = magazines; }
+
+    private:
+        ObjectMagazines* m_object_magazines { nullptr };
+    };
+
+    static bool is_initialized() { return s_is_initialized; }
+    static void set_initialized(bool initialized) { s_is_initialized = initialized; }
+
+    static LocalData& current() { return s_processors[0]; }
+
+    using Processors = LocalData[1];
+    static Processors& processors() { return s_processors; }
+
+private:
+    inline static bool s_is_initialized;
+    static Processors s_processors;
+};
+
+inline CPU::Processors CPU::s_processors;
+
+}
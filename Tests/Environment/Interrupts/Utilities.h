@@ -0,0 +1,11 @@
+#pragma once
+
+namespace kernel::Interrupts {
+
+class ScopedDisabler
+{
+public:
+    ScopedDisabler() { }
+};
+
+}
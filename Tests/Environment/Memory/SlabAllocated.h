@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace kernel {
+
+static constexpr size_t max_slab_object_size = 1024;
+
+}
+
+// Objects come straight from the host allocator in tests
+#define MAKE_SLAB_ALLOCATED(class_name)
@@ -0,0 +1,212 @@
+#include "TestRunner.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define private public
+#include "Memory/BuddyAllocator.h"
+#include "Memory/BuddyAllocator.cpp"
+#undef private
+
+static constexpr kernel::ptr_t buddy_test_base = 0x100000;
+
+TEST(BuddyFreeMapFindsLowestBit) {
+    using namespace kernel;
+
+    // 3 levels of words
+    BuddyAllocator::FreeMap map(100000);
+    Assert::that(map.find_first().has_value()).is_false();
+
+    map.set(70000);
+    map.set(99999);
+    Assert::that(map.find_first().value()).is_equal(70000);
+    Assert::that(map.test(70000)).is_true();
+    Assert::that(map.test(70001)).is_false();
+
+    map.clear(70000);
+    Assert::that(map.find_first().value()).is_equal(99999);
+
+    map.clear(99999);
+    Assert::that(map.find_first().has_value()).is_false();
+}
+
+TEST(BuddyCarvesUnalignedRange) {
+    using namespace kernel;
+
+    // Starts at frame 256, so the first blocks are smaller than the maximum order
+    BuddyAllocator allocator(buddy_test_base, 2048);
+    Assert::that(allocator.free_page_count()).is_equal(2048);
+
+    auto block = allocator.allocate(BuddyAllocator::max_order);
+    Assert::that(block.has_value()).is_true();
+    Assert::that(block->raw() % (Page::size << BuddyAllocator::max_order)).is_equal(0);
+    Assert::that(allocator.free_page_count()).is_equal(1024);
+
+    // The only other block of that size would go past the end
+    Assert::that(allocator.allocate(BuddyAllocator::max_order).has_value()).is_false();
+
+    allocator.free(*block, BuddyAllocator::max_order);
+    Assert::that(allocator.free_page_count()).is_equal(2048);
+}
+
+TEST(BuddyAllocatesEveryPageOnce) {
+    using namespace kernel;
+
+    static constexpr size_t page_count = 1000;
+    BuddyAllocator allocator(buddy_test_base, page_count);
+
+    std::vector<ptr_t> pages;
+
+    for (size_t i = 0; i < page_count; ++i) {
+        auto page = allocator.allocate(0);
+        Assert::that(page.has_value()).is_true();
+        Assert::that(page->raw()).is_greater_than_or_equal(buddy_test_base);
+        Assert::that(page->raw()).is_less_than(buddy_test_base + page_count * Page::size);
+        Assert::that(allocator.is_free(*page)).is_false();
+
+        pages.push_back(page->raw());
+    }
+
+    Assert::that(allocator.free_page_count()).is_equal(0);
+    Assert::that(allocator.allocate(0).has_value()).is_false();
+
+    std::sort(pages.begin(), pages.end());
+    Assert::that(std::adjacent_find(pages.begin(), pages.end()) == pages.end()).is_true();
+
+    for (auto page : pages) {
+        allocator.free(page);
+        Assert::that(allocator.is_free(page)).is_true();
+    }
+
+    Assert::that(allocator.free_page_count()).is_equal(page_count);
+}
+
+TEST(BuddyCoalescesOnFree) {
+    using namespace kernel;
+
+    BuddyAllocator allocator(static_cast<ptr_t>(0), 1 << BuddyAllocator::max_order);
+
+    auto first = allocator.allocate(0);
+    auto second = allocator.allocate(0);
+
+    Assert::that(first->raw()).is_equal(0);
+    Assert::that(second->raw()).is_equal(Page::size);
+
+    // Split all the way down, nothing of the maximum order is left
+    Assert::that(allocator.allocate(BuddyAllocator::max_order).has_value()).is_false();
+
+    allocator.free(*second);
+    allocator.free(*first);
+
+    Assert::that(allocator.allocate(BuddyAllocator::max_order).has_value()).is_true();
+}
+
+TEST(BuddyAlignedContiguousAllocations) {
+    using namespace kernel;
+
+    BuddyAllocator allocator(buddy_test_base, 4096);
+
+    // Take the first page so that the aligned run can't just start at the base
+    auto head = allocator.allocate(0);
+    Assert::that(head.has_value()).is_true();
+
+    static constexpr size_t alignment = 16 * Page::size;
+
+    auto run = allocator.allocate_contiguous(3, alignment);
+    Assert::that(run.has_value()).is_true();
+    Assert::that(run->raw() % alignment).is_equal(0);
+    Assert::that(allocator.free_page_count()).is_equal(4096 - 4);
+
+    for (size_t i = 0; i < 3; ++i)
+        Assert::that(allocator.is_free(*run + i * Page::size)).is_false();
+
+    // The rest of the block it came from was given back
+    Assert::that(allocator.is_free(*run + 3 * Page::size)).is_true();
+    Assert::that(allocator.is_free(*run + 15 * Page::size)).is_true();
+
+    for (size_t i = 0; i < 3; ++i)
+        allocator.free(*run + i * Page::size);
+
+    allocator.free(*head);
+    Assert::that(allocator.free_page_count()).is_equal(4096);
+
+    // Everything coalesced back into the biggest blocks
+    Assert::that(allocator.allocate_contiguous(1 << BuddyAllocator::max_order).has_value()).is_true();
+    Assert::that(allocator.allocate_contiguous((1 << BuddyAllocator::max_order) + 1).has_value()).is_false();
+}
+
+TEST(BuddyRespectsCeiling) {
+    using namespace kernel;
+
+    // Frames 256 to 1280, the single page at the very end is the only free order 0 block
+    BuddyAllocator allocator(buddy_test_base, 1025);
+    auto ceiling = static_cast<u64>(buddy_test_base + 256 * Page::size - 1);
+
+    // The smallest block that fits is above the ceiling, a bigger one below has to be split instead
+    auto page = allocator.allocate_contiguous(1, Page::size, ceiling);
+    Assert::that(page.has_value()).is_true();
+    Assert::that(page->raw()).is_equal(buddy_test_base);
+    Assert::that(allocator.is_free(buddy_test_base + 1024 * Page::size)).is_true();
+
+    // Only the pages that are kept have to fit, the rest of the block is given back
+    auto run = allocator.allocate_contiguous(3, 4 * Page::size, ceiling);
+    Assert::that(run.has_value()).is_true();
+    Assert::that(run->raw() + 3 * Page::size - 1 <= ceiling).is_true();
+
+    // Nothing this big is left below the ceiling
+    Assert::that(allocator.allocate(BuddyAllocator::max_order - 2, ceiling).has_value()).is_false();
+    Assert::that(allocator.allocate(BuddyAllocator::max_order - 2).has_value()).is_true();
+
+    // A ceiling below the range
+    Assert::that(allocator.allocate_contiguous(1, Page::size, buddy_test_base - 1).has_value()).is_false();
+}
+
+TEST(BuddyRandomizedAgainstReference) {
+    using namespace kernel;
+
+    static constexpr size_t page_count = 3000;
+    BuddyAllocator allocator(buddy_test_base + 5 * Page::size, page_count);
+
+    std::mt19937 random(1234);
+    std::vector<std::pair<ptr_t, size_t>> blocks;
+    std::vector<bool> used(page_count, false);
+    size_t used_pages = 0;
+
+    auto frame_of = [](ptr_t address) { return (address - buddy_test_base) / Page::size - 5; };
+
+    for (size_t i = 0; i < 20000; ++i) {
+        if (blocks.empty() || random() % 3) {
+            size_t order = random() % 5;
+            auto block = allocator.allocate(order);
+
+            if (!block)
+                continue;
+
+            Assert::that(block->raw() % (Page::size << order)).is_equal(0);
+
+            for (size_t j = 0; j < (1ull << order); ++j) {
+                auto frame = frame_of(block->raw()) + j;
+                Assert::that(frame).is_less_than(page_count);
+                Assert::that(static_cast<bool>(used[frame])).is_false();
+                used[frame] = true;
+            }
+
+            used_pages += 1ull << order;
+            blocks.emplace_back(block->raw(), order);
+        } else {
+            auto index = random() % blocks.size();
+            auto block = blocks[index];
+            blocks.erase(blocks.begin() + index);
+
+            allocator.free(block.first, block.second);
+
+            for (size_t j = 0; j < (1ull << block.second); ++j)
+                used[frame_of(block.first) + j] = false;
+
+            used_pages -= 1ull << block.second;
+        }
+
+        Assert::that(allocator.free_page_count()).is_equal(page_count - used_pages);
+    }
+}
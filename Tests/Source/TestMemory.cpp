@@ -0,0 +1,121 @@
+#include "TestRunner.h"
+
+#include <cstring>
+#include <vector>
+
+#include "Common/Memory.h"
+
+// Every strategy copy_memory & co. can pick at boot
+static const kernel::MemoryFeatures memory_feature_sets[] = {
+    { false, false },
+    { true, false },
+    { true, true },
+};
+
+static const size_t memory_test_sizes[] = { 0, 1, 7, 8, 9, 31, 32, 33, 255, 256, 257, 1000, 4096, 4099 };
+
+static std::vector<kernel::u8> memory_test_pattern(size_t size, kernel::u8 seed)
+{
+    std::vector<kernel::u8> bytes(size);
+
+    for (size_t i = 0; i < size; ++i)
+        bytes[i] = static_cast<kernel::u8>(i * 31 + seed);
+
+    return bytes;
+}
+
+TEST(CopyMemoryAllSizesAndAlignments) {
+    using namespace kernel;
+
+    for (auto features : memory_feature_sets) {
+        g_memory_features = features;
+
+        for (auto size : memory_test_sizes) {
+            for (size_t offset = 0; offset < 8; ++offset) {
+                auto source = memory_test_pattern(size + 16, 1);
+                std::vector<u8> destination(size + 16, 0xCC);
+
+                copy_memory(source.data() + offset, destination.data() + 3, size);
+
+                Assert::that(std::memcmp(source.data() + offset, destination.data() + 3, size)).is_equal(0);
+
+                // Nothing around the destination was touched
+                for (size_t i = 0; i < 3; ++i)
+                    Assert::that(destination[i]).is_equal(0xCC);
+                for (size_t i = size + 3; i < destination.size(); ++i)
+                    Assert::that(destination[i]).is_equal(0xCC);
+            }
+        }
+    }
+
+    g_memory_features = {};
+}
+
+TEST(SetMemoryAllSizes) {
+    using namespace kernel;
+
+    for (auto features : memory_feature_sets) {
+        g_memory_features = features;
+
+        for (auto size : memory_test_sizes) {
+            std::vector<u8> buffer(size + 2, 0xCC);
+            set_memory(buffer.data() + 1, size, 0x5A);
+
+            Assert::that(buffer.front()).is_equal(0xCC);
+            Assert::that(buffer.back()).is_equal(0xCC);
+
+            for (size_t i = 1; i <= size; ++i)
+                Assert::that(buffer[i]).is_equal(0x5A);
+
+            zero_memory(buffer.data() + 1, size);
+
+            for (size_t i = 1; i <= size; ++i)
+                Assert::that(buffer[i]).is_equal(0);
+        }
+    }
+
+    g_memory_features = {};
+}
+
+TEST(MoveMemoryOverlapping) {
+    using namespace kernel;
+
+    for (auto features : memory_feature_sets) {
+        g_memory_features = features;
+
+        for (auto size : memory_test_sizes) {
+            for (size_t distance : { 1, 3, 8, 13, 300 }) {
+                auto original = memory_test_pattern(size + distance, 7);
+
+                // Destination above the source
+                auto up = original;
+                move_memory(up.data(), up.data() + distance, size);
+                Assert::that(std::memcmp(original.data(), up.data() + distance, size)).is_equal(0);
+
+                // And below
+                auto down = original;
+                move_memory(down.data() + distance, down.data(), size);
+                Assert::that(std::memcmp(original.data() + distance, down.data(), size)).is_equal(0);
+            }
+        }
+    }
+
+    g_memory_features = {};
+}
+
+TEST(CompareMemoryFindsEveryDifference) {
+    using namespace kernel;
+
+    for (auto size : memory_test_sizes) {
+        auto lhs = memory_test_pattern(size, 3);
+        auto rhs = lhs;
+
+        Assert::that(compare_memory(lhs.data(), rhs.data(), size)).is_true();
+
+        for (size_t i = 0; i < size; ++i) {
+            rhs[i] ^= 0x10;
+            Assert::that(compare_memory(lhs.data(), rhs.data(), size)).is_false();
+            rhs[i] ^= 0x10;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "TestRunner.h"
+
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+#include "Common/Memory.h"
+
+// Not really tests, these print the throughput of every copy_memory/set_memory strategy.
+// Run with "RunTests MemoryThroughput", preferably from a release build.
+
+static constexpr size_t throughput_bytes_per_run = 16 * 1024 * 1024;
+static const size_t throughput_sizes[] = { 64, 512, 4096, 1024 * 1024 };
+
+struct ThroughputStrategy {
+    const char* name;
+    kernel::MemoryFeatures features;
+};
+
+static const ThroughputStrategy throughput_strategies[] = {
+    { "words", { false, false } },
+    { "erms", { true, false } },
+    { "erms+fsrm", { true, true } },
+};
+
+// What the kernel used before, for reference
+static void byte_loop_copy(const void* source, void* destination, size_t size)
+{
+    auto* byte_src = reinterpret_cast<const volatile kernel::u8*>(source);
+    auto* byte_dst = reinterpret_cast<volatile kernel::u8*>(destination);
+
+    while (size--)
+        *byte_dst++ = *byte_src++;
+}
+
+template <typename Callback>
+static double megabytes_per_second(size_t size, Callback callback)
+{
+    auto iterations = throughput_bytes_per_run / size;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; ++i)
+        callback();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return (iterations * size) / elapsed.count() / (1024 * 1024);
+}
+
+static void print_throughput(const char* operation, const char* strategy, size_t size, double mbps)
+{
+    std::cout << "\n    " << std::setw(8) << operation << std::setw(12) << strategy
+              << std::setw(10) << size << " bytes: " << std::fixed << std::setprecision(0) << mbps << " MB/s";
+}
+
+TEST(CopyThroughput) {
+    using namespace kernel;
+
+    for (auto size : throughput_sizes) {
+        std::vector<u8> source(size, 0xAB);
+        std::vector<u8> destination(size);
+
+        print_throughput("copy", "bytes", size,
+            megabytes_per_second(size, [&] { byte_loop_copy(source.data(), destination.data(), size); }));
+
+        for (auto& strategy : throughput_strategies) {
+            g_memory_features = strategy.features;
+
+            print_throughput("copy", strategy.name, size,
+                megabytes_per_second(size, [&] { copy_memory(source.data(), destination.data(), size); }));
+        }
+    }
+
+    g_memory_features = {};
+    std::cout << "\n    ";
+}
+
+TEST(SetThroughput) {
+    using namespace kernel;
+
+    for (auto size : throughput_sizes) {
+        std::vector<u8> buffer(size);
+
+        for (auto& strategy : throughput_strategies) {
+            g_memory_features = strategy.features;
+
+            print_throughput("set", strategy.name, size,
+                megabytes_per_second(size, [&] { set_memory(buffer.data(), size, 0); }));
+        }
+    }
+
+    g_memory_features = {};
+    std::cout << "\n    ";
+}
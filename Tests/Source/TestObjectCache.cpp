@@ -0,0 +1,234 @@
+#include "TestRunner.h"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#define private public
+#include "Memory/ObjectCache.h"
+#include "Memory/ObjectCache.cpp"
+#undef private
+
+FIXTURE(InitializeObjectCache) {
+    using namespace kernel;
+
+    // Slabs come from the kernel heap, which is only fed by the heap tests
+    if (!HeapAllocator::is_initialized()) {
+        static constexpr size_t test_size = 1024 * 1024;
+        HeapAllocator::feed_block(malloc(test_size), test_size);
+    }
+
+    ObjectCache::initialize();
+}
+
+static kernel::ObjectCache::Stats stats_of(const kernel::ObjectCache& cache)
+{
+    for (auto& stats : kernel::ObjectCache::stats()) {
+        if (stats.name == cache.m_name)
+            return stats;
+    }
+
+    throw FailedAssertion("no stats for cache", __FILE__, __LINE__);
+}
+
+TEST(ObjectCacheCarvesSlabs) {
+    using namespace kernel;
+
+    auto& cache = ObjectCache::find_or_create("carving", 40, 64);
+    Assert::that(cache.object_size()).is_equal(64);
+    Assert::that(&ObjectCache::find_or_create("carving", 40, 64)).is_equal(&cache);
+
+    auto per_slab = cache.m_objects_per_slab;
+    Assert::that(cache.m_objects_offset % 64).is_equal(0);
+    Assert::that(cache.m_objects_offset >= sizeof(ObjectCache::Slab) + per_slab).is_true();
+    Assert::that(cache.m_objects_offset + per_slab * 64 <= ObjectCache::slab_size).is_true();
+    Assert::that(cache.m_objects_offset + (per_slab + 1) * 64 > ObjectCache::slab_size).is_true();
+
+    std::vector<void*> objects;
+    std::set<void*> unique_objects;
+
+    for (size_t i = 0; i < per_slab; ++i) {
+        auto* object = cache.allocate();
+        Assert::that(reinterpret_cast<ptr_t>(object) % 64).is_equal(0);
+        Assert::that(cache.slab_of(object)).is_equal(cache.slab_of(objects.empty() ? object : objects.front()));
+
+        objects.push_back(object);
+        unique_objects.insert(object);
+    }
+
+    Assert::that(unique_objects.size()).is_equal(per_slab);
+    Assert::that(cache.m_slab_count).is_equal(1);
+    Assert::that(cache.m_first_slab).is_null();
+
+    auto* extra = cache.allocate();
+    Assert::that(cache.slab_of(extra)).is_not_equal(cache.slab_of(objects.front()));
+    Assert::that(cache.m_slab_count).is_equal(2);
+
+    objects.push_back(extra);
+
+    for (auto* object : objects)
+        cache.free(object);
+
+    Assert::that(cache.m_used_objects).is_equal(0);
+}
+
+TEST(ObjectCacheReusesFreedObjects) {
+    using namespace kernel;
+
+    auto& cache = ObjectCache::find_or_create("reuse", 32, 16);
+
+    auto* first = cache.allocate();
+    auto* second = cache.allocate();
+    auto* third = cache.allocate();
+
+    cache.free(second);
+    cache.free(first);
+
+    // Most recently freed first, a partially used slab is always taken from before a new one is made
+    Assert::that(cache.allocate()).is_equal(first);
+    Assert::that(cache.allocate()).is_equal(second);
+    Assert::that(cache.m_slab_count).is_equal(1);
+
+    cache.free(first);
+    cache.free(second);
+    cache.free(third);
+
+    Assert::that(cache.m_used_objects).is_equal(0);
+    Assert::that(cache.m_slab_count).is_equal(1);
+}
+
+TEST(ObjectCacheRefillsAndFlushesMagazines) {
+    using namespace kernel;
+
+    using Magazine = ObjectCache::Magazine;
+
+    auto& cache = ObjectCache::find_or_create("magazines", 128, 16);
+
+    std::vector<void*> objects;
+
+    for (size_t i = 0; i < Magazine::capacity + 1; ++i)
+        objects.push_back(cache.allocate());
+
+    auto* magazines = new ObjectMagazines;
+    CPU::current().set_object_magazines(magazines);
+    CPU::set_initialized(true);
+
+    auto& magazine = magazines->of(cache);
+
+    for (size_t i = 0; i < Magazine::capacity; ++i)
+        cache.free(objects[i]);
+
+    Assert::that(magazine.is_full()).is_true();
+    Assert::that(cache.m_used_objects).is_equal(Magazine::capacity + 1);
+
+    // The oldest half goes back to the slabs
+    cache.free(objects.back());
+    Assert::that(magazine.size()).is_equal(Magazine::capacity - Magazine::batch_size + 1);
+    Assert::that(magazine.m_objects[0]).is_equal(objects[Magazine::batch_size]);
+    Assert::that(magazine.m_objects[magazine.size() - 1]).is_equal(objects.back());
+    Assert::that(cache.m_used_objects).is_equal(Magazine::capacity + 1 - Magazine::batch_size);
+
+    Assert::that(cache.allocate()).is_equal(objects.back());
+
+    while (!magazine.is_empty())
+        cache.allocate();
+
+    auto used_before_refill = cache.m_used_objects;
+
+    // An empty magazine takes a whole batch from the slabs
+    cache.allocate();
+    Assert::that(magazine.size()).is_equal(Magazine::batch_size - 1);
+    Assert::that(cache.m_used_objects).is_equal(used_before_refill + Magazine::batch_size);
+
+    auto stats = stats_of(cache);
+    Assert::that(stats.magazine_objects).is_equal(Magazine::batch_size - 1);
+    Assert::that(stats.frees).is_equal(Magazine::capacity + 1);
+    Assert::that(stats.magazine_hits).is_equal(Magazine::capacity - Magazine::batch_size + 1);
+    Assert::that(stats.allocations).is_equal(Magazine::capacity + 1 + stats.magazine_hits + 1);
+
+    CPU::set_initialized(false);
+    CPU::current().set_object_magazines(nullptr);
+    delete magazines;
+}
+
+TEST(ObjectCacheDestroysEmptySlabs) {
+    using namespace kernel;
+
+    auto& cache = ObjectCache::find_or_create("empty slabs", 256, 16);
+    auto per_slab = cache.m_objects_per_slab;
+
+    std::vector<void*> objects;
+
+    for (size_t i = 0; i < per_slab * 3; ++i)
+        objects.push_back(cache.allocate());
+
+    Assert::that(cache.m_slab_count).is_equal(3);
+
+    auto free_bytes_before = HeapAllocator::total_free_bytes().load(MemoryOrder::RELAXED);
+
+    for (auto* object : objects)
+        cache.free(object);
+
+    Assert::that(cache.m_used_objects).is_equal(0);
+    Assert::that(cache.m_slab_count).is_equal(ObjectCache::max_empty_slabs);
+    Assert::that(cache.m_empty_slabs).is_equal(ObjectCache::max_empty_slabs);
+    Assert::that(cache.m_first_slab).is_equal(cache.m_last_slab);
+    Assert::that(HeapAllocator::total_free_bytes().load(MemoryOrder::RELAXED) - free_bytes_before)
+        .is_equal((3 - ObjectCache::max_empty_slabs) * ObjectCache::slab_size);
+
+    // The kept slab is reused before a new one is made
+    auto* object = cache.allocate();
+    Assert::that(cache.slab_of(object)).is_equal(cache.m_first_slab);
+    Assert::that(cache.m_slab_count).is_equal(ObjectCache::max_empty_slabs);
+
+    cache.free(object);
+}
+
+static size_t constructed_objects;
+static size_t destructed_objects;
+
+static constexpr kernel::u32 constructed_pattern = 0xC0DEC0DE;
+
+TEST(ObjectCacheKeepsObjectsConstructed) {
+    using namespace kernel;
+
+    auto& cache = ObjectCache::find_or_create(
+        "constructed", sizeof(u32), alignof(u32),
+        [](void* object) {
+            *reinterpret_cast<u32*>(object) = constructed_pattern;
+            ++constructed_objects;
+        },
+        [](void* object) {
+            Assert::that(*reinterpret_cast<u32*>(object)).is_equal(constructed_pattern);
+            ++destructed_objects;
+        });
+
+    auto per_slab = cache.m_objects_per_slab;
+
+    // Constructed once per slab, not per allocation
+    std::vector<void*> objects;
+
+    for (size_t i = 0; i < per_slab; ++i) {
+        objects.push_back(cache.allocate());
+        Assert::that(*reinterpret_cast<u32*>(objects.back())).is_equal(constructed_pattern);
+    }
+
+    Assert::that(constructed_objects).is_equal(per_slab);
+
+    cache.free(objects.back());
+    objects.pop_back();
+
+    objects.push_back(cache.allocate());
+    Assert::that(*reinterpret_cast<u32*>(objects.back())).is_equal(constructed_pattern);
+    Assert::that(constructed_objects).is_equal(per_slab);
+
+    objects.push_back(cache.allocate());
+    Assert::that(constructed_objects).is_equal(per_slab * 2);
+
+    for (auto* object : objects)
+        cache.free(object);
+
+    // Only the slab that doesn't fit the empty slab limit is destructed
+    Assert::that(destructed_objects).is_equal(per_slab);
+    Assert::that(cache.m_slab_count).is_equal(ObjectCache::max_empty_slabs);
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+
+#include <Ultra/Syscall.h>
+#include <Ultra/Ultra.h>
+
+// Null system call round trip from userland, int 0x80 vs the LibC fast stub (SYSCALL/SYSENTER).
+// SYSCALL_MAX is rejected by the kernel right away, so this only measures getting in and out.
+
+#define ITERATIONS 1000000
+
+static long int80_null_syscall(void)
+{
+    long result;
+    asm volatile("int $0x80"
+                 : "=a"(result)
+                 : "a"((long)SYSCALL_MAX)
+                 : "memory");
+    return result;
+}
+
+static unsigned long run_pass(int via_interrupt)
+{
+    unsigned long start = ticks_since_boot();
+
+    for (long i = 0; i < ITERATIONS; ++i) {
+        if (via_interrupt)
+            int80_null_syscall();
+        else
+            syscall_0(SYSCALL_MAX);
+    }
+
+    // Milliseconds for the whole pass, so nanoseconds per call times a million
+    return ((ticks_since_boot() - start) * 1000000) / ITERATIONS;
+}
+
+int main(int argc, char** argv, char** envp)
+{
+    (void)argc;
+    (void)argv;
+    (void)envp;
+
+    // Warm up the caches and the TLB first
+    run_pass(1);
+    run_pass(0);
+
+    unsigned long via_interrupt = run_pass(1);
+    unsigned long fast = run_pass(0);
+
+    char report[128];
+    snprintf(report, sizeof(report), "%d null system calls per pass, int 0x80: %lu ns per call, fast entry: %lu ns per call",
+             ITERATIONS, via_interrupt, fast);
+    debug_log(report);
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include "Syscall.h"
+#include "Futex.h"
+
+long futex_wait(uint32_t* address, uint32_t expected, unsigned long timeout_ns)
+{
+    return syscall_3(SYSCALL_FUTEX_WAIT, (long)address, (long)expected, (long)timeout_ns);
+}
+
+long futex_wake(uint32_t* address, unsigned long count)
+{
+    return syscall_2(SYSCALL_FUTEX_WAKE, (long)address, (long)count);
+}
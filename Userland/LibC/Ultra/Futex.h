@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// Blocks while *address == expected, timeout_ns of 0 waits forever.
+// Returns 0 once woken up, -ERROR_TRY_AGAIN if the value didn't match or -ERROR_TIMED_OUT.
+long futex_wait(uint32_t* address, uint32_t expected, unsigned long timeout_ns);
+
+// Wakes up to count threads waiting on address, returns the number woken up
+long futex_wake(uint32_t* address, unsigned long count);
@@ -0,0 +1,30 @@
+#include "Syscall.h"
+#include "IORing.h"
+
+#include <stddef.h>
+
+IORingHeader* io_ring_setup(unsigned long entries)
+{
+    long ret = syscall_1(SYSCALL_IO_RING_SETUP, (long)entries);
+
+    // Errors come back as small negative codes, the ring itself is never mapped that high
+    if (ret < 0 && ret > -4096)
+        return NULL;
+
+    return (IORingHeader*)ret;
+}
+
+long io_ring_enter(unsigned long to_submit, unsigned long min_completions)
+{
+    return syscall_2(SYSCALL_IO_RING_ENTER, (long)to_submit, (long)min_completions);
+}
+
+IORingSubmission* io_ring_submissions(IORingHeader* header)
+{
+    return (IORingSubmission*)((uint8_t*)header + header->submission_offset);
+}
+
+IORingCompletion* io_ring_completions(IORingHeader* header)
+{
+    return (IORingCompletion*)((uint8_t*)header + header->completion_offset);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <Shared/IORingOperations.h>
+
+enum IORingOperation {
+#define IO_RING_OPERATION(name) IO_RING_## name,
+ENUMERATE_IO_RING_OPERATIONS
+#undef IO_RING_OPERATION
+};
+
+#include <Shared/IORing.h>
+
+// Returns the ring header on success, NULL otherwise. Only one ring per process.
+IORingHeader* io_ring_setup(unsigned long entries);
+
+// Submits up to to_submit entries and waits for min_completions of them, returns the number of entries consumed
+long io_ring_enter(unsigned long to_submit, unsigned long min_completions);
+
+IORingSubmission* io_ring_submissions(IORingHeader*);
+IORingCompletion* io_ring_completions(IORingHeader*);
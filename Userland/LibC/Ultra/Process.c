@@ -1,4 +1,5 @@
 #include "Syscall.h"
+#include "Process.h"
 
 long create_process(const char* path)
 {
@@ -25,6 +26,26 @@ void sleep(long nanoseconds)
     syscall_1(SYSCALL_SLEEP, nanoseconds);
 }
 
+long set_priority(long priority_class)
+{
+    return syscall_1(SYSCALL_SET_PRIORITY, priority_class);
+}
+
+long get_affinity(long scope, long id, unsigned long long* mask)
+{
+    return syscall_3(SYSCALL_GET_AFFINITY, scope, id, (long)mask);
+}
+
+long set_affinity(long scope, long id, unsigned long long mask)
+{
+    return syscall_3(SYSCALL_SET_AFFINITY, scope, id, (long)&mask);
+}
+
+long get_cpu_times(long scope, long id, CPUTimes* times)
+{
+    return syscall_3(SYSCALL_GET_CPU_TIMES, scope, id, (long)times);
+}
+
 unsigned long ticks_since_boot()
 {
     return syscall_0(SYSCALL_TICKS);
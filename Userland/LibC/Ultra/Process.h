@@ -1,5 +1,20 @@
 #pragma once
 
+#include <Shared/CPUTimes.h>
+#include <Shared/Scheduling.h>
+
+#define PRIORITY_CLASS(name) PRIORITY_CLASS_## name,
+enum {
+    ENUMERATE_PRIORITY_CLASSES
+};
+#undef PRIORITY_CLASS
+
+#define AFFINITY_SCOPE(name) AFFINITY_SCOPE_## name,
+enum {
+    ENUMERATE_AFFINITY_SCOPES
+};
+#undef AFFINITY_SCOPE
+
 long create_process(const char* path);
 long create_thread(void* entrypoint, void* arg);
 
@@ -7,3 +22,14 @@ void exit_process(long code);
 void exit_thread(long code);
 
 void sleep(long nanoseconds);
+
+// Sets the scheduling class of all threads in the current process, REALTIME is kernel-only
+long set_priority(long priority_class);
+
+// Bit N of the mask allows running on the processor with index N.
+// An id of 0 targets the calling thread or process, only threads of the calling process can be targeted.
+long get_affinity(long scope, long id, unsigned long long* mask);
+long set_affinity(long scope, long id, unsigned long long mask);
+
+// Same targets as the affinity functions above
+long get_cpu_times(long scope, long id, CPUTimes* times);
@@ -0,0 +1,96 @@
+#include "Futex.h"
+#include "Sync.h"
+
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED 1
+#define MUTEX_CONTENDED 2
+
+#define WAKE_ALL 0x7FFFFFFF
+
+int mutex_try_lock(Mutex* mutex)
+{
+    uint32_t expected = MUTEX_UNLOCKED;
+    return __atomic_compare_exchange_n(&mutex->state, &expected, MUTEX_LOCKED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void mutex_lock(Mutex* mutex)
+{
+    if (mutex_try_lock(mutex))
+        return;
+
+    // Whoever unlocks now has to wake someone up, that might be a wasted syscall
+    // if we were the only waiter, but no wake up can ever be lost this way.
+    while (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+        futex_wait(&mutex->state, MUTEX_CONTENDED, 0);
+}
+
+void mutex_unlock(Mutex* mutex)
+{
+    if (__atomic_exchange_n(&mutex->state, MUTEX_UNLOCKED, __ATOMIC_RELEASE) == MUTEX_CONTENDED)
+        futex_wake(&mutex->state, 1);
+}
+
+void condition_variable_wait(ConditionVariable* cv, Mutex* mutex)
+{
+    // Counted before the sequence is read, a signal either sees us or bumps the sequence we're about to wait on
+    __atomic_fetch_add(&cv->waiters, 1, __ATOMIC_SEQ_CST);
+    uint32_t sequence = __atomic_load_n(&cv->sequence, __ATOMIC_SEQ_CST);
+
+    mutex_unlock(mutex);
+    futex_wait(&cv->sequence, sequence, 0);
+
+    __atomic_fetch_sub(&cv->waiters, 1, __ATOMIC_RELAXED);
+
+    // Other waiters might've been woken up together with us
+    while (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+        futex_wait(&mutex->state, MUTEX_CONTENDED, 0);
+}
+
+void condition_variable_signal(ConditionVariable* cv)
+{
+    __atomic_fetch_add(&cv->sequence, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&cv->waiters, __ATOMIC_SEQ_CST))
+        futex_wake(&cv->sequence, 1);
+}
+
+void condition_variable_broadcast(ConditionVariable* cv)
+{
+    __atomic_fetch_add(&cv->sequence, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&cv->waiters, __ATOMIC_SEQ_CST))
+        futex_wake(&cv->sequence, WAKE_ALL);
+}
+
+int semaphore_try_wait(Semaphore* semaphore)
+{
+    uint32_t count = __atomic_load_n(&semaphore->count, __ATOMIC_RELAXED);
+
+    while (count) {
+        if (__atomic_compare_exchange_n(&semaphore->count, &count, count - 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return 1;
+    }
+
+    return 0;
+}
+
+void semaphore_wait(Semaphore* semaphore)
+{
+    if (semaphore_try_wait(semaphore))
+        return;
+
+    __atomic_fetch_add(&semaphore->waiters, 1, __ATOMIC_SEQ_CST);
+
+    while (!semaphore_try_wait(semaphore))
+        futex_wait(&semaphore->count, 0, 0);
+
+    __atomic_fetch_sub(&semaphore->waiters, 1, __ATOMIC_RELAXED);
+}
+
+void semaphore_post(Semaphore* semaphore)
+{
+    __atomic_fetch_add(&semaphore->count, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&semaphore->waiters, __ATOMIC_SEQ_CST))
+        futex_wake(&semaphore->count, 1);
+}
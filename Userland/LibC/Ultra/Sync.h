@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Futex based primitives, none of them enter the kernel unless there's someone to wait for or wake up.
+// All of them are zero-initialized, except for the semaphore count.
+
+typedef struct {
+    uint32_t state; // 0 - unlocked, 1 - locked, 2 - locked and possibly contended
+} Mutex;
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_lock(Mutex*);
+int mutex_try_lock(Mutex*); // returns 1 if acquired
+void mutex_unlock(Mutex*);
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t waiters;
+} ConditionVariable;
+
+#define CONDITION_VARIABLE_INITIALIZER { 0, 0 }
+
+// The mutex must be held, it's reacquired before returning. Spurious wake ups are possible.
+void condition_variable_wait(ConditionVariable*, Mutex*);
+void condition_variable_signal(ConditionVariable*);
+void condition_variable_broadcast(ConditionVariable*);
+
+typedef struct {
+    uint32_t count;
+    uint32_t waiters;
+} Semaphore;
+
+#define SEMAPHORE_INITIALIZER(count) { count, 0 }
+
+void semaphore_wait(Semaphore*);
+int semaphore_try_wait(Semaphore*); // returns 1 if decremented
+void semaphore_post(Semaphore*);
@@ -1,39 +1,96 @@
-long syscall_0(long function)
+#include "Syscall.h"
+
+// The kernel also accepts int 0x80 with the arguments in R/EBX, R/ECX, R/EDX.
+static inline long int80_syscall(long function, long arg0, long arg1, long arg2)
 {
     long result;
     asm volatile("int $0x80"
-        : "=a"(result)
-        : "a"(function)
-        : "memory");
+                 : "=a"(result)
+                 : "a"(function), "b"(arg0), "c"(arg1), "d"(arg2)
+                 : "memory");
     return result;
 }
 
-long syscall_1(long function, long arg0)
+#ifdef ULTRA_64
+
+// SYSCALL clobbers RCX and R11, so the second argument goes in R10 instead.
+static inline long fast_syscall(long function, long arg0, long arg1, long arg2)
 {
+    register long arg1_r10 asm("r10") = arg1;
+
     long result;
-    asm volatile("int $0x80"
+    asm volatile("syscall"
                  : "=a"(result)
-                 : "a"(function), "b"(arg0)
-                 : "memory");
+                 : "a"(function), "b"(arg0), "r"(arg1_r10), "d"(arg2)
+                 : "rcx", "r11", "memory");
     return result;
 }
 
-long syscall_2(long function, long arg0, long arg1)
+static inline int has_fast_syscall(void)
+{
+    return 1;
+}
+
+#elif defined(ULTRA_32)
+
+// SYSENTER doesn't save anything, so we pass our stack pointer in ECX and the return address in EDX.
+// The second and third arguments go in ESI and EDI instead.
+static inline long fast_syscall(long function, long arg0, long arg1, long arg2)
 {
     long result;
-    asm volatile("int $0x80"
+    asm volatile("movl %%esp, %%ecx\n"
+                 "movl $1f, %%edx\n"
+                 "sysenter\n"
+                 "1:\n"
                  : "=a"(result)
-                 : "a"(function), "b"(arg0), "c"(arg1)
-                 : "memory");
+                 : "a"(function), "b"(arg0), "S"(arg1), "D"(arg2)
+                 : "ecx", "edx", "memory");
     return result;
 }
 
+static int s_has_sysenter = -1;
+
+static inline int has_fast_syscall(void)
+{
+    if (s_has_sysenter < 0) {
+        unsigned a, b, c, d;
+        asm volatile("cpuid"
+                     : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+                     : "a"(1), "c"(0));
+
+        // SEP, the kernel only enables SYSENTER if this is set
+        s_has_sysenter = (d >> 11) & 1;
+    }
+
+    return s_has_sysenter;
+}
+
+#endif
+
+static inline long do_syscall(long function, long arg0, long arg1, long arg2)
+{
+    if (has_fast_syscall())
+        return fast_syscall(function, arg0, arg1, arg2);
+
+    return int80_syscall(function, arg0, arg1, arg2);
+}
+
+long syscall_0(long function)
+{
+    return do_syscall(function, 0, 0, 0);
+}
+
+long syscall_1(long function, long arg0)
+{
+    return do_syscall(function, arg0, 0, 0);
+}
+
+long syscall_2(long function, long arg0, long arg1)
+{
+    return do_syscall(function, arg0, arg1, 0);
+}
+
 long syscall_3(long function, long arg0, long arg1, long arg2)
 {
-    long result;
-    asm volatile("int $0x80"
-                 : "=a"(result)
-                 : "a"(function), "b"(arg0), "c"(arg1), "d"(arg2)
-                 : "memory");
-    return result;
-}
\ No newline at end of file
+    return do_syscall(function, arg0, arg1, arg2);
+}
@@ -0,0 +1,23 @@
+#include "Syscall.h"
+#include "Trace.h"
+
+#define TRACE_COMMAND(name) TRACE_COMMAND_## name,
+enum {
+    ENUMERATE_TRACE_COMMANDS
+};
+#undef TRACE_COMMAND
+
+long trace_enable(void)
+{
+    return syscall_1(SYSCALL_TRACE_CONTROL, TRACE_COMMAND_ENABLE);
+}
+
+long trace_disable(void)
+{
+    return syscall_1(SYSCALL_TRACE_CONTROL, TRACE_COMMAND_DISABLE);
+}
+
+long trace_read(TraceEvent* events, unsigned long max_count)
+{
+    return syscall_3(SYSCALL_TRACE_CONTROL, TRACE_COMMAND_READ, (long)events, (long)max_count);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Shared/Trace.h>
+
+#define TRACE_EVENT_TYPE(name) TRACE_EVENT_## name,
+enum {
+    ENUMERATE_TRACE_EVENT_TYPES
+};
+#undef TRACE_EVENT_TYPE
+
+long trace_enable(void);
+long trace_disable(void);
+
+// Copies up to max_count unread events into events, returns the number copied
+long trace_read(TraceEvent* events, unsigned long max_count);
@@ -3,6 +3,10 @@
 #include "Memory.h"
 #include "Process.h"
 #include "IO.h"
+#include "IORing.h"
+#include "Futex.h"
+#include "Sync.h"
+#include "Trace.h"
 #include "VirtualKey.h"
 #include "Event.h"
 #include "Error.h"
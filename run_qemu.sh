@@ -1,6 +1,7 @@
 #!/bin/bash
 
 arch=64
+smp=${ULTRA_SMP:-4}
 
 if [ "$1" ]
   then
@@ -23,7 +24,7 @@ fi
 qemu-system-x86_64 -drive file="Images/Ultra${arch}HDD.vmdk",index=0,media=disk \
                    -debugcon stdio                                              \
                    -serial file:Ultra${arch}log.txt                             \
-                   -smp 4                                                       \
+                   -smp $smp                                                    \
                    -m 500                                                       \
                    -no-reboot                                                   \
                    -M q35                                                       \